@@ -0,0 +1,81 @@
+/// 分帧编解码的吞吐量测试: 客户端通过回环地址连续发送定长的帧，服务端解码并计数
+/// 用法: codec_benchmark [length|delimiter] [frame_size] [frame_num]
+#include <net/codec/delimiter_codec.hpp>
+#include <net/codec/length_field_codec.hpp>
+#include <net/tcp/tcp_client.hpp>
+#include <net/tcp/tcp_server.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+constexpr uint16_t kPort = 9988;
+constexpr int kBatchSize = 1024;  // 客户端每一轮发送的帧数
+
+int main(int argc, char *argv[]) {
+  bool use_delimiter = argc > 1 && std::string_view(argv[1]) == "delimiter";
+  size_t frame_size = argc > 2 ? std::stoul(argv[2]) : 128;
+  size_t frame_num = argc > 3 ? std::stoul(argv[3]) : 1000000;
+
+  using LengthCodec = net::LengthFieldCodec<uint32_t>;
+  std::chrono::steady_clock::time_point start;
+  size_t received = 0;
+  auto on_frame = [&](const net::TcpConnectionPtr &, std::string_view frame) {
+    if (frame.size() != frame_size) {
+      std::cerr << "unexpected frame size " << frame.size() << std::endl;
+      std::exit(1);
+    }
+    if (++received < frame_num) return;
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double bytes = static_cast<double>(frame_num * frame_size);
+    std::cout << (use_delimiter ? "DelimiterCodec" : "LengthFieldCodec<uint32_t>")
+              << " frame_size=" << frame_size << " frames=" << frame_num
+              << " elapsed=" << elapsed << "s "
+              << frame_num / elapsed << " frames/s "
+              << bytes / elapsed / 1024 / 1024 << " MiB/s" << std::endl;
+    std::exit(0);
+  };
+  LengthCodec length_codec(on_frame);
+  net::DelimiterCodec delimiter_codec(on_frame, "\r\n");
+
+  net::Reactor reactor;
+  net::TcpServer server(&reactor, net::InetAddress("127.0.0.1", kPort));
+  server.SetThreadNum(1);
+  server.SetMessageCallback([&](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+    if (use_delimiter) {
+      delimiter_codec.OnMessage(conn, buffer);
+    } else {
+      length_codec.OnMessage(conn, buffer);
+    }
+  });
+  server.Start();
+
+  // 客户端运行在单独的线程中，每一轮通过cork将kBatchSize个帧合并写出，写完后再发送下一轮
+  std::string payload(frame_size, 'x');
+  size_t sent = 0;
+  auto send_batch = [&](const net::TcpConnectionPtr &conn) {
+    for (int i = 0; i < kBatchSize && sent < frame_num; ++i, ++sent) {
+      if (use_delimiter) {
+        delimiter_codec.Send(conn, payload);
+      } else {
+        LengthCodec::Send(conn, payload);
+      }
+    }
+  };
+  net::ReactorPool client_pool(1);
+  client_pool.Start();
+  std::unique_ptr<net::TcpClient> client;
+  client_pool.SubmitTask([&] {
+    client = std::make_unique<net::TcpClient>(net::Reactor::GetCurrent(), net::InetAddress("127.0.0.1", kPort));
+    client->SetCork(true);
+    client->SetConnectionCallback([&](const net::TcpConnectionPtr &conn) {
+      if (conn->Connected()) {
+        start = std::chrono::steady_clock::now();
+        send_batch(conn);
+      }
+    });
+    client->SetWriteCompleteCallback(send_batch);
+    client->Connect();
+  });
+
+  reactor.Run();
+}
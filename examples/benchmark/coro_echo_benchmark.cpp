@@ -0,0 +1,78 @@
+/// 回调接口与协程接口的echo服务端吞吐量对比: 客户端通过回环地址在多个连接上进行pingpong
+/// 用法: coro_echo_benchmark [callback|coro] [message_size] [connection_num] [round_num]
+#include <net/coro/connection.hpp>
+#include <net/tcp/tcp_client.hpp>
+#include <net/tcp/tcp_server.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+constexpr uint16_t kPort = 9990;
+
+net::coro::Task<> Echo(net::coro::Connection conn) {
+  while (true) {
+    std::string_view data = co_await conn.Read();
+    if (data.empty()) break;
+    if (!co_await conn.Write(data)) break;
+    conn.Consume(data.size());
+  }
+}
+
+int main(int argc, char *argv[]) {
+  bool use_coro = argc > 1 && std::string_view(argv[1]) == "coro";
+  size_t message_size = argc > 2 ? std::stoul(argv[2]) : 4096;
+  int connection_num = argc > 3 ? std::stoi(argv[3]) : 16;
+  size_t round_num = argc > 4 ? std::stoul(argv[4]) : 100000;  // 每个连接的往返次数
+
+  net::Reactor reactor;
+  net::TcpServer server(&reactor, net::InetAddress("127.0.0.1", kPort));
+  server.SetThreadNum(1);
+  if (use_coro) {
+    server.SetConnectionCallback(net::coro::MakeConnectionCallback(Echo));
+  } else {
+    server.SetMessageCallback([](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+      conn->Send(buffer->GetReadPtr(), buffer->ReadableBytes());
+      buffer->Reset();
+    });
+  }
+  server.Start();
+
+  // 客户端运行在单独的线程中，每个连接收到完整的一条消息后再发送下一条
+  std::string message(message_size, 'x');
+  std::chrono::steady_clock::time_point start;
+  int finished = 0;
+  net::ReactorPool client_pool(1);
+  client_pool.Start();
+  std::vector<std::unique_ptr<net::TcpClient>> clients;
+  std::vector<size_t> rounds(connection_num, 0);
+  client_pool.SubmitTask([&] {
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < connection_num; ++i) {
+      auto client = std::make_unique<net::TcpClient>(net::Reactor::GetCurrent(), net::InetAddress("127.0.0.1", kPort));
+      client->SetConnectionCallback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected()) conn->Send(message);
+      });
+      client->SetMessageCallback([&, i](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+        if (buffer->ReadableBytes() < message_size) return;
+        buffer->HasRead(message_size);
+        if (++rounds[i] < round_num) {
+          conn->Send(message);
+          return;
+        }
+        if (++finished < connection_num) return;
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double messages = static_cast<double>(round_num) * connection_num;
+        std::cout << (use_coro ? "coroutine" : "callback")
+                  << " message_size=" << message_size << " connections=" << connection_num
+                  << " elapsed=" << elapsed << "s "
+                  << messages / elapsed << " round trips/s "
+                  << messages * static_cast<double>(message_size) / elapsed / 1024 / 1024 << " MiB/s" << std::endl;
+        std::exit(0);
+      });
+      client->Connect();
+      clients.push_back(std::move(client));
+    }
+  });
+
+  reactor.Run();
+}
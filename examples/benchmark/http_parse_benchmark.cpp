@@ -0,0 +1,103 @@
+/// HTTP请求解析的分配次数与耗时测试: 对比基于std::string/std::map的拷贝式解析与零拷贝的HttpRequestParser
+/// 用法: http_parse_benchmark [request_num]
+#include <net/http/http_parser.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+
+static size_t g_alloc_count = 0;
+
+void *operator new(size_t size) {
+  ++g_alloc_count;
+  if (void *p = std::malloc(size)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+const std::string kRequest =
+    "GET /api/v1/users/12345/profile?fields=name,email&lang=zh-CN HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session_id=0123456789abcdef; theme=dark\r\n"
+    "Referer: https://www.example.com/users/12345\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "\r\n";
+
+/// 改造前HttpRequest的存储方式: 每个字段都复制到独立的std::string中
+struct LegacyRequest {
+  std::string method;
+  std::string url;
+  std::string version;
+  std::map<std::string, std::string> headers;
+};
+
+bool LegacyParse(const net::BufferPtr &buffer, LegacyRequest &request) {
+  std::string_view data(buffer->GetReadPtr(), buffer->ReadableBytes());
+  size_t end = data.find("\r\n");
+  std::string line(data.substr(0, end));  // 改造前按行取出std::string再切分
+  size_t sp1 = line.find(' ');
+  size_t sp2 = line.rfind(' ');
+  if (sp1 == std::string::npos || sp1 == sp2) return false;
+  request.method = line.substr(0, sp1);
+  request.url = line.substr(sp1 + 1, sp2 - sp1 - 1);
+  request.version = line.substr(sp2 + 1);
+  size_t begin = end + 2;
+  while ((end = data.find("\r\n", begin)) != begin) {
+    line = std::string(data.substr(begin, end - begin));
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) return false;
+    size_t value_begin = line.find_first_not_of(' ', colon + 1);
+    request.headers[line.substr(0, colon)] = line.substr(value_begin);
+    begin = end + 2;
+  }
+  buffer->HasRead(end + 2);
+  return true;
+}
+
+template<typename F>
+void Run(const char *name, size_t request_num, F &&parse_one) {
+  // 预热一次，使可复用的状态(例如buffer、arena)已经分配好
+  parse_one();
+  size_t alloc_before = g_alloc_count;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < request_num; ++i) {
+    parse_one();
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << ": "
+            << static_cast<double>(g_alloc_count - alloc_before) / static_cast<double>(request_num)
+            << " allocs/request " << elapsed / static_cast<double>(request_num) << " ns/request" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t request_num = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  auto buffer = std::make_shared<net::Buffer>(kRequest.size());
+
+  Run("legacy std::string/std::map", request_num, [&] {
+    buffer->Append(kRequest);
+    LegacyRequest request;
+    if (!LegacyParse(buffer, request)) std::exit(1);
+  });
+
+  net::HttpRequestParser parser;
+  Run("zero-copy HttpRequestParser", request_num, [&] {
+    buffer->Append(kRequest);
+    if (parser.Parse(buffer) != net::HttpParseResult::Complete) std::exit(1);
+    buffer->HasRead(parser.GetHeaderSize());
+    parser.Reset();
+  });
+  return 0;
+}
@@ -0,0 +1,81 @@
+/// HTTP应答序列化的分配次数与耗时测试: 对比改造前逐字段拼接到新字符串的方式与直接序列化到复用的输出缓冲区
+/// 用法: http_reply_benchmark [reply_num]
+#include <net/http/http_reply.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+
+static size_t g_alloc_count = 0;
+
+void *operator new(size_t size) {
+  ++g_alloc_count;
+  if (void *p = std::malloc(size)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+/// 改造前的序列化方式: std::map保存头部，每次都查表得到版本与状态的字符串并调用std::to_string
+std::string LegacySerialize(net::HttpVersion version, net::HttpStatusCode status_code,
+                            std::map<std::string, std::string> &headers, const std::string &content) {
+  headers[net::kContentLengthField] = std::to_string(content.size());
+  std::string str;
+  str.append(net::ToString(version));
+  str.append(" ");
+  str.append(std::to_string(static_cast<int>(status_code)));
+  str.append(" ");
+  str.append(net::ToString(status_code));
+  str.append(net::kCRLF);
+  for (auto &[key, value]: headers) {
+    str.append(key);
+    str.append(": ");
+    str.append(value);
+    str.append(net::kCRLF);
+  }
+  str.append(net::kCRLF);
+  str.append(content);
+  return str;
+}
+
+template<typename F>
+void Run(const char *name, size_t reply_num, F &&serialize_one) {
+  // 预热一次，使可复用的状态(例如输出缓冲区)已经分配好
+  serialize_one();
+  size_t alloc_before = g_alloc_count;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < reply_num; ++i) {
+    serialize_one();
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << ": "
+            << static_cast<double>(g_alloc_count - alloc_before) / static_cast<double>(reply_num)
+            << " allocs/reply " << elapsed / static_cast<double>(reply_num) << " ns/reply" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t reply_num = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  std::string output;  // 模拟HttpServer中每个连接复用的输出缓冲区
+
+  Run("legacy", reply_num, [&] {
+    std::map<std::string, std::string> headers;
+    output += LegacySerialize(net::HttpVersion::Http11, net::HttpStatusCode::k200Ok, headers, "Hello, world");
+    output.clear();
+  });
+
+  Run("cached status line + SerializeTo", reply_num, [&] {
+    net::HttpReply reply;
+    reply.SetVersion(net::HttpVersion::Http11);
+    reply.SetStatusCode(net::HttpStatusCode::k200Ok);
+    reply.SetContent("Hello, world");
+    reply.SerializeTo(output);
+    output.clear();
+  });
+  return 0;
+}
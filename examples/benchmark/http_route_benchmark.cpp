@@ -0,0 +1,94 @@
+/// 路由查找的耗时测试: 对比改造前的精确匹配+逐个前缀匹配与基于压缩前缀树的HttpRoute
+/// 注册1000个路由，其中一半是静态路由，一半包含路径参数
+/// 用法: http_route_benchmark [lookup_num]
+#include <net/http/http_route.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+constexpr int kRouteNum = 1000;
+
+/// 改造前的HttpRoute: 先精确匹配，失败后逐个路由检查前缀，不支持路径参数
+class LegacyRoute {
+ public:
+  void RegisterHandler(const std::string &path, const net::HttpHandler::HandleFunction &handle_function) {
+    path_to_handle_function_[path].handle = handle_function;
+  }
+
+  net::HttpHandler *GetHandler(std::string_view path_view) {
+    std::string path(path_view);
+    auto pos = path_to_handle_function_.find(path);
+    if (pos != path_to_handle_function_.end()) {
+      return &(pos->second);
+    }
+    for (auto &[p, h]: path_to_handle_function_) {
+      if (net::HasPrefix(path, p) ||
+          net::HasPrefix(path + '/', p)) {
+        return &h;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  std::unordered_map<std::string, net::HttpHandler> path_to_handle_function_;
+};
+
+void Handle(const net::HttpRequest &, net::HttpReply &) {}
+
+template<typename F>
+void Run(const char *name, size_t lookup_num, const std::vector<std::string> &paths, F &&lookup) {
+  size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < lookup_num; ++i) {
+    found += lookup(paths[i % paths.size()]) != nullptr;
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << ": " << elapsed / static_cast<double>(lookup_num) << " ns/lookup, "
+            << found << "/" << lookup_num << " found" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  size_t lookup_num = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  // 静态路由: /api/v{i%10}/static{i}/items，参数路由: /api/v{i%10}/users{i}/:id/posts
+  LegacyRoute legacy_route;
+  net::HttpRoute route;
+  std::vector<std::string> static_paths;
+  std::vector<std::string> param_paths;
+  for (int i = 0; i < kRouteNum / 2; ++i) {
+    std::string version = "/api/v" + std::to_string(i % 10);
+    std::string static_path = version + "/static" + std::to_string(i) + "/items";
+    legacy_route.RegisterHandler(static_path, Handle);
+    route.RegisterHandler(static_path, Handle);
+    static_paths.push_back(static_path);
+
+    // 改造前不支持参数，只能注册前缀，由处理函数自行解析剩余的部分
+    std::string user_prefix = version + "/users" + std::to_string(i) + "/";
+    legacy_route.RegisterHandler(user_prefix, Handle);
+    route.RegisterHandler(net::HttpMethod::Get, user_prefix + ":id/posts", Handle);
+    param_paths.push_back(user_prefix + std::to_string(i * 31) + "/posts");
+  }
+
+  Run("legacy static", lookup_num, static_paths, [&](const std::string &path) {
+    return legacy_route.GetHandler(path);
+  });
+  Run("radix static", lookup_num, static_paths, [&](const std::string &path) {
+    return route.GetHandler(net::HttpMethod::Get, path);
+  });
+
+  Run("legacy prefix", lookup_num / 100, param_paths, [&](const std::string &path) {
+    return legacy_route.GetHandler(path);
+  });
+  net::HttpRoute::PathParams params;
+  Run("radix param", lookup_num, param_paths, [&](const std::string &path) {
+    params.clear();
+    return route.GetHandler(net::HttpMethod::Get, path, &params);
+  });
+  return 0;
+}
@@ -0,0 +1,82 @@
+/// RPC的本地回环测试: 客户端在一个连接上保持pipeline_depth个未完成的调用，统计每秒调用数和延迟分位数
+/// 用法: rpc_benchmark [call_num] [pipeline_depth] [request_size]
+#include <net/rpc/rpc_channel.hpp>
+#include <net/rpc/rpc_server.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+constexpr uint16_t kPort = 9989;
+constexpr uint32_t kEchoMethod = 1;
+
+int main(int argc, char *argv[]) {
+  size_t call_num = argc > 1 ? std::stoul(argv[1]) : 200000;
+  size_t pipeline_depth = argc > 2 ? std::stoul(argv[2]) : 64;
+  size_t request_size = argc > 3 ? std::stoul(argv[3]) : 64;
+
+  net::Reactor reactor;
+  net::RpcServer server(&reactor, net::InetAddress("127.0.0.1", kPort));
+  server.SetThreadNum(1);
+  server.SetCork(true);
+  server.RegisterMethod(kEchoMethod, [](std::string_view request, net::RpcResponder responder) {
+    responder.Reply(request);
+  });
+  server.Start();
+
+  using Clock = std::chrono::steady_clock;
+  std::string request(request_size, 'x');
+  std::vector<double> latency_vec;  // 单位为微秒
+  latency_vec.reserve(call_num);
+  size_t sent = 0;
+  Clock::time_point start;
+  std::unique_ptr<net::RpcClient> client;
+
+  auto report = [&] {
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::sort(latency_vec.begin(), latency_vec.end());
+    auto percentile = [&](double p) {
+      return latency_vec[std::min(latency_vec.size() - 1, static_cast<size_t>(p * latency_vec.size()))];
+    };
+    std::cout << "calls=" << call_num << " pipeline_depth=" << pipeline_depth
+              << " request_size=" << request_size << " elapsed=" << elapsed << "s "
+              << call_num / elapsed << " calls/s" << std::endl
+              << "latency(us) p50=" << percentile(0.5) << " p90=" << percentile(0.9)
+              << " p99=" << percentile(0.99) << " p999=" << percentile(0.999)
+              << " max=" << latency_vec.back() << std::endl;
+    std::exit(0);
+  };
+  // 每完成一个调用就发起下一个，使未完成的调用数保持在pipeline_depth
+  std::function<void()> call_next = [&] {
+    if (sent == call_num) return;
+    ++sent;
+    client->Call(kEchoMethod, request, [&, begin = Clock::now()](net::RpcStatus status, std::string_view) {
+      if (status != net::RpcStatus::Ok) {
+        std::cerr << "call failed: " << net::ToString(status) << std::endl;
+        std::exit(1);
+      }
+      latency_vec.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+      if (latency_vec.size() == call_num) {
+        report();
+      }
+      call_next();
+    });
+  };
+
+  net::ReactorPool client_pool(1);
+  client_pool.Start();
+  client_pool.SubmitTask([&] {
+    client = std::make_unique<net::RpcClient>(net::Reactor::GetCurrent(), net::InetAddress("127.0.0.1", kPort));
+    client->SetCork(true);
+    client->SetConnectionCallback([&](const net::TcpConnectionPtr &conn) {
+      if (!conn->Connected()) return;
+      start = Clock::now();
+      for (size_t i = 0; i < pipeline_depth; ++i) {
+        call_next();
+      }
+    });
+    client->Connect();
+  });
+
+  reactor.Run();
+}
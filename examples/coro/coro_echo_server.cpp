@@ -0,0 +1,22 @@
+#include <net/coro/connection.hpp>
+#include <net/tcp/tcp_server.hpp>
+
+/// 每个连接对应一个协程，读到什么就写回什么，对端关闭时Read返回空
+net::coro::Task<> Echo(net::coro::Connection conn) {
+  while (true) {
+    std::string_view data = co_await conn.Read();
+    if (data.empty()) break;
+    if (!co_await conn.Write(data)) break;
+    conn.Consume(data.size());
+  }
+}
+
+int main() {
+  net::Reactor reactor;
+  net::InetAddress listen_addr(9987);
+  net::TcpServer server(&reactor, listen_addr);
+  server.SetThreadNum(1);
+  server.SetConnectionCallback(net::coro::MakeConnectionCallback(Echo));
+  server.Start();
+  reactor.Run();
+}
@@ -0,0 +1,41 @@
+#include <net/coro/connection.hpp>
+#include <net/http/http_parser.hpp>
+#include <net/tcp/tcp_server.hpp>
+
+net::coro::Task<> HandleHttp(net::coro::Connection conn) {
+  net::HttpRequestParser parser;  // 解析状态保存在协程帧中，请求被拆分到多次读取时继续解析
+  while (true) {
+    std::string_view data = co_await conn.Read();
+    if (data.empty()) break;
+    // 一次读取中可能包含多个流水线请求，应答按顺序拼接后一次写出
+    std::string output;
+    net::HttpParseResult result;
+    while ((result = parser.Parse(conn.GetInputBuffer())) == net::HttpParseResult::Complete) {
+      net::HttpReply reply;
+      reply.SetVersion(net::HttpVersion::Http11);
+      reply.SetStatusCode(net::HttpStatusCode::k200Ok);
+      reply.SetContent("Hello, world");
+      reply.SerializeTo(output);
+      conn.Consume(parser.GetRequestSize());  // 请求中的string_view随之失效
+      parser.Reset();
+    }
+    if (result == net::HttpParseResult::Error) {
+      net::HttpReply reply;
+      reply.SetVersion(net::HttpVersion::Http11);
+      reply.SetStatusCode(net::HttpStatusCode::k400BadRequest);
+      reply.SerializeTo(output);
+    }
+    if (!output.empty() && !co_await conn.Write(output)) break;
+    if (result == net::HttpParseResult::Error) break;  // 协程结束时关闭连接
+  }
+}
+
+int main() {
+  net::Reactor reactor;
+  net::InetAddress listen_addr(9987);
+  net::TcpServer server(&reactor, listen_addr);
+  server.SetThreadNum(8);
+  server.SetConnectionCallback(net::coro::MakeConnectionCallback(HandleHttp));
+  server.Start();
+  reactor.Run();
+}
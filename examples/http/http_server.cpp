@@ -1,5 +1,7 @@
 #include <net/http/http_server.hpp>
 
+#include <thread>
+
 void HandleRoot(const net::HttpRequest &request, net::HttpReply &reply) {
   reply.SetContent("Hello, world");
 }
@@ -12,14 +14,56 @@ void HandleB(const net::HttpRequest &request, net::HttpReply &reply) {
   reply.SetContent("B");
 }
 
+/// 以流的方式接收上传的数据，只统计长度，不需要缓存整个请求体
+net::HttpBodyReader HandleUpload(const net::HttpRequest &request) {
+  auto size = std::make_shared<size_t>(0);
+  return {
+      [size](std::string_view data) { *size += data.size(); },
+      [size](const net::HttpRequest &request, net::HttpReply &reply) {
+        reply.SetContent(std::to_string(*size));
+      }};
+}
+
+/// 以chunked编码流式生成一个较大的应答，输出缓冲区拥塞时暂停生产，回落后继续
+void HandleReport(const net::HttpRequest &request, net::HttpReply &reply) {
+  reply.SetContentType("text/csv");
+  auto writer = reply.BeginChunked();
+  auto line = std::make_shared<int64_t>(0);
+  auto pump = std::make_shared<std::function<void()>>();
+  *pump = [writer, line, weak_pump = std::weak_ptr(pump)] {
+    while (*line < 100000) {
+      std::string row = std::to_string(*line) + "," + std::to_string(*line * *line) + "\n";
+      ++*line;
+      if (!writer->WriteChunk(row)) {
+        if (!writer->Connected()) return;
+        writer->SetWritableCallback([pump = weak_pump.lock()] { (*pump)(); });
+        return;
+      }
+    }
+    writer->End();
+  };
+  (*pump)();
+}
+
+/// 模拟阻塞的查询，在线程池中执行，不影响同一Reactor上的其他连接
+void HandleQuery(const net::HttpRequest &request, net::HttpReply &reply) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  reply.SetContent("result");
+}
+
 int main() {
   net::Reactor reactor;
   net::InetAddress listen_addr(9987);
+  net::ThreadPool worker_pool(4);
+  worker_pool.Start();
   net::HttpServer http_server(&reactor, listen_addr);
   http_server.SetThreadNum(8);
   http_server.Handle("/", HandleRoot);
   http_server.Handle("/a", HandleA);
   http_server.Handle("/b", HandleB);
+  http_server.HandleStream("/upload", HandleUpload);
+  http_server.Handle("/report", HandleReport);
+  http_server.Handle(net::HttpMethod::Get, "/query", HandleQuery, &worker_pool);
   http_server.Start();
   reactor.Run();
 }
@@ -6,7 +6,9 @@ int main() {
   net::InetAddress listen_addr(9987);
   net::HttpServer http_server(&reactor, listen_addr);
   http_server.SetThreadNum(8);
-  http_server.Handle("/static/", net::HttpFileServer(".", "/static"));
+  net::HttpFileServer file_server(".", "/static");
+  file_server.SetCacheControl("/static/", "no-cache");   // 每次都重新验证，未修改时返回304
+  http_server.Handle("/static/", file_server);
   http_server.Start();
   reactor.Run();
 }
@@ -40,11 +40,19 @@ class Buffer : public noncopyable {
   [[nodiscard]] size_t ReadableBytes() const { return write_pos_ - read_pos_; };
   [[nodiscard]] size_t WritableBytes() const { return buffer_.size() - write_pos_; }
   [[nodiscard]] const char *GetReadPtr() const { return buffer_.data() + read_pos_; }
+  [[nodiscard]] char *GetReadPtr() { return buffer_.data() + read_pos_; }
   [[nodiscard]] const char *GetWritePtr() const { return buffer_.data() + write_pos_; }
   [[nodiscard]] char *GetWritePtr() { return buffer_.data() + write_pos_; }
 
   void EnsureWritableBytes(size_t n) {
-    if (WritableBytes() < n) {
+    if (WritableBytes() >= n) return;
+    if (read_pos_ > 0 && read_pos_ + WritableBytes() >= n) {
+      // 前面已读取部分的空间足够，将未读取的数据移动到开头，避免缓冲区无限增长
+      size_t readable = ReadableBytes();
+      std::copy(buffer_.begin() + read_pos_, buffer_.begin() + write_pos_, buffer_.begin());
+      read_pos_ = 0;
+      write_pos_ = readable;
+    } else {
       Resize(write_pos_ + n);
     }
   }
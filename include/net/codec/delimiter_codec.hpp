@@ -0,0 +1,69 @@
+#ifndef NET_INCLUDE_NET_CODEC_DELIMITER_CODEC_HPP_
+#define NET_INCLUDE_NET_CODEC_DELIMITER_CODEC_HPP_
+
+#include "net/tcp/tcp_connection.hpp"
+
+namespace net {
+
+/// 分隔符分帧: 每一帧以分隔符结尾(例如按行分帧的文本协议)，交给回调的帧不包含分隔符
+class DelimiterCodec : noncopyable {
+ public:
+  static constexpr size_t kDefaultMaxFrameSize = 64 * 1024;
+
+  /// 第二个参数为一帧(不包含分隔符)的视图，只在回调期间有效
+  using FrameCallback = std::function<void(const TcpConnectionPtr &, std::string_view)>;
+
+  /// @param max_frame_size 一帧的最大长度，超过该长度仍然没有找到分隔符时将直接断开连接
+  explicit DelimiterCodec(FrameCallback cb,
+                          std::string delimiter = "\r\n",
+                          size_t max_frame_size = kDefaultMaxFrameSize)
+      : frame_callback_(std::move(cb)),
+        delimiter_(std::move(delimiter)),
+        max_frame_size_(max_frame_size) {
+    NET_ASSERT(!delimiter_.empty());
+  }
+
+  /// 作为TcpServer/TcpClient的MessageCallback，一次处理输入缓冲区中所有完整的帧
+  void OnMessage(const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+    while (conn->Connected()) {
+      std::string_view readable(buffer->GetReadPtr(), buffer->ReadableBytes());
+      size_t pos = readable.find(delimiter_);
+      if (pos == std::string_view::npos) {
+        if (readable.size() > max_frame_size_ + delimiter_.size()) {
+          LOG_ERROR("frame size exceeds limit {}, force close", max_frame_size_);
+          buffer->Reset();
+          conn->ForceClose();
+          return;
+        }
+        break;
+      }
+      if (pos > max_frame_size_) {
+        LOG_ERROR("frame size {} exceeds limit {}, force close", pos, max_frame_size_);
+        buffer->Reset();
+        conn->ForceClose();
+        return;
+      }
+      buffer->HasRead(pos + delimiter_.size());
+      // 回调期间不会再向输入缓冲区中写入数据，因此帧指向的数据一直有效
+      frame_callback_(conn, readable.substr(0, pos));
+    }
+    if (buffer->ReadableBytes() == 0) {
+      buffer->Reset();
+    }
+  }
+
+  /// 在帧的末尾添加分隔符后发送，帧和分隔符通过一次writev写出，不需要拼接
+  /// @note 线程安全
+  void Send(const TcpConnectionPtr &conn, std::string_view frame) const {
+    conn->Send({frame, delimiter_});
+  }
+
+ private:
+  FrameCallback frame_callback_;
+  std::string delimiter_;
+  size_t max_frame_size_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_CODEC_DELIMITER_CODEC_HPP_
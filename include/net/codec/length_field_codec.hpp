@@ -0,0 +1,97 @@
+#ifndef NET_INCLUDE_NET_CODEC_LENGTH_FIELD_CODEC_HPP_
+#define NET_INCLUDE_NET_CODEC_LENGTH_FIELD_CODEC_HPP_
+
+#include "net/tcp/tcp_connection.hpp"
+
+#include <limits>
+#include <type_traits>
+
+namespace net {
+
+/// 长度字段的字节序
+enum class Endian {
+  Big,      ///< 网络字节序
+  Little,
+};
+
+/// 长度前缀分帧: 每一帧由固定长度的长度字段和紧随其后的消息体组成，长度字段的值为消息体的长度
+/// @tparam LengthType 长度字段的类型，uint8_t/uint16_t/uint32_t/uint64_t
+/// @tparam endian 长度字段的字节序
+template<typename LengthType, Endian endian = Endian::Big>
+class LengthFieldCodec : noncopyable {
+  static_assert(std::is_unsigned_v<LengthType>, "LengthType must be an unsigned integer");
+
+ public:
+  static constexpr size_t kHeaderSize = sizeof(LengthType);
+  static constexpr size_t kDefaultMaxFrameSize = std::min<uint64_t>(std::numeric_limits<LengthType>::max(),
+                                                                    64 * 1024 * 1024);
+
+  /// 第二个参数为一帧消息体的视图，只在回调期间有效
+  using FrameCallback = std::function<void(const TcpConnectionPtr &, std::string_view)>;
+
+  /// @param max_frame_size 消息体的最大长度，收到超过该长度的帧时将直接断开连接
+  explicit LengthFieldCodec(FrameCallback cb, size_t max_frame_size = kDefaultMaxFrameSize)
+      : frame_callback_(std::move(cb)),
+        max_frame_size_(max_frame_size) {}
+
+  /// 作为TcpServer/TcpClient的MessageCallback，一次处理输入缓冲区中所有完整的帧
+  void OnMessage(const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+    while (buffer->ReadableBytes() >= kHeaderSize && conn->Connected()) {
+      uint64_t len = DecodeLength(buffer->GetReadPtr());
+      if (len > max_frame_size_) {
+        LOG_ERROR("frame size {} exceeds limit {}, force close", len, max_frame_size_);
+        buffer->Reset();
+        conn->ForceClose();
+        return;
+      }
+      if (buffer->ReadableBytes() < kHeaderSize + len) break;
+      const char *frame = buffer->GetReadPtr() + kHeaderSize;
+      buffer->HasRead(kHeaderSize + len);
+      // 回调期间不会再向输入缓冲区中写入数据，因此frame指向的数据一直有效
+      frame_callback_(conn, std::string_view(frame, len));
+    }
+    if (buffer->ReadableBytes() == 0) {
+      buffer->Reset();
+    }
+  }
+
+  /// 添加长度字段后发送一帧，长度字段和消息体通过一次writev写出，不需要拼接
+  /// @note 线程安全
+  static void Send(const TcpConnectionPtr &conn, std::string_view payload) {
+    NET_ASSERT(payload.size() <= std::numeric_limits<LengthType>::max());
+    char header[kHeaderSize];
+    EncodeLength(payload.size(), header);
+    conn->Send({std::string_view(header, kHeaderSize), payload});
+  }
+  /// 将两段数据(例如上层协议的头部和消息体)作为一帧的消息体发送
+  /// @note 线程安全
+  static void Send(const TcpConnectionPtr &conn, std::string_view first, std::string_view second) {
+    NET_ASSERT(first.size() + second.size() <= std::numeric_limits<LengthType>::max());
+    char header[kHeaderSize];
+    EncodeLength(first.size() + second.size(), header);
+    conn->Send({std::string_view(header, kHeaderSize), first, second});
+  }
+
+  static void EncodeLength(uint64_t len, char *header) {
+    for (size_t i = 0; i < kHeaderSize; ++i) {
+      size_t shift = endian == Endian::Big ? (kHeaderSize - 1 - i) * 8 : i * 8;
+      header[i] = static_cast<char>((len >> shift) & 0xff);
+    }
+  }
+  static uint64_t DecodeLength(const char *header) {
+    uint64_t len = 0;
+    for (size_t i = 0; i < kHeaderSize; ++i) {
+      size_t shift = endian == Endian::Big ? (kHeaderSize - 1 - i) * 8 : i * 8;
+      len |= static_cast<uint64_t>(static_cast<uint8_t>(header[i])) << shift;
+    }
+    return len;
+  }
+
+ private:
+  FrameCallback frame_callback_;
+  size_t max_frame_size_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_CODEC_LENGTH_FIELD_CODEC_HPP_
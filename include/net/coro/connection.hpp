@@ -0,0 +1,286 @@
+#ifndef NET_INCLUDE_NET_CORO_CONNECTION_HPP_
+#define NET_INCLUDE_NET_CORO_CONNECTION_HPP_
+
+#include "net/coro/task.hpp"
+#include "net/socket_options.hpp"
+#include "net/tcp/tcp_connection.hpp"
+
+namespace net::coro {
+
+namespace detail {
+
+/// 协程化连接的状态，由Connection以及安装到TcpConnection上的回调共同持有(同时作为TcpConnection的上下文)
+struct ConnectionState {
+  BufferPtr input;
+  size_t write_limit = 0;
+  bool has_new_data = false;        ///< 上一次Read之后是否收到了新的数据
+  bool closed = false;
+  bool detached = false;            ///< Connection已经析构，之后收到的数据直接丢弃
+  std::coroutine_handle<> reader;   ///< 等待Read的协程
+  std::coroutine_handle<> writer;   ///< 等待Write的协程
+};
+
+} // namespace net::coro::detail
+
+/// TcpConnection的协程接口，co_await的结果总是在连接所属的Reactor线程中返回
+///
+/// 构造时会接管TcpConnection的MessageCallback以及高低水位线回调；连接断开的通知需要通过
+/// ConnectionCallback转发给Connection::OnConnection(MakeConnectionCallback和Connect会自动设置)。
+/// 协程不在Read中等待时，收到数据后会暂停读取socket，由TCP流量控制形成背压
+/// @note 只能在连接所属的Reactor线程中使用，析构时会关闭连接(等待输出缓冲区中的数据发送完毕)
+class Connection : noncopyable {
+  class ReadAwaiter;
+  class WriteAwaiter;
+
+ public:
+  /// 输出缓冲区中待发送的数据超过该值时，Write将等待积压的数据回落后再返回
+  static constexpr size_t kDefaultWriteLimit = 64 * 1024;
+
+  Connection() = default;
+  explicit Connection(const TcpConnectionPtr &conn)
+      : conn_(conn),
+        state_(std::make_shared<detail::ConnectionState>()) {
+    conn_->SetContext(state_);
+    conn_->SetMessageCallback([state = state_](const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+      state->input = buffer;
+      if (state->detached) {
+        buffer->Reset();
+        return;
+      }
+      state->has_new_data = true;
+      if (state->reader) {
+        std::exchange(state->reader, nullptr).resume();
+      } else {
+        conn->PauseReading();
+      }
+    });
+    SetWriteLimit(kDefaultWriteLimit);
+  }
+  Connection(Connection &&other) noexcept
+      : conn_(std::move(other.conn_)),
+        state_(std::move(other.state_)) {}
+  Connection &operator=(Connection &&other) noexcept {
+    if (this != &other) {
+      Detach();
+      conn_ = std::move(other.conn_);
+      state_ = std::move(other.state_);
+    }
+    return *this;
+  }
+  ~Connection() { Detach(); }
+
+  /// 作为TcpConnection的ConnectionCallback(或在其中调用)，连接断开时唤醒等待中的协程
+  static void OnConnection(const TcpConnectionPtr &conn) {
+    if (conn->Connected()) return;
+    auto state = std::static_pointer_cast<detail::ConnectionState>(conn->GetContext());
+    if (!state || state->closed) return;
+    state->closed = true;
+    // 读写可能由两个协程分别等待，先取出再依次恢复
+    auto reader = std::exchange(state->reader, nullptr);
+    auto writer = std::exchange(state->writer, nullptr);
+    if (reader) reader.resume();
+    if (writer) writer.resume();
+  }
+
+  /// 等待新的数据
+  /// @return 输入缓冲区中所有未消费的数据，连接关闭并且没有新数据时返回空
+  /// @note 返回的数据在调用Consume之前会一直保留在输入缓冲区中，下一次Read会在其后追加新的数据
+  ReadAwaiter Read() {
+    if (!state_->closed && !conn_->IsReading()) {
+      conn_->ResumeReading();
+    }
+    return ReadAwaiter(state_.get());
+  }
+  /// 从输入缓冲区中消费n个字节
+  void Consume(size_t n) {
+    state_->input->HasRead(n);
+    if (state_->input->ReadableBytes() == 0) {
+      state_->input->Reset();
+    }
+  }
+  /// @return 连接的输入缓冲区，可以直接交给解析器使用，在第一次Read返回数据之前为nullptr
+  [[nodiscard]] const BufferPtr &GetInputBuffer() const { return state_->input; }
+
+  /// 发送数据，输出缓冲区中积压的数据超过write_limit时等待其回落到write_limit
+  /// @return 连接是否仍然有效
+  WriteAwaiter Write(std::string_view data) {
+    if (!state_->closed) {
+      conn_->Send(data);
+    }
+    return WriteAwaiter(conn_.get(), state_.get());
+  }
+  /// 将多段数据连续地发送，参见TcpConnection::Send
+  WriteAwaiter Write(std::initializer_list<std::string_view> pieces) {
+    if (!state_->closed) {
+      conn_->Send(pieces);
+    }
+    return WriteAwaiter(conn_.get(), state_.get());
+  }
+  /// 通过高低水位线实现: 积压超过limit时越过高水位线，回落到limit时由LowWaterMarkCallback唤醒等待的协程，
+  /// 因此只有在积压时才有额外的开销
+  void SetWriteLimit(size_t limit) {
+    state_->write_limit = limit;
+    conn_->SetHighWaterMarkCallback(nullptr, limit + 1);
+    conn_->SetLowWaterMarkCallback([state = state_](const TcpConnectionPtr &, size_t) {
+      if (state->writer) {
+        std::exchange(state->writer, nullptr).resume();
+      }
+    }, limit);
+  }
+
+  /// 关闭连接的写方向，输出缓冲区中的数据发送完毕后生效
+  void Shutdown() { conn_->Shutdown(); }
+
+  [[nodiscard]] bool Connected() const { return conn_ && !state_->closed && conn_->Connected(); }
+  [[nodiscard]] const TcpConnectionPtr &GetConnection() const { return conn_; }
+  explicit operator bool() const { return static_cast<bool>(conn_); }
+
+ private:
+  class [[nodiscard]] ReadAwaiter {
+   public:
+    explicit ReadAwaiter(detail::ConnectionState *state) : state_(state) {}
+
+    bool await_ready() const noexcept { return state_->has_new_data || state_->closed; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { state_->reader = handle; }
+    std::string_view await_resume() noexcept {
+      if (!state_->has_new_data) return {};
+      state_->has_new_data = false;
+      return {state_->input->GetReadPtr(), state_->input->ReadableBytes()};
+    }
+
+   private:
+    detail::ConnectionState *state_;
+  };
+
+  class [[nodiscard]] WriteAwaiter {
+   public:
+    WriteAwaiter(TcpConnection *conn, detail::ConnectionState *state) : conn_(conn), state_(state) {}
+
+    bool await_ready() const noexcept {
+      return state_->closed || !conn_->Connected() || conn_->GetPendingOutputBytes() <= state_->write_limit;
+    }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { state_->writer = handle; }
+    bool await_resume() const noexcept { return !state_->closed && conn_->Connected(); }
+
+   private:
+    TcpConnection *conn_;
+    detail::ConnectionState *state_;
+  };
+
+  /// 不再使用该连接: 之后收到的数据直接丢弃(继续读取以便感知对端关闭)，并关闭写方向
+  void Detach() {
+    if (!conn_) return;
+    state_->detached = true;
+    state_->reader = nullptr;
+    state_->writer = nullptr;
+    if (!state_->closed) {
+      conn_->ResumeReading();
+      conn_->Shutdown();
+    }
+    conn_.reset();
+    state_.reset();
+  }
+
+  TcpConnectionPtr conn_;
+  std::shared_ptr<detail::ConnectionState> state_;
+};
+
+/// co_await Connect(...)的等待体，结果为Connection，连接失败时转换为bool的结果为false
+class [[nodiscard]] ConnectAwaiter {
+ public:
+  ConnectAwaiter(Reactor *reactor, const InetAddress &server_addr, const SocketOptions &options)
+      : reactor_(reactor),
+        server_addr_(server_addr),
+        options_(options),
+        done_(false) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    if (reactor_->InCurrentReactorThread()) {
+      return Start();
+    }
+    reactor_->SubmitTask([this] {
+      if (!Start()) handle_.resume();
+    });
+    return true;
+  }
+  Connection await_resume() { return std::move(result_); }
+
+ private:
+  /// @return 是否需要等待连接完成
+  bool Start() {
+    int fd = net::NewNonBlockTcpSocketFd(server_addr_.GetFamily());
+    net::ApplyConnectSocketOptions(fd, options_);
+    int ret = net::Connect(fd, server_addr_);
+    int saved_errno = ret == 0 ? 0 : errno;
+    if (saved_errno != 0 && saved_errno != EINPROGRESS && saved_errno != EINTR && saved_errno != EISCONN) {
+      LOG_ERROR("connect() failed: {}", strerror(saved_errno));
+      net::Close(fd);
+      return false;
+    }
+    channel_ = std::make_unique<Channel>(fd);
+    channel_->SetWriteCallback([this] { HandleConnect(); });
+    channel_->SetErrorCallback([this] { HandleConnect(); });
+    channel_->EnableWrite();
+    reactor_->UpdateChannel(channel_.get());
+    return true;
+  }
+
+  void HandleConnect() {
+    if (done_) return;  // 可写事件与错误事件可能同时到达
+    done_ = true;
+    int fd = channel_->GetFd();
+    channel_->DisableAll();
+    reactor_->RemoveChannel(channel_.get());
+    int err = net::GetSocketError(fd);
+    if (err != 0 || net::IsSelfConnect(fd)) {
+      LOG_ERROR("connect to {} failed: {}", server_addr_.ToString(), err != 0 ? strerror(err) : "self connect");
+      net::Close(fd);
+    } else {
+      auto conn = TcpConnection::New();
+      conn->Init(reactor_, fd);
+      conn->SetCloseCallback([](const TcpConnectionPtr &conn) { conn->Destroy(); });
+      conn->SetConnectionCallback(Connection::OnConnection);
+      result_ = Connection(conn);
+      conn->Establish();
+    }
+    // 当前正处于channel_的HandleEvents中，协程恢复后会析构channel_，因此延迟到任务中恢复
+    reactor_->SubmitTask([handle = handle_] { handle.resume(); });
+  }
+
+  Reactor *reactor_;
+  InetAddress server_addr_;
+  SocketOptions options_;
+  std::coroutine_handle<> handle_;
+  std::unique_ptr<Channel> channel_;
+  Connection result_;
+  bool done_;
+};
+
+/// 在reactor上连接server_addr，连接建立后协程在reactor线程中恢复
+inline ConnectAwaiter Connect(Reactor *reactor, const InetAddress &server_addr, const SocketOptions &options = {}) {
+  return {reactor, server_addr, options};
+}
+/// 在当前Reactor上连接server_addr
+/// @note 请在Reactor线程中调用
+inline ConnectAwaiter Connect(const InetAddress &server_addr, const SocketOptions &options = {}) {
+  return {Reactor::GetCurrent(), server_addr, options};
+}
+
+/// 将一个协程函数Task<>(Connection)适配为TcpServer的ConnectionCallback，每个连接建立时启动一个协程
+/// 例如: server.SetConnectionCallback(net::coro::MakeConnectionCallback(Echo));
+template<typename Handler>
+TcpConnection::ConnectionCallback MakeConnectionCallback(Handler handler) {
+  return [handler = std::move(handler)](const TcpConnectionPtr &conn) {
+    if (conn->Connected()) {
+      Spawn(handler(Connection(conn)));
+    } else {
+      Connection::OnConnection(conn);
+    }
+  };
+}
+
+} // namespace net::coro
+
+#endif //NET_INCLUDE_NET_CORO_CONNECTION_HPP_
@@ -0,0 +1,44 @@
+#ifndef NET_INCLUDE_NET_CORO_SLEEP_HPP_
+#define NET_INCLUDE_NET_CORO_SLEEP_HPP_
+
+#include "net/coro/task.hpp"
+#include "net/reactor/reactor.hpp"
+
+namespace net::coro {
+
+/// co_await SleepFor(reactor, dur)的等待体，到期后在reactor线程中恢复协程
+class [[nodiscard]] SleepAwaiter {
+ public:
+  SleepAwaiter(Reactor *reactor, Duration duration) : reactor_(reactor), duration_(duration) {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    if (reactor_->InCurrentReactorThread()) {
+      reactor_->AddTimerAfter(duration_, [handle] { handle.resume(); });
+    } else {
+      // 定时器只能在Reactor线程中添加，协程也将在Reactor线程中恢复
+      reactor_->SubmitTask([reactor = reactor_, duration = duration_, handle] {
+        reactor->AddTimerAfter(duration, [handle] { handle.resume(); });
+      });
+    }
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  Reactor *reactor_;
+  Duration duration_;
+};
+
+/// 挂起当前协程，dur之后在reactor线程中恢复
+inline SleepAwaiter SleepFor(Reactor *reactor, Duration dur) {
+  return {reactor, dur};
+}
+/// 挂起当前协程，dur之后恢复
+/// @note 请在Reactor线程中调用
+inline SleepAwaiter SleepFor(Duration dur) {
+  return {Reactor::GetCurrent(), dur};
+}
+
+} // namespace net::coro
+
+#endif //NET_INCLUDE_NET_CORO_SLEEP_HPP_
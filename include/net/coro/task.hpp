@@ -0,0 +1,207 @@
+#ifndef NET_INCLUDE_NET_CORO_TASK_HPP_
+#define NET_INCLUDE_NET_CORO_TASK_HPP_
+
+#if __cplusplus < 202002L
+#error "net/coro requires C++20, please enable NET_ENABLE_COROUTINE"
+#endif
+
+#include "net/noncopyable.hpp"
+
+#include <array>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace net::coro {
+
+/// 协程帧的分配器，按照64字节的粒度分成若干大小类，每个线程为每个大小类缓存一定数量的空闲帧
+///
+/// 协程总是在所属Reactor线程中创建和销毁，因此线程本地缓存不需要任何同步；
+/// 超过kMaxPooledSize的帧以及缓存已满时归还的帧直接交给全局的operator new/delete
+class FrameAllocator {
+  static constexpr size_t kGranularity = 64;
+  static constexpr size_t kMaxPooledSize = 4096;
+  static constexpr size_t kClassNum = kMaxPooledSize / kGranularity;
+  static constexpr size_t kMaxCachedPerClass = 256;
+
+  struct LocalCache {
+    std::array<std::vector<void *>, kClassNum> free_lists;
+
+    ~LocalCache() {
+      for (auto &list: free_lists) {
+        for (void *ptr: list) {
+          ::operator delete(ptr);
+        }
+      }
+    }
+  };
+
+ public:
+  static void *Allocate(size_t size) {
+    if (size > kMaxPooledSize) {
+      return ::operator new(size);
+    }
+    auto &list = GetLocalCache().free_lists[GetClass(size)];
+    if (list.empty()) {
+      return ::operator new(GetClassSize(size));
+    }
+    void *ptr = list.back();
+    list.pop_back();
+    return ptr;
+  }
+
+  static void Deallocate(void *ptr, size_t size) {
+    if (size > kMaxPooledSize) {
+      ::operator delete(ptr);
+      return;
+    }
+    auto &list = GetLocalCache().free_lists[GetClass(size)];
+    if (list.size() >= kMaxCachedPerClass) {
+      ::operator delete(ptr);
+      return;
+    }
+    list.push_back(ptr);
+  }
+
+ private:
+  static size_t GetClass(size_t size) { return size == 0 ? 0 : (size - 1) / kGranularity; }
+  static size_t GetClassSize(size_t size) { return (GetClass(size) + 1) * kGranularity; }
+
+  static LocalCache &GetLocalCache() {
+    thread_local LocalCache cache;
+    return cache;
+  }
+};
+
+namespace detail {
+
+/// 所有协程promise的公共部分: 协程帧从FrameAllocator中分配
+struct PooledPromise {
+  static void *operator new(size_t size) {
+    return FrameAllocator::Allocate(size);
+  }
+  static void operator delete(void *ptr, size_t size) {
+    FrameAllocator::Deallocate(ptr, size);
+  }
+};
+
+/// Task的promise的公共部分，结束时通过对称转移恢复等待该Task的协程
+struct TaskPromiseBase : PooledPromise {
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      auto continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  void unhandled_exception() { exception = std::current_exception(); }
+
+  void RethrowIfException() {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+  void return_value(T v) { value.emplace(std::move(v)); }
+  T GetResult() {
+    RethrowIfException();
+    return std::move(*value);
+  }
+
+  std::optional<T> value;
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+  void return_void() {}
+  void GetResult() { RethrowIfException(); }
+};
+
+} // namespace net::coro::detail
+
+/// 惰性启动的协程，被co_await时才开始执行，执行完成后恢复等待它的协程
+/// 顶层的Task需要通过Spawn启动
+template<typename T = void>
+class [[nodiscard]] Task : noncopyable {
+ public:
+  struct promise_type : detail::TaskPromise<T> {
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+  };
+
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle.promise().continuation = continuation;
+        return handle;
+      }
+      T await_resume() { return handle.promise().GetResult(); }
+
+      std::coroutine_handle<promise_type> handle;
+    };
+    return Awaiter{handle_};
+  }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+/// Spawn使用的协程类型，立即开始执行，结束时自动销毁协程帧
+struct DetachedTask {
+  struct promise_type : PooledPromise {
+    DetachedTask get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+inline DetachedTask RunDetached(Task<> task) {
+  co_await std::move(task);
+}
+
+} // namespace net::coro::detail
+
+/// 在当前线程中立即启动一个顶层协程，直到其第一次挂起时返回，协程结束时自动释放
+/// @note 协程中未捕获的异常将导致程序终止
+inline void Spawn(Task<> task) {
+  detail::RunDetached(std::move(task));
+}
+
+} // namespace net::coro
+
+#endif //NET_INCLUDE_NET_CORO_TASK_HPP_
@@ -2,8 +2,12 @@
 #define NET_INCLUDE_NET_HTTP_COMMON_HPP_
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace net {
 
@@ -44,17 +48,21 @@ enum class HttpStatusCode {
   k201Created = 201,
   k202Accepted = 202,
   k204NoContent = 204,
+  k206PartialContent = 206,
   k300MultipleChoices = 300,
   k301MovedPermanently = 301,
   k302MovedTemporarily = 302,
-  k304NotModified = 303,
+  k304NotModified = 304,
   k400BadRequest = 400,
   k401Unauthorized = 401,
   k403Forbidden = 403,
   k404NotFound = 404,
   k405MethodNotAllowed = 405,
   k409Conflict = 409,
+  k413PayloadTooLarge = 413,
+  k416RangeNotSatisfiable = 416,
   k429TooManyRequests = 429,
+  k431RequestHeaderFieldsTooLarge = 431,
   k499ClientClosedRequest = 499,
   k500InternalServerError = 500,
   k501NotImplemented = 501,
@@ -90,6 +98,7 @@ inline const std::unordered_map<HttpStatusCode, std::string> http_status_code_to
     {HttpStatusCode::k201Created, "Created"},
     {HttpStatusCode::k202Accepted, "Accepted"},
     {HttpStatusCode::k204NoContent, "No Content"},
+    {HttpStatusCode::k206PartialContent, "Partial Content"},
     {HttpStatusCode::k300MultipleChoices, "Multiple Choices"},
     {HttpStatusCode::k301MovedPermanently, "Moved Permanently"},
     {HttpStatusCode::k302MovedTemporarily, "Moved Temporarily"},
@@ -100,7 +109,10 @@ inline const std::unordered_map<HttpStatusCode, std::string> http_status_code_to
     {HttpStatusCode::k404NotFound, "Not Found"},
     {HttpStatusCode::k405MethodNotAllowed, "Method Not Allowed"},
     {HttpStatusCode::k409Conflict, "Conflict"},
+    {HttpStatusCode::k413PayloadTooLarge, "Payload Too Large"},
+    {HttpStatusCode::k416RangeNotSatisfiable, "Range Not Satisfiable"},
     {HttpStatusCode::k429TooManyRequests, "Too Many Requests"},
+    {HttpStatusCode::k431RequestHeaderFieldsTooLarge, "Request Header Fields Too Large"},
     {HttpStatusCode::k499ClientClosedRequest, "Client Closed Request"},
     {HttpStatusCode::k500InternalServerError, "Internal Server Error"},
     {HttpStatusCode::k501NotImplemented, "Not Implemented"},
@@ -135,10 +147,59 @@ inline std::string ToString(HttpStatusCode status_code) {
   return "";
 }
 
-inline HttpVersion ToHttpVersion(const std::string &http_version) {
+namespace detail {
+
+/// 预先拼接好的状态行，例如"HTTP/1.1 200 OK\r\n"
+class StatusLineTable {
+ public:
+  static constexpr int kMaxStatusCode = 600;
+
+  StatusLineTable() : index_() {
+    for (auto &[code, message]: http_status_code_to_message) {
+      if (code == HttpStatusCode::kUnknown) continue;
+      for (int v = 0; v < 2; ++v) {
+        lines_[v].push_back((v == 0 ? "HTTP/1.0 " : "HTTP/1.1 ") + std::to_string(static_cast<int>(code)) +
+            " " + message + kCRLF);
+      }
+      index_[static_cast<int>(code)] = static_cast<uint8_t>(lines_[0].size());
+    }
+  }
+
+  /// @return 不在表中时返回空
+  [[nodiscard]] std::string_view Get(HttpVersion version, HttpStatusCode status_code) const {
+    int code = static_cast<int>(status_code);
+    if (code <= 0 || code >= kMaxStatusCode || version == HttpVersion::Invalid) return {};
+    if (index_[code] == 0) return {};
+    return lines_[version == HttpVersion::Http10 ? 0 : 1][index_[code] - 1];
+  }
+
+ private:
+  std::array<uint8_t, kMaxStatusCode> index_;   ///< 状态码在lines_中的下标+1，0表示不在表中
+  std::vector<std::string> lines_[2];           ///< HTTP/1.0与HTTP/1.1的状态行
+};
+
+} // namespace net::detail
+
+/// @return 该状态码的应答是否不能包含应答体以及Content-Length(1xx、204、304，参见RFC 7230 3.3)
+inline bool IsBodilessStatus(HttpStatusCode status_code) {
+  int code = static_cast<int>(status_code);
+  return (code >= 100 && code < 200) || code == 204 || code == 304;
+}
+
+/// @return 以CRLF结尾的状态行，常见的状态码直接返回预先生成的字符串
+inline std::string_view GetStatusLine(HttpVersion version, HttpStatusCode status_code) {
+  static const detail::StatusLineTable table;
+  std::string_view line = table.Get(version, status_code);
+  if (!line.empty()) return line;
+  thread_local std::string buf;
+  buf = ToString(version) + " " + std::to_string(static_cast<int>(status_code)) + " " + ToString(status_code) + kCRLF;
+  return buf;
+}
+
+inline HttpVersion ToHttpVersion(std::string_view http_version) {
   auto pos = std::find_if(detail::http_version_to_string.begin(),
                           detail::http_version_to_string.end(),
-                          [&http_version](const std::pair<HttpVersion, std::string> &pair) {
+                          [&http_version](const auto &pair) {
                             return pair.second == http_version;
                           });
   if (pos != detail::http_version_to_string.end()) {
@@ -147,10 +208,10 @@ inline HttpVersion ToHttpVersion(const std::string &http_version) {
   return HttpVersion::Invalid;
 }
 
-inline HttpMethod ToHttpMethod(const std::string &http_method) {
+inline HttpMethod ToHttpMethod(std::string_view http_method) {
   auto pos = std::find_if(detail::http_method_to_string.begin(),
                           detail::http_method_to_string.end(),
-                          [&http_method](const std::pair<HttpMethod, std::string> &pair) {
+                          [&http_method](const auto &pair) {
                             return pair.second == http_method;
                           });
   if (pos != detail::http_method_to_string.end()) {
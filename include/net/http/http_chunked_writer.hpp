@@ -0,0 +1,132 @@
+#ifndef NET_INCLUDE_NET_HTTP_HTTP_CHUNKED_WRITER_HPP_
+#define NET_INCLUDE_NET_HTTP_HTTP_CHUNKED_WRITER_HPP_
+
+#include "net/http/common.hpp"
+#include "net/tcp/tcp_connection.hpp"
+
+#include <cstdio>
+
+namespace net {
+
+/// 以chunked编码流式发送应答体，由HttpReply::BeginChunked创建
+///
+/// 处理函数返回之前写入的数据先缓存在写入器中，HttpServer发送状态行与头部时一并发送；
+/// 此后每次WriteChunk都直接交给TcpConnection发送，不需要在内存中构造完整的应答体。
+/// 写入器可以在处理函数返回之后继续使用(例如在定时器或者上游的回调中)，直到调用End。
+/// 连接的输出缓冲区中待发送的数据超过高水位线时WriteChunk返回false，此时应当停止生产数据，
+/// 并通过SetWritableCallback在待发送的数据回落之后继续
+/// @note 只能在连接所属的Reactor线程中使用
+/// @note HTTP/1.0的请求不支持chunked编码，应答体将直接发送，并在End之后关闭连接
+class HttpChunkedWriter : noncopyable {
+ public:
+  using WritableCallback = std::function<void()>;
+  using FinishCallback = std::function<void(const TcpConnectionPtr &)>;
+
+  static constexpr size_t kHighWaterMark = 64 * 1024;   ///< 输出缓冲区高于该值时暂停写入
+  static constexpr size_t kLowWaterMark = 16 * 1024;    ///< 回落到该值时调用WritableCallback
+
+  HttpChunkedWriter() : chunked_(true), ended_(false) {}
+
+  /// 发送一个数据块，空数据会被忽略(空数据块是应答体结束的标记)
+  /// @return 是否可以继续写入，参见IsWritable
+  bool WriteChunk(std::string_view data) {
+    if (ended_ || data.empty()) return IsWritable();
+    if (!conn_) {
+      pending_.append(data);
+    } else if (!chunked_) {
+      conn_->Send(data);
+    } else {
+      char size_line[24];
+      int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+      conn_->Send({std::string_view(size_line, n), data, kCRLF});
+    }
+    return IsWritable();
+  }
+
+  /// 结束应答体，之后的WriteChunk将被忽略
+  void End() {
+    if (ended_) return;
+    ended_ = true;
+    if (!conn_) return;  // 处理函数返回之前结束的，由HttpServer一并发送
+    if (chunked_) {
+      conn_->Send("0\r\n\r\n");
+    }
+    if (finish_callback_) {
+      FinishCallback cb = std::move(finish_callback_);
+      finish_callback_ = nullptr;
+      cb(conn_);
+    }
+  }
+
+  /// @return 连接未断开、应答未结束，并且输出缓冲区中待发送的数据低于高水位线
+  [[nodiscard]] bool IsWritable() const {
+    if (ended_) return false;
+    if (!conn_) return pending_.size() < kHighWaterMark;
+    return conn_->Connected() && conn_->GetPendingOutputBytes() < kHighWaterMark;
+  }
+  [[nodiscard]] bool IsEnded() const { return ended_; }
+  /// @return 连接是否仍然可用，断开之后应当停止生产数据
+  [[nodiscard]] bool Connected() const { return !conn_ || conn_->Connected(); }
+
+  /// 设置一次性的回调，在待发送的数据回落到低水位线或者连接断开时调用
+  void SetWritableCallback(WritableCallback cb) { writable_callback_ = std::move(cb); }
+
+  /// 由HttpServer调用，发送状态行与头部以及之前缓存的数据，此后的数据直接发送
+  /// @param head 序列化后的状态行与头部
+  /// @param chunked 是否使用chunked编码
+  /// @param cb 在处理函数返回之后调用End时调用
+  void Attach(const TcpConnectionPtr &conn, std::string_view head, bool chunked, FinishCallback cb) {
+    conn_ = conn;
+    chunked_ = chunked;
+    finish_callback_ = std::move(cb);
+    char size_line[24];
+    int n = 0;
+    if (chunked_ && !pending_.empty()) {
+      n = snprintf(size_line, sizeof(size_line), "%zx\r\n", pending_.size());
+    }
+    std::string_view body_end = chunked_ && !pending_.empty() ? kCRLF : "";
+    std::string_view last_chunk = chunked_ && ended_ ? "0\r\n\r\n" : "";
+    conn_->Send({head, std::string_view(size_line, n), pending_, body_end, last_chunk});
+    pending_.clear();
+    pending_.shrink_to_fit();
+  }
+
+  /// 由HttpServer在不需要应答体(HEAD请求)时调用，写入器直接结束，之前以及之后写入的数据都被丢弃
+  void Discard() {
+    ended_ = true;
+    pending_.clear();
+    finish_callback_ = nullptr;
+    // 等待写入的生产者据此得知应答已经结束
+    if (writable_callback_) {
+      WritableCallback cb = std::move(writable_callback_);
+      writable_callback_ = nullptr;
+      cb();
+    }
+  }
+
+  /// 由HttpServer在输出缓冲区回落或者连接断开时调用
+  void OnWritable() {
+    if (!writable_callback_) return;
+    if (!IsWritable() && Connected()) return;  // 仍然拥塞，或者应答已经结束
+    WritableCallback cb = std::move(writable_callback_);
+    writable_callback_ = nullptr;
+    cb();
+  }
+  /// 由HttpServer在连接断开时调用，之后End不再通知HttpServer
+  void OnClose() {
+    finish_callback_ = nullptr;
+    OnWritable();
+  }
+
+ private:
+  TcpConnectionPtr conn_;
+  bool chunked_;
+  bool ended_;
+  std::string pending_;   ///< Attach之前写入的数据
+  WritableCallback writable_callback_;
+  FinishCallback finish_callback_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_HTTP_HTTP_CHUNKED_WRITER_HPP_
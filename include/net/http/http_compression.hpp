@@ -0,0 +1,276 @@
+#ifndef NET_INCLUDE_NET_HTTP_HTTP_COMPRESSION_HPP_
+#define NET_INCLUDE_NET_HTTP_HTTP_COMPRESSION_HPP_
+
+#include "net/log.hpp"
+#include "net/noncopyable.hpp"
+#include "net/http/http_reply.hpp"
+#include "net/http/http_request.hpp"
+#include "net/util/string.hpp"
+#include "net/util/thread_pool.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace net {
+
+/// 应答体的内容编码
+enum class HttpContentCoding : uint8_t {
+  Identity,
+  Gzip,
+  Deflate,
+  Brotli,   ///< 只用于发送预压缩的.br文件
+};
+
+inline std::string_view ToString(HttpContentCoding coding) {
+  switch (coding) {
+    case HttpContentCoding::Gzip: return "gzip";
+    case HttpContentCoding::Deflate: return "deflate";
+    case HttpContentCoding::Brotli: return "br";
+    default: return "identity";
+  }
+}
+
+/// @return Accept-Encoding中coding的权重(千分之一为单位，0~1000)，没有列出时使用"*"的权重，都没有时返回0
+inline int GetEncodingWeight(std::string_view accept_encoding, std::string_view coding) {
+  int any_weight = 0;
+  while (!accept_encoding.empty()) {
+    size_t comma = accept_encoding.find(',');
+    std::string_view item = accept_encoding.substr(0, comma);
+    accept_encoding = comma == std::string_view::npos ? std::string_view() : accept_encoding.substr(comma + 1);
+    size_t semicolon = item.find(';');
+    std::string_view name = Trim(item.substr(0, semicolon));
+    // qvalue = ("0" ["." 0*3DIGIT]) / ("1" ["." 0*3"0"])，格式错误时视为1
+    int weight = 1000;
+    if (semicolon != std::string_view::npos) {
+      std::string_view param = Trim(item.substr(semicolon + 1));
+      if (param.size() >= 3 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=' && param[2] == '0') {
+        weight = 0;
+        for (size_t i = 4, scale = 100; i < param.size() && i < 7 && param[3] == '.'; ++i, scale /= 10) {
+          if (param[i] < '0' || param[i] > '9') break;
+          weight += (param[i] - '0') * static_cast<int>(scale);
+        }
+      }
+    }
+    if (EqualsIgnoreCase(name, coding)) return weight;
+    if (name == "*") any_weight = weight;
+  }
+  return any_weight;
+}
+
+/// 以gzip或deflate(zlib格式，参见RFC 7230 4.2.2)压缩input
+/// @return 压缩失败时返回false
+inline bool Compress(HttpContentCoding coding, std::string_view input, int level, std::string *output) {
+  z_stream zs{};
+  int window_bits = coding == HttpContentCoding::Gzip ? 15 + 16 : 15;
+  if (deflateInit2(&zs, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+  output->resize(deflateBound(&zs, input.size()));
+  zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+  zs.avail_in = input.size();
+  zs.next_out = reinterpret_cast<Bytef *>(output->data());
+  zs.avail_out = output->size();
+  int ret = deflate(&zs, Z_FINISH);
+  output->resize(zs.total_out);
+  deflateEnd(&zs);
+  return ret == Z_STREAM_END;
+}
+
+/// 压缩结果的LRU缓存，以编码与原始内容的哈希为键，总字节数有上限
+///
+/// 哈希可能碰撞(甚至被刻意构造)，缓存项同时保存原始内容，命中前逐字节比较，
+/// 因此总字节数包括压缩结果与原始内容两部分
+/// @note 线程安全
+class HttpCompressionCache : noncopyable {
+ public:
+  explicit HttpCompressionCache(size_t capacity) : capacity_(capacity), size_(0) {}
+
+  /// @return 未命中时返回nullptr
+  std::shared_ptr<const std::string> Get(HttpContentCoding coding, std::string_view content) {
+    if (capacity_ == 0) return nullptr;
+    Key key = MakeKey(coding, content);
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end() || it->second->content != content) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->compressed;
+  }
+
+  void Put(HttpContentCoding coding, std::string_view content, std::shared_ptr<const std::string> compressed) {
+    if (compressed->size() + content.size() > capacity_) return;
+    Key key = MakeKey(coding, content);
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      if (it->second->content == content) return;
+      // 哈希碰撞，以新的内容替换
+      Erase(it->second);
+    }
+    size_ += compressed->size() + content.size();
+    lru_.push_front({key, std::string(content), std::move(compressed)});
+    index_.emplace(key, lru_.begin());
+    while (size_ > capacity_) {
+      Erase(std::prev(lru_.end()));
+    }
+  }
+
+  /// @return 缓存的压缩结果与原始内容的总字节数
+  [[nodiscard]] size_t Size() {
+    std::lock_guard lock(mutex_);
+    return size_;
+  }
+
+ private:
+  /// 查找时原始内容只以64位哈希与长度表示，命中后再与Entry::content比较
+  struct Key {
+    size_t hash;
+    size_t size;
+    HttpContentCoding coding;
+
+    bool operator==(const Key &rhs) const { return hash == rhs.hash && size == rhs.size && coding == rhs.coding; }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &key) const { return key.hash ^ static_cast<size_t>(key.coding); }
+  };
+  struct Entry {
+    Key key;
+    std::string content;    ///< 原始内容，用于排除哈希碰撞
+    std::shared_ptr<const std::string> compressed;
+  };
+  using Lru = std::list<Entry>;   ///< 最近使用的在前
+
+  static Key MakeKey(HttpContentCoding coding, std::string_view content) {
+    return {std::hash<std::string_view>()(content), content.size(), coding};
+  }
+
+  void Erase(Lru::iterator pos) {
+    size_ -= pos->compressed->size() + pos->content.size();
+    index_.erase(pos->key);
+    lru_.erase(pos);
+  }
+
+  size_t capacity_;
+  size_t size_;
+  std::mutex mutex_;
+  Lru lru_;
+  std::unordered_map<Key, Lru::iterator, KeyHash> index_;
+};
+
+struct HttpCompressionOptions {
+  size_t min_size = 256;                ///< 小于该长度的应答体不压缩
+  size_t offload_size = 16 * 1024;      ///< 缓存未命中时，不小于该长度的应答体在线程池中压缩
+  int level = 6;                        ///< zlib的压缩级别
+  size_t cache_capacity = 16 * 1024 * 1024;   ///< 缓存的压缩结果与原始内容的总字节数，0表示不缓存
+  /// 需要压缩的Content-Type前缀，图片、视频等已经压缩过的格式不需要再压缩
+  std::vector<std::string> content_types = {"text/", "application/json", "application/javascript",
+                                            "application/xml", "image/svg+xml"};
+};
+
+/// 动态应答的压缩: 根据Accept-Encoding选择gzip或deflate，较小的应答体在Reactor线程中直接压缩，
+/// 较大的应答体交给线程池，压缩结果按内容缓存，内容相同的应答不会重复压缩
+class HttpCompressor : noncopyable {
+ public:
+  /// @param thread_pool 为空时总是在当前线程中压缩
+  explicit HttpCompressor(HttpCompressionOptions options = {}, ThreadPool *thread_pool = nullptr)
+      : options_(std::move(options)),
+        thread_pool_(thread_pool),
+        cache_(options_.cache_capacity) {}
+
+  /// 确定应答体的编码，可以压缩的应答会加上Vary: Accept-Encoding(即使客户端不接受压缩)
+  /// @return 不需要压缩时返回HttpContentCoding::Identity
+  HttpContentCoding Negotiate(const HttpRequest &request, HttpReply &reply) const {
+    if (!reply.HasContent() || reply.GetContent().size() < options_.min_size) return HttpContentCoding::Identity;
+    int code = static_cast<int>(reply.GetStatusCode());
+    if (code < 200 || code >= 300 || code == 206) return HttpContentCoding::Identity;
+    if (reply.HasHeader(HttpHeaderId::ContentEncoding)) return HttpContentCoding::Identity;
+    if (reply.GetHeader(HttpHeaderId::CacheControl).find("no-transform") != std::string_view::npos) {
+      return HttpContentCoding::Identity;
+    }
+    std::string_view content_type = reply.GetHeader(HttpHeaderId::ContentType);
+    if (std::none_of(options_.content_types.begin(), options_.content_types.end(), [content_type](const auto &type) {
+      return HasPrefix(content_type, type);
+    })) {
+      return HttpContentCoding::Identity;
+    }
+    AddVary(reply);
+    std::string_view accept_encoding = request.GetHeader(HttpHeaderId::AcceptEncoding);
+    int gzip = GetEncodingWeight(accept_encoding, "gzip");
+    int deflate = GetEncodingWeight(accept_encoding, "deflate");
+    if (gzip == 0 && deflate == 0) return HttpContentCoding::Identity;
+    return gzip >= deflate ? HttpContentCoding::Gzip : HttpContentCoding::Deflate;
+  }
+
+  /// 缓存命中或者应答体较小时直接替换为压缩后的应答体
+  /// @return 需要调用Compress在线程池中压缩时返回false
+  bool TryCompress(HttpContentCoding coding, HttpReply &reply) {
+    const std::string &content = reply.GetContent();
+    auto compressed = cache_.Get(coding, content);
+    if (!compressed) {
+      if (thread_pool_ && content.size() >= options_.offload_size) return false;
+      compressed = Compress(coding, content);
+    }
+    Apply(coding, compressed, reply);
+    return true;
+  }
+
+  /// 压缩content并加入缓存
+  /// @return 压缩失败时返回nullptr
+  /// @note 线程安全
+  std::shared_ptr<const std::string> Compress(HttpContentCoding coding, std::string_view content) {
+    auto compressed = std::make_shared<std::string>();
+    if (!net::Compress(coding, content, options_.level, compressed.get())) {
+      LOG_ERROR("failed to compress {} bytes with {}", content.size(), ToString(coding));
+      return nullptr;
+    }
+    cache_.Put(coding, content, compressed);
+    return compressed;
+  }
+
+  /// 以压缩后的内容替换应答体，compressed为空时保持不变
+  static void Apply(HttpContentCoding coding, const std::shared_ptr<const std::string> &compressed, HttpReply &reply) {
+    if (!compressed) return;
+    reply.SetContent(*compressed);
+    reply.SetHeader(HttpHeaderId::ContentEncoding, ToString(coding));
+    // 不同编码的表示需要不同的强校验值
+    std::string_view etag = reply.GetHeader(HttpHeaderId::ETag);
+    if (etag.size() >= 2 && etag.back() == '"') {
+      std::string new_etag(etag.substr(0, etag.size() - 1));
+      new_etag.append("-").append(ToString(coding)).append("\"");
+      reply.SetHeader(HttpHeaderId::ETag, new_etag);
+    }
+  }
+
+  /// 在Vary中加入Accept-Encoding
+  static void AddVary(HttpReply &reply) {
+    std::string_view vary = reply.GetHeader(HttpHeaderId::Vary);
+    if (vary.empty()) {
+      reply.SetHeader(HttpHeaderId::Vary, ToString(HttpHeaderId::AcceptEncoding));
+      return;
+    }
+    if (vary == "*") return;
+    for (std::string_view rest = vary; !rest.empty();) {
+      size_t comma = rest.find(',');
+      if (EqualsIgnoreCase(Trim(rest.substr(0, comma)), ToString(HttpHeaderId::AcceptEncoding))) return;
+      rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+    }
+    reply.SetHeader(HttpHeaderId::Vary, std::string(vary) + ", " + std::string(ToString(HttpHeaderId::AcceptEncoding)));
+  }
+
+  [[nodiscard]] ThreadPool *GetThreadPool() const { return thread_pool_; }
+  [[nodiscard]] HttpCompressionCache &GetCache() { return cache_; }
+
+ private:
+  HttpCompressionOptions options_;
+  ThreadPool *thread_pool_;
+  HttpCompressionCache cache_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_HTTP_HTTP_COMPRESSION_HPP_
@@ -0,0 +1,93 @@
+#ifndef NET_INCLUDE_NET_HTTP_HTTP_DATE_HPP_
+#define NET_INCLUDE_NET_HTTP_HTTP_DATE_HPP_
+
+#include <algorithm>
+#include <ctime>
+#include <string_view>
+
+namespace net {
+
+/// IMF-fixdate(RFC 7231 7.1.1.1)的长度，例如"Sun, 06 Nov 1994 08:49:37 GMT"
+inline constexpr size_t kHttpDateSize = 29;
+
+/// 将时间格式化为IMF-fixdate，不受locale影响
+/// @param buf 至少kHttpDateSize字节
+/// @return 指向buf的格式化结果
+inline std::string_view FormatHttpDate(time_t t, char *buf) {
+  static constexpr char kWeekdays[] = "SunMonTueWedThuFriSat";
+  static constexpr char kMonths[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  struct tm tm{};
+  gmtime_r(&t, &tm);
+  auto put2 = [](char *p, int v) {
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+  };
+  char *p = buf;
+  std::copy_n(kWeekdays + tm.tm_wday * 3, 3, p);
+  p[3] = ',';
+  p[4] = ' ';
+  put2(p + 5, tm.tm_mday);
+  p[7] = ' ';
+  std::copy_n(kMonths + tm.tm_mon * 3, 3, p + 8);
+  p[11] = ' ';
+  int year = tm.tm_year + 1900;
+  put2(p + 12, year / 100 % 100);
+  put2(p + 14, year % 100);
+  p[16] = ' ';
+  put2(p + 17, tm.tm_hour);
+  p[19] = ':';
+  put2(p + 20, tm.tm_min);
+  p[22] = ':';
+  put2(p + 23, tm.tm_sec);
+  std::copy_n(" GMT", 4, p + 25);
+  return {buf, kHttpDateSize};
+}
+
+/// 解析IMF-fixdate，不支持RFC 850与asctime格式(RFC 7231 7.1.1.1中已废弃)
+/// @return 格式错误时返回false
+inline bool ParseHttpDate(std::string_view date, time_t *t) {
+  static constexpr std::string_view kMonths = "JanFebMarAprMayJunJulAugSepOctNovDec";
+  if (date.size() != kHttpDateSize || date[3] != ',' || date.substr(25) != " GMT") return false;
+  auto get = [date](size_t pos, size_t n, int *v) {
+    *v = 0;
+    for (size_t i = pos; i < pos + n; ++i) {
+      if (date[i] < '0' || date[i] > '9') return false;
+      *v = *v * 10 + (date[i] - '0');
+    }
+    return true;
+  };
+  struct tm tm{};
+  size_t month = kMonths.find(date.substr(8, 3));
+  if (month == std::string_view::npos || month % 3 != 0) return false;
+  tm.tm_mon = static_cast<int>(month / 3);
+  int year;
+  if (!get(5, 2, &tm.tm_mday) || !get(12, 4, &year) || !get(17, 2, &tm.tm_hour) ||
+      !get(20, 2, &tm.tm_min) || !get(23, 2, &tm.tm_sec)) {
+    return false;
+  }
+  tm.tm_year = year - 1900;
+  *t = timegm(&tm);
+  return true;
+}
+
+/// @return 当前时间的IMF-fixdate，用作应答的Date头部
+/// @note 每个线程(也就是每个Reactor)缓存一份，时间跨过一秒之后才重新格式化，
+///       取时间使用CLOCK_REALTIME_COARSE，不需要系统调用；返回值在同一秒内有效
+inline std::string_view GetHttpDateNow() {
+  struct Cache {
+    time_t second = -1;
+    char buf[kHttpDateSize];
+  };
+  thread_local Cache cache;
+  struct timespec ts{};
+  clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+  if (ts.tv_sec != cache.second) {
+    cache.second = ts.tv_sec;
+    FormatHttpDate(ts.tv_sec, cache.buf);
+  }
+  return {cache.buf, kHttpDateSize};
+}
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_HTTP_HTTP_DATE_HPP_
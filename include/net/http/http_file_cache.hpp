@@ -0,0 +1,300 @@
+#ifndef NET_INCLUDE_NET_HTTP_HTTP_FILE_CACHE_HPP_
+#define NET_INCLUDE_NET_HTTP_HTTP_FILE_CACHE_HPP_
+
+#include "net/log.hpp"
+#include "net/noncopyable.hpp"
+#include "net/http/http_date.hpp"
+#include "net/http/mime_types.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace net {
+
+/// 打开的文件以及生成应答所需的元数据，在缓存中淘汰或者失效之后，仍然被引用时fd保持打开
+struct HttpCachedFile : noncopyable {
+  HttpCachedFile() : fd(-1), size(0), mtime{}, inode(0) {}
+  ~HttpCachedFile() {
+    if (fd >= 0) ::close(fd);
+  }
+
+  int fd;
+  size_t size;
+  struct timespec mtime;
+  ino_t inode;
+  std::string_view content_type;  ///< 根据扩展名确定，指向静态的MIME类型表
+  std::string etag;               ///< 由inode、大小与修改时间生成的强校验值
+  std::string last_modified;      ///< IMF-fixdate格式的修改时间
+  /// 同一目录下预压缩的"<文件名>.gz"与"<文件名>.br"，不存在或者比原文件旧时为空
+  std::shared_ptr<const HttpCachedFile> gzip;
+  std::shared_ptr<const HttpCachedFile> brotli;
+};
+
+/// 有界的已打开文件缓存，缓存命中时不需要open/stat
+///
+/// 缓存按路径的哈希分片，每个分片是一个由互斥锁保护的LRU，多个Reactor线程同时查找时很少竞争。
+/// 文件所在的目录通过inotify监视，文件被修改、替换或者删除时，后台线程将其从缓存中移除，
+/// 之后的请求重新打开文件；正在发送旧文件的连接持有HttpCachedFile的引用，不受影响。
+/// 打开文件时一并查找预压缩的.gz/.br文件，之后的请求不需要再检查它们是否存在
+class HttpFileCache : noncopyable {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024;   ///< 默认最多缓存的fd数量
+
+  explicit HttpFileCache(size_t capacity = kDefaultCapacity)
+      : shard_capacity_(std::max<size_t>(1, capacity / kShardNum)),
+        inotify_fd_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+        wakeup_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (inotify_fd_ < 0 || wakeup_fd_ < 0) {
+      // 无法感知文件的变化时不缓存，每次都重新打开
+      LOG_ERROR("inotify_init1() or eventfd() failed, file cache disabled");
+      shard_capacity_ = 0;
+      return;
+    }
+    watcher_ = std::thread([this] { WatchLoop(); });
+  }
+  ~HttpFileCache() {
+    if (watcher_.joinable()) {
+      uint64_t one = 1;
+      ::write(wakeup_fd_, &one, sizeof(one));
+      watcher_.join();
+    }
+    if (inotify_fd_ >= 0) ::close(inotify_fd_);
+    if (wakeup_fd_ >= 0) ::close(wakeup_fd_);
+  }
+
+  /// 获取path对应的普通文件，不在缓存中时打开并加入缓存
+  /// @return 文件不存在、无法打开或者不是普通文件(例如目录)时返回nullptr
+  std::shared_ptr<const HttpCachedFile> Open(const std::string &path) {
+    Shard &shard = GetShard(path);
+    uint64_t generation;
+    {
+      std::lock_guard lock(shard.mutex);
+      auto it = shard.index.find(path);
+      if (it != shard.index.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->second;
+      }
+      generation = shard.generation;
+    }
+    // 先监视目录再打开文件，避免错过两者之间发生的修改；无法监视时不缓存，否则文件变化后一直发送旧的内容
+    bool cacheable = shard_capacity_ > 0 && WatchDir(path);
+    auto file = OpenFile(path);
+    if (!file) return file;
+    if (!HasCompressedSuffix(path)) {
+      file->gzip = OpenCompressed(path + std::string(kGzipSuffix), *file);
+      file->brotli = OpenCompressed(path + std::string(kBrotliSuffix), *file);
+    }
+    if (!cacheable) return file;
+    std::lock_guard lock(shard.mutex);
+    if (shard.generation != generation) {
+      return file;  // 打开期间分片中有文件失效，可能正是该文件，不能确定打开的是新的内容
+    }
+    auto it = shard.index.find(path);
+    if (it != shard.index.end()) {
+      return it->second->second;  // 其他线程同时打开了该文件
+    }
+    shard.lru.emplace_front(path, file);
+    shard.index.emplace(shard.lru.front().first, shard.lru.begin());
+    if (shard.lru.size() > shard_capacity_) {
+      shard.index.erase(shard.lru.back().first);
+      shard.lru.pop_back();
+    }
+    return file;
+  }
+
+  /// 将path从缓存中移除
+  void Invalidate(std::string_view path) {
+    Shard &shard = GetShard(path);
+    std::lock_guard lock(shard.mutex);
+    ++shard.generation;
+    auto it = shard.index.find(path);
+    if (it != shard.index.end()) {
+      auto pos = it->second;
+      shard.index.erase(it);
+      shard.lru.erase(pos);
+    }
+  }
+
+  /// 清空缓存
+  void Clear() {
+    for (auto &shard: shards_) {
+      std::lock_guard lock(shard.mutex);
+      ++shard.generation;
+      shard.index.clear();
+      shard.lru.clear();
+    }
+  }
+
+  /// @return 缓存的文件数量
+  [[nodiscard]] size_t Size() {
+    size_t size = 0;
+    for (auto &shard: shards_) {
+      std::lock_guard lock(shard.mutex);
+      size += shard.lru.size();
+    }
+    return size;
+  }
+
+ private:
+  static constexpr size_t kShardNum = 16;
+
+  struct Shard {
+    std::mutex mutex;
+    std::list<std::pair<std::string, std::shared_ptr<const HttpCachedFile>>> lru;  ///< 最近使用的在前
+    std::unordered_map<std::string_view, decltype(lru)::iterator> index;         ///< key指向lru中的路径
+    uint64_t generation = 0;  ///< 每次失效时递增，打开文件期间发生变化时不插入打开的文件
+  };
+
+  Shard &GetShard(std::string_view path) {
+    return shards_[std::hash<std::string_view>()(path) % kShardNum];
+  }
+
+  static constexpr std::string_view kGzipSuffix = ".gz";
+  static constexpr std::string_view kBrotliSuffix = ".br";
+
+  static bool HasCompressedSuffix(std::string_view path) {
+    auto has_suffix = [path](std::string_view suffix) {
+      return path.size() > suffix.size() && path.substr(path.size() - suffix.size()) == suffix;
+    };
+    return has_suffix(kGzipSuffix) || has_suffix(kBrotliSuffix);
+  }
+
+  /// 打开预压缩的文件，比原文件旧时视为过期
+  static std::shared_ptr<const HttpCachedFile> OpenCompressed(const std::string &path, const HttpCachedFile &origin) {
+    auto file = OpenFile(path);
+    if (!file) return nullptr;
+    if (file->mtime.tv_sec < origin.mtime.tv_sec ||
+        (file->mtime.tv_sec == origin.mtime.tv_sec && file->mtime.tv_nsec < origin.mtime.tv_nsec)) {
+      return nullptr;
+    }
+    return file;
+  }
+
+  static std::shared_ptr<HttpCachedFile> OpenFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    auto file = std::make_shared<HttpCachedFile>();
+    file->fd = fd;
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) return nullptr;
+    file->size = st.st_size;
+    file->mtime = st.st_mtim;
+    file->inode = st.st_ino;
+    file->etag = fmt::format("\"{:x}-{:x}-{:x}.{:x}\"", st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+    char date[kHttpDateSize];
+    file->last_modified = FormatHttpDate(st.st_mtim.tv_sec, date);
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+      file->content_type = ToMimeType(std::string_view(path).substr(dot));
+    } else {
+      file->content_type = ToMimeType("");
+    }
+    return file;
+  }
+
+  /// 监视path所在的目录，每个目录只添加一次
+  /// @return 目录是否处于监视中，例如inotify的监视数量达到上限时返回false
+  bool WatchDir(std::string_view path) {
+    size_t slash = path.rfind('/');
+    std::string dir(slash == std::string_view::npos ? "." : path.substr(0, slash));
+    std::lock_guard lock(watch_mutex_);
+    if (watched_dirs_.count(dir)) return true;
+    int wd = ::inotify_add_watch(inotify_fd_, dir.c_str(),
+                                 IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                     IN_DELETE_SELF | IN_MOVE_SELF);
+    if (wd < 0) {
+      LOG_ERROR("inotify_add_watch({}) failed", dir);
+      return false;
+    }
+    watched_dirs_.insert(dir);
+    // 同一个目录的不同写法(例如经过符号链接)得到同一个wd，每种写法下缓存的文件都需要失效
+    wd_to_dirs_[wd].push_back(std::move(dir));
+    return true;
+  }
+
+  void WatchLoop() {
+    alignas(struct inotify_event) char buf[16 * 1024];
+    struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wakeup_fd_, POLLIN, 0}};
+    while (true) {
+      if (::poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) continue;
+        LOG_ERROR("poll() failed");
+        return;
+      }
+      if (fds[1].revents & POLLIN) return;
+      ssize_t n;
+      while ((n = ::read(inotify_fd_, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n;) {
+          auto *event = reinterpret_cast<struct inotify_event *>(p);
+          HandleEvent(event);
+          p += sizeof(struct inotify_event) + event->len;
+        }
+      }
+    }
+  }
+
+  void HandleEvent(const struct inotify_event *event) {
+    if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+      // 丢失了事件，或者目录本身发生了变化，无法确定受影响的文件
+      Clear();
+      if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+        std::lock_guard lock(watch_mutex_);
+        auto it = wd_to_dirs_.find(event->wd);
+        if (it != wd_to_dirs_.end()) {
+          if (!(event->mask & IN_IGNORED)) ::inotify_rm_watch(inotify_fd_, event->wd);
+          for (auto &dir: it->second) {
+            watched_dirs_.erase(dir);
+          }
+          wd_to_dirs_.erase(it);
+        }
+      }
+      return;
+    }
+    if (event->len == 0) return;
+    std::vector<std::string> paths;
+    {
+      std::lock_guard lock(watch_mutex_);
+      auto it = wd_to_dirs_.find(event->wd);
+      if (it == wd_to_dirs_.end()) return;
+      for (auto &dir: it->second) {
+        paths.push_back(dir + '/' + event->name);
+      }
+    }
+    for (auto &path: paths) {
+      Invalidate(path);
+      // 预压缩文件的变化使原文件的缓存失效(两种后缀的长度相同)
+      if (HasCompressedSuffix(path)) {
+        Invalidate(std::string_view(path).substr(0, path.size() - kGzipSuffix.size()));
+      }
+    }
+  }
+
+  std::array<Shard, kShardNum> shards_;
+  size_t shard_capacity_;
+  int inotify_fd_;
+  int wakeup_fd_;     ///< 析构时唤醒后台线程
+  std::mutex watch_mutex_;
+  std::unordered_set<std::string> watched_dirs_;
+  std::unordered_map<int, std::vector<std::string>> wd_to_dirs_;   ///< 每个wd对应的目录的所有写法
+  std::thread watcher_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_HTTP_HTTP_FILE_CACHE_HPP_
@@ -2,72 +2,284 @@
 #define NET_INCLUDE_NET_HTTP_HTTP_FILE_SERVER_HPP_
 
 #include "net/log.hpp"
+#include "net/http/http_compression.hpp"
+#include "net/http/http_file_cache.hpp"
 #include "net/http/http_request.hpp"
 #include "net/http/http_reply.hpp"
-#include "net/http/mime_types.hpp"
 #include "net/util/string.hpp"
 
+#include <algorithm>
+#include <charconv>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
-
-// TODO: 支持Content-Range字段
+#include <random>
+#include <vector>
 
 namespace net {
 
 namespace fs = std::filesystem;
 
+/// 静态文件服务，文件内容通过sendfile发送，支持条件请求与Range请求
+///
+/// 已打开的文件由HttpFileCache缓存，热点文件的请求不需要open/stat，也不会把文件内容读到用户态；
+/// 只有缓存中找不到普通文件时，才检查路径是否为目录
+/// @note 可以复制，副本共享同一个缓存
 class HttpFileServer {
  public:
-  explicit HttpFileServer(fs::path base_dir, std::string url_prefix = "/")
+  explicit HttpFileServer(fs::path base_dir, std::string url_prefix = "/",
+                          size_t cache_capacity = HttpFileCache::kDefaultCapacity)
       : base_dir_(std::move(base_dir)),
-        url_prefix_(std::move(url_prefix)) {
+        url_prefix_(std::move(url_prefix)),
+        cache_(std::make_shared<HttpFileCache>(cache_capacity)),
+        precompressed_(true) {
     NET_ASSERT(fs::is_directory(base_dir_));
+    base_path_ = base_dir_.string();
+    if (base_path_.empty() || base_path_.back() != '/') {
+      base_path_.push_back('/');
+    }
     if (url_prefix_.empty() || url_prefix_.back() != '/') {
       url_prefix_.push_back('/');
     }
   }
 
   void operator()(const HttpRequest &request, HttpReply &reply) {
-    std::string url = request.GetRouteUrl();
+    std::string url(request.GetRouteUrl());
     std::string rel_path;
     if (!net::RemovePrefix(rel_path, url, url_prefix_) &&
         !net::RemovePrefix(rel_path, url + '/', url_prefix_)) {
       reply.SetStatusCode(HttpStatusCode::k404NotFound);
       return;
     }
-    auto file_path = base_dir_ / rel_path;  // 拼接出在文件系统中的路径
-    if (!fs::exists(file_path)) {
-      reply.SetStatusCode(HttpStatusCode::k404NotFound);
+    if (!NormalizePath(rel_path)) {  // 不允许访问base_dir之外的文件
+      reply.SetStatusCode(HttpStatusCode::k403Forbidden);
       return;
     }
-    if (fs::is_directory(file_path)) {
-      // 如果目录路径不以'/'结束的话，需要重定向到包含'/'的页面
-      if (url.empty() || url.back() != '/') {
-        LocalRedirect(url + '/', request.GetRawParams(), reply);
+    std::string file_path = base_path_ + rel_path;  // 拼接出在文件系统中的路径
+    bool is_dir_url = url.empty() || url.back() == '/';
+    // 对于目录，首先查找目录下是否有index.html文件
+    if (auto file = cache_->Open(is_dir_url ? file_path + std::string(kIndexFile) : file_path)) {
+      std::string_view content_type = file->content_type;
+      if (precompressed_ && (file->gzip || file->brotli)) {
+        file = SelectEncoding(request, std::move(file), reply);
+      }
+      SetValidators(url, *file, reply);
+      if (IsNotModified(request, *file)) {
+        // 校验值匹配时只发送头部
+        reply.SetStatusCode(HttpStatusCode::k304NotModified);
         return;
       }
-      // 对于目录，首先查找目录下是否有index.html文件
-      auto index_file = file_path / kIndexFile;
-      if (fs::exists(index_file)) {
-        ServeFile(index_file, reply);
-      } else {
-        // 不存在index.html的话，则发送一个展示目录下文件的html页面
-        ServeDir(file_path, reply);
+      std::vector<ByteRange> ranges;
+      if (request.GetMethod() == HttpMethod::Get && request.HasHeader(HttpHeaderId::Range) &&
+          IsRangeFresh(request, *file) && ParseRange(request.GetHeader(HttpHeaderId::Range), file->size, &ranges)) {
+        ServeRanges(std::move(file), content_type, ranges, reply);
+        return;
       }
+      ServeFile(std::move(file), content_type, reply);
+      return;
+    }
+    std::error_code ec;
+    if (!fs::is_directory(file_path, ec)) {
+      reply.SetStatusCode(HttpStatusCode::k404NotFound);
+      return;
+    }
+    if (!is_dir_url) {
+      // 如果目录路径不以'/'结束的话，需要重定向到包含'/'的页面
+      LocalRedirect(url + '/', request.GetRawParams(), reply);
+    } else {
+      // 不存在index.html的话，则发送一个展示目录下文件的html页面
+      ServeDir(file_path, reply);
+    }
+  }
+
+  [[nodiscard]] HttpFileCache &GetCache() { return *cache_; }
+
+  /// 是否在Accept-Encoding允许时发送预压缩的"<文件名>.br"或"<文件名>.gz"，默认开启
+  void SetPrecompressed(bool on) { precompressed_ = on; }
+
+  /// 为url以url_prefix开头的文件设置Cache-Control，例如"public, max-age=31536000, immutable"
+  /// @note 多个前缀匹配时使用最长的前缀；没有匹配的前缀时不发送Cache-Control
+  /// @note 请在注册到HttpServer之前设置，注册时复制的是当前的配置
+  void SetCacheControl(std::string url_prefix, std::string value) {
+    auto pos = std::find_if(cache_controls_.begin(), cache_controls_.end(), [&url_prefix](const auto &p) {
+      return p.first.size() <= url_prefix.size();
+    });
+    if (pos != cache_controls_.end() && pos->first == url_prefix) {
+      pos->second = std::move(value);
     } else {
-      ServeFile(file_path, reply);
+      cache_controls_.emplace(pos, std::move(url_prefix), std::move(value));
     }
   }
+
  private:
-  void ServeFile(const fs::path &file, HttpReply &reply) {
-    std::string_view content_type = ToMimeType(file.extension().string());
-    std::ifstream ifs(file);
-    std::stringstream ss;
-    ss << ifs.rdbuf();
-    std::string content(ss.str());
+  /// 去掉path中的空路径段与"."，使同一个文件只有一种写法(缓存以路径为键)，保留结尾的'/'
+  /// @return path中有".."时返回false
+  static bool NormalizePath(std::string &path) {
+    std::string normalized;
+    size_t start = 0;
+    while (start <= path.size()) {
+      size_t end = path.find('/', start);
+      if (end == std::string::npos) end = path.size();
+      std::string_view segment = std::string_view(path).substr(start, end - start);
+      if (segment == "..") return false;
+      if (!segment.empty() && segment != ".") {
+        if (!normalized.empty()) normalized.push_back('/');
+        normalized.append(segment);
+      }
+      start = end + 1;
+    }
+    if (!normalized.empty() && !path.empty() && path.back() == '/') {
+      normalized.push_back('/');
+    }
+    path = std::move(normalized);
+    return true;
+  }
+
+  /// 选择客户端接受的预压缩文件，权重相同时优先br，之后的校验值与范围都针对压缩后的文件
+  static std::shared_ptr<const HttpCachedFile> SelectEncoding(const HttpRequest &request,
+                                                              std::shared_ptr<const HttpCachedFile> file,
+                                                              HttpReply &reply) {
+    reply.SetHeader(HttpHeaderId::Vary, ToString(HttpHeaderId::AcceptEncoding));
+    std::string_view accept_encoding = request.GetHeader(HttpHeaderId::AcceptEncoding);
+    int brotli = file->brotli ? GetEncodingWeight(accept_encoding, ToString(HttpContentCoding::Brotli)) : 0;
+    int gzip = file->gzip ? GetEncodingWeight(accept_encoding, ToString(HttpContentCoding::Gzip)) : 0;
+    if (brotli > 0 && brotli >= gzip) {
+      reply.SetHeader(HttpHeaderId::ContentEncoding, ToString(HttpContentCoding::Brotli));
+      return file->brotli;
+    }
+    if (gzip > 0) {
+      reply.SetHeader(HttpHeaderId::ContentEncoding, ToString(HttpContentCoding::Gzip));
+      return file->gzip;
+    }
+    return file;
+  }
+
+  void SetValidators(std::string_view url, const HttpCachedFile &file, HttpReply &reply) const {
+    reply.SetHeader(HttpHeaderId::ETag, file.etag);
+    reply.SetHeader(HttpHeaderId::LastModified, file.last_modified);
+    for (auto &[prefix, value]: cache_controls_) {
+      if (HasPrefix(url, prefix)) {
+        reply.SetHeader(HttpHeaderId::CacheControl, value);
+        break;
+      }
+    }
+  }
+
+  /// 按RFC 7232 6的顺序检查条件请求，If-None-Match存在时忽略If-Modified-Since
+  static bool IsNotModified(const HttpRequest &request, const HttpCachedFile &file) {
+    if (request.GetMethod() != HttpMethod::Get && request.GetMethod() != HttpMethod::Head) return false;
+    if (request.HasHeader(HttpHeaderId::IfNoneMatch)) {
+      return MatchETag(request.GetHeader(HttpHeaderId::IfNoneMatch), file.etag);
+    }
+    time_t since;
+    if (request.HasHeader(HttpHeaderId::IfModifiedSince) &&
+        ParseHttpDate(request.GetHeader(HttpHeaderId::IfModifiedSince), &since)) {
+      return file.mtime.tv_sec <= since;
+    }
+    return false;
+  }
+
+  /// If-None-Match使用弱比较，忽略"W/"前缀
+  static bool MatchETag(std::string_view list, std::string_view etag) {
+    while (!list.empty()) {
+      size_t comma = list.find(',');
+      std::string_view tag = Trim(list.substr(0, comma));
+      list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+      if (tag == "*") return true;
+      if (tag.size() > 2 && tag[0] == 'W' && tag[1] == '/') tag.remove_prefix(2);
+      if (tag == etag) return true;
+    }
+    return false;
+  }
+
+  /// 闭区间[first, last]
+  struct ByteRange {
+    size_t first;
+    size_t last;
+  };
+
+  /// 一个请求中最多的范围数，超过时忽略Range，避免大量细碎的范围放大应答
+  static constexpr size_t kMaxRanges = 16;
+
+  /// If-Range的校验值与当前文件不一致时，忽略Range返回整个文件；ETag使用强比较
+  static bool IsRangeFresh(const HttpRequest &request, const HttpCachedFile &file) {
+    if (!request.HasHeader(HttpHeaderId::IfRange)) return true;
+    std::string_view value = Trim(request.GetHeader(HttpHeaderId::IfRange));
+    if (HasPrefix(value, "\"") || HasPrefix(value, "W/")) return value == file.etag;
+    return value == file.last_modified;
+  }
+
+  /// 解析bytes单位的Range(RFC 7233 2.1)，不可满足的范围被丢弃
+  /// @return 格式错误、不是bytes单位或者范围过多时返回false，此时应当忽略Range
+  static bool ParseRange(std::string_view value, size_t size, std::vector<ByteRange> *ranges) {
+    constexpr std::string_view kBytesUnit = "bytes=";
+    if (!HasPrefix(value, kBytesUnit)) return false;
+    value.remove_prefix(kBytesUnit.size());
+    auto parse_uint = [](std::string_view s, uint64_t *v) {
+      auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), *v);
+      return !s.empty() && ec == std::errc() && end == s.data() + s.size();
+    };
+    size_t count = 0;
+    while (!value.empty()) {
+      size_t comma = value.find(',');
+      std::string_view spec = Trim(value.substr(0, comma));
+      value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+      if (spec.empty()) continue;
+      if (++count > kMaxRanges) return false;
+      size_t dash = spec.find('-');
+      if (dash == std::string_view::npos) return false;
+      uint64_t first, last;
+      if (dash == 0) {
+        // 后缀范围"-n"表示最后n个字节
+        if (!parse_uint(spec.substr(1), &last)) return false;
+        if (last == 0 || size == 0) continue;
+        ranges->push_back({size - std::min<uint64_t>(last, size), size - 1});
+        continue;
+      }
+      if (!parse_uint(spec.substr(0, dash), &first)) return false;
+      if (dash + 1 == spec.size()) {
+        last = UINT64_MAX;
+      } else if (!parse_uint(spec.substr(dash + 1), &last) || last < first) {
+        return false;
+      }
+      if (first >= size) continue;
+      ranges->push_back({first, std::min<uint64_t>(last, size - 1)});
+    }
+    return count > 0;
+  }
+
+  /// 单个范围直接作为应答体，多个范围以multipart/byteranges发送，每一部分仍然通过sendfile发送
+  static void ServeRanges(std::shared_ptr<const HttpCachedFile> file, std::string_view content_type,
+                          const std::vector<ByteRange> &ranges, HttpReply &reply) {
+    if (ranges.empty()) {
+      reply.SetStatusCode(HttpStatusCode::k416RangeNotSatisfiable);
+      reply.SetHeader(HttpHeaderId::ContentRange, fmt::format("bytes */{}", file->size));
+      return;
+    }
+    reply.SetStatusCode(HttpStatusCode::k206PartialContent);
+    int fd = file->fd;
+    if (ranges.size() == 1) {
+      const ByteRange &range = ranges[0];
+      reply.SetContentType(content_type);
+      reply.SetHeader(HttpHeaderId::ContentRange, fmt::format("bytes {}-{}/{}", range.first, range.last, file->size));
+      reply.SetFileContent({fd, static_cast<off_t>(range.first), range.last - range.first + 1, std::move(file)});
+      return;
+    }
+    thread_local std::mt19937_64 engine(std::random_device{}());
+    std::string boundary = fmt::format("{:016x}", engine());
+    reply.SetContentType("multipart/byteranges; boundary=" + boundary);
+    for (const ByteRange &range: ranges) {
+      std::string prefix = fmt::format("\r\n--{}\r\nContent-Type: {}\r\nContent-Range: bytes {}-{}/{}\r\n\r\n",
+                                       boundary, content_type, range.first, range.last, file->size);
+      reply.AddFileContent(std::move(prefix), {fd, static_cast<off_t>(range.first), range.last - range.first + 1, file});
+    }
+    reply.SetContent("\r\n--" + boundary + "--\r\n");
+  }
+
+  static void ServeFile(std::shared_ptr<const HttpCachedFile> file, std::string_view content_type, HttpReply &reply) {
+    reply.SetHeader(HttpHeaderId::AcceptRanges, "bytes");
     reply.SetContentType(content_type);
-    reply.SetContent(content);
+    int fd = file->fd;
+    size_t size = file->size;
+    reply.SetFileContent({fd, 0, size, std::move(file)});
   }
 
   void ServeDir(const fs::path &dir, HttpReply &reply) {
@@ -99,7 +311,11 @@ class HttpFileServer {
   }
 
   fs::path base_dir_;
+  std::string base_path_;   ///< 以'/'结尾的base_dir_
   std::string url_prefix_;
+  std::shared_ptr<HttpFileCache> cache_;
+  bool precompressed_;
+  std::vector<std::pair<std::string, std::string>> cache_controls_;   ///< url前缀与对应的Cache-Control，按前缀长度降序
 };
 
 } // namespace net
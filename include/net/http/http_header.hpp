@@ -0,0 +1,218 @@
+#ifndef NET_INCLUDE_NET_HTTP_HTTP_HEADER_HPP_
+#define NET_INCLUDE_NET_HTTP_HTTP_HEADER_HPP_
+
+#include "net/util/string.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace net {
+
+/// 常用的HTTP头部，解析时通过完美哈希转换为枚举值，查找时不需要比较字符串
+enum class HttpHeaderId : uint8_t {
+  Unknown,
+  Accept,
+  AcceptEncoding,
+  AcceptLanguage,
+  AcceptRanges,
+  Allow,
+  Authorization,
+  CacheControl,
+  Connection,
+  ContentEncoding,
+  ContentLength,
+  ContentRange,
+  ContentType,
+  Cookie,
+  Date,
+  ETag,
+  Expect,
+  Host,
+  IfMatch,
+  IfModifiedSince,
+  IfNoneMatch,
+  IfRange,
+  IfUnmodifiedSince,
+  KeepAlive,
+  LastModified,
+  Location,
+  Range,
+  Referer,
+  Server,
+  SetCookie,
+  TransferEncoding,
+  Upgrade,
+  UserAgent,
+  Vary,
+};
+
+inline constexpr size_t kHttpHeaderIdNum = static_cast<size_t>(HttpHeaderId::Vary) + 1;
+
+namespace detail {
+
+/// 以HttpHeaderId为下标的规范名称
+inline constexpr std::array<std::string_view, kHttpHeaderIdNum> http_header_names = {
+    "",
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Ranges",
+    "Allow",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expect",
+    "Host",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "Keep-Alive",
+    "Last-Modified",
+    "Location",
+    "Range",
+    "Referer",
+    "Server",
+    "Set-Cookie",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+    "Vary",
+};
+
+inline constexpr size_t kHttpHeaderHashSize = 128;
+
+/// 由长度、首字符与末字符(忽略大小写)组成的哈希，对上面的名称没有冲突
+constexpr size_t HttpHeaderHash(std::string_view name) {
+  return (name.size() + (name.front() | 0x20) * 25u + (name.back() | 0x20)) & (kHttpHeaderHashSize - 1);
+}
+
+constexpr std::array<HttpHeaderId, kHttpHeaderHashSize> MakeHttpHeaderHashTable() {
+  std::array<HttpHeaderId, kHttpHeaderHashSize> table{};
+  for (size_t i = 1; i < kHttpHeaderIdNum; ++i) {
+    table[HttpHeaderHash(http_header_names[i])] = static_cast<HttpHeaderId>(i);
+  }
+  return table;
+}
+
+inline constexpr std::array<HttpHeaderId, kHttpHeaderHashSize> http_header_hash_table = MakeHttpHeaderHashTable();
+
+constexpr bool IsHttpHeaderHashPerfect() {
+  for (size_t i = 1; i < kHttpHeaderIdNum; ++i) {
+    if (http_header_hash_table[HttpHeaderHash(http_header_names[i])] != static_cast<HttpHeaderId>(i)) return false;
+  }
+  return true;
+}
+static_assert(IsHttpHeaderHashPerfect(), "http header hash has collisions");
+
+} // namespace net::detail
+
+inline std::string_view ToString(HttpHeaderId id) {
+  return detail::http_header_names[static_cast<size_t>(id)];
+}
+
+/// @return 忽略大小写匹配的常用头部，不是常用头部时返回HttpHeaderId::Unknown
+inline HttpHeaderId ToHttpHeaderId(std::string_view name) {
+  if (name.empty()) return HttpHeaderId::Unknown;
+  HttpHeaderId id = detail::http_header_hash_table[detail::HttpHeaderHash(name)];
+  return EqualsIgnoreCase(name, ToString(id)) ? id : HttpHeaderId::Unknown;
+}
+
+/// 扁平的头部表，按照插入的顺序保存头部，名称的比较忽略大小写
+///
+/// 常用头部在以HttpHeaderId为下标的槽位中记录其位置，查找只需要一次数组访问；
+/// 其他头部线性查找，通常只有几个。清空时保留数组的容量，复用时不需要重新分配
+/// @tparam String 请求中为指向输入缓冲区的std::string_view，应答中为std::string
+template<typename String>
+class HttpHeaderMap {
+ public:
+  using Header = std::pair<String, String>;
+
+  HttpHeaderMap() : slots_() {}
+
+  /// @return 头部的值，不存在时返回nullptr
+  [[nodiscard]] const String *Find(HttpHeaderId id, std::string_view key) const {
+    size_t index = IndexOf(id, key);
+    return index == kNotFound ? nullptr : &headers_[index].second;
+  }
+  String *Find(HttpHeaderId id, std::string_view key) {
+    size_t index = IndexOf(id, key);
+    return index == kNotFound ? nullptr : &headers_[index].second;
+  }
+
+  [[nodiscard]] std::string_view Get(HttpHeaderId id, std::string_view default_value = {}) const {
+    const String *value = Find(id, ToString(id));
+    return value ? std::string_view(*value) : default_value;
+  }
+  [[nodiscard]] std::string_view Get(std::string_view key, std::string_view default_value = {}) const {
+    const String *value = Find(ToHttpHeaderId(key), key);
+    return value ? std::string_view(*value) : default_value;
+  }
+  [[nodiscard]] bool Has(HttpHeaderId id) const { return slots_[static_cast<size_t>(id)] != 0; }
+  [[nodiscard]] bool Has(std::string_view key) const { return Find(ToHttpHeaderId(key), key) != nullptr; }
+
+  /// 追加一个头部，不检查是否重复，重复的常用头部查找时返回第一个
+  /// @param id key对应的HttpHeaderId，调用者已经知道时可以避免重复计算
+  void Add(HttpHeaderId id, std::string_view key, std::string_view value) {
+    headers_.emplace_back(String(key), String(value));
+    if (id != HttpHeaderId::Unknown && slots_[static_cast<size_t>(id)] == 0) {
+      slots_[static_cast<size_t>(id)] = static_cast<uint32_t>(headers_.size());
+    }
+  }
+  void Add(std::string_view key, std::string_view value) { Add(ToHttpHeaderId(key), key, value); }
+
+  /// 设置头部的值，已经存在时替换
+  void Set(HttpHeaderId id, std::string_view key, std::string_view value) {
+    if (String *old_value = Find(id, key)) {
+      *old_value = String(value);
+    } else {
+      Add(id, key, value);
+    }
+  }
+  void Set(HttpHeaderId id, std::string_view value) { Set(id, ToString(id), value); }
+  void Set(std::string_view key, std::string_view value) { Set(ToHttpHeaderId(key), key, value); }
+
+  [[nodiscard]] const std::vector<Header> &GetAll() const { return headers_; }
+  /// 第index个头部，可以原地替换名称与值的存储，但名称需要与原来的相同(忽略大小写)
+  Header &At(size_t index) { return headers_[index]; }
+  [[nodiscard]] size_t Size() const { return headers_.size(); }
+  [[nodiscard]] bool Empty() const { return headers_.empty(); }
+
+  void Reserve(size_t n) { headers_.reserve(n); }
+  void Clear() {
+    headers_.clear();
+    slots_.fill(0);
+  }
+
+ private:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  [[nodiscard]] size_t IndexOf(HttpHeaderId id, std::string_view key) const {
+    if (id != HttpHeaderId::Unknown) {
+      uint32_t slot = slots_[static_cast<size_t>(id)];
+      return slot == 0 ? kNotFound : slot - 1;
+    }
+    for (size_t i = 0; i < headers_.size(); ++i) {
+      if (EqualsIgnoreCase(headers_[i].first, key)) return i;
+    }
+    return kNotFound;
+  }
+
+  std::vector<Header> headers_;
+  std::array<uint32_t, kHttpHeaderIdNum> slots_;   ///< 常用头部在headers_中的下标+1，0表示不存在
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_HTTP_HTTP_HEADER_HPP_
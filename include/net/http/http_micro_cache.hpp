@@ -0,0 +1,218 @@
+#ifndef NET_INCLUDE_NET_HTTP_HTTP_MICRO_CACHE_HPP_
+#define NET_INCLUDE_NET_HTTP_HTTP_MICRO_CACHE_HPP_
+
+#include "net/noncopyable.hpp"
+#include "net/http/http_date.hpp"
+#include "net/http/http_reply.hpp"
+#include "net/http/http_request.hpp"
+#include "net/util/thread_local_instance.hpp"
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace net {
+
+struct HttpMicroCacheOptions {
+  std::chrono::milliseconds ttl{1000};    ///< 应答缓存的时长
+  size_t max_entries = 1024;              ///< 每个Reactor最多缓存的应答数量
+  size_t max_bytes = 16 * 1024 * 1024;    ///< 每个Reactor缓存的应答的总字节数
+  size_t max_entry_size = 1024 * 1024;    ///< 序列化后超过该长度的应答不缓存
+  /// 除了请求方法与url(包括参数)之外，加入缓存键的请求头部，例如Host、Accept-Language
+  std::vector<std::string> key_headers;
+};
+
+/// 动态应答的微缓存: 在很短的时间(ttl)内，相同的请求直接发送之前序列化好的应答，不再调用处理函数
+///
+/// 缓存按Reactor线程分片，每个分片只在其所在的线程中访问，查找与插入都不需要加锁。
+/// 分片中的同一个键正在生成应答(例如在线程池中压缩)时，之后的相同请求等待其完成，
+/// 因此每个Reactor在同一时刻对同一个键最多调用一次处理函数。
+/// 只缓存GET/HEAD请求的200、301、404应答，chunked、文件、带有Set-Cookie或者
+/// Cache-Control为private/no-store/no-cache的应答不缓存
+/// @note 命中时Date替换为当前时间，其余部分与缓存时完全相同
+class HttpMicroCache : noncopyable {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Waiter = std::function<void()>;
+
+  /// 缓存的应答
+  struct Entry {
+    std::string bytes;            ///< HTTP/1.1保持连接时的完整应答
+    size_t head_size;             ///< bytes中状态行与头部(包括结尾的空行)的长度，HEAD请求只发送这一部分
+    size_t date_offset;           ///< bytes中Date值的位置，处理函数自行设置了Date时为npos
+    HttpReply reply;              ///< 需要修改Connection头部时据此重新序列化
+    Clock::time_point expire;
+  };
+
+  /// 一个Reactor线程上的分片
+  /// @note 不是线程安全的，只能在所在的线程中访问
+  class Shard : noncopyable {
+   public:
+    explicit Shard(const HttpMicroCacheOptions *options) : options_(options), bytes_(0) {}
+
+    /// @return 未命中或者已经过期时返回nullptr
+    std::shared_ptr<const Entry> Find(const std::string &key) {
+      auto it = index_.find(key);
+      if (it == index_.end()) return nullptr;
+      if (it->second->second->expire <= Clock::now()) {
+        Erase(it);
+        return nullptr;
+      }
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+
+    /// @return key是否正在生成应答
+    [[nodiscard]] bool IsFilling(const std::string &key) const { return filling_.count(key) != 0; }
+
+    /// 开始为key生成应答，之后相同的请求通过AddWaiter等待
+    void BeginFill(const std::string &key) { filling_.emplace(key, std::vector<Waiter>()); }
+
+    /// key的应答生成后调用waiter，此时可以再次查找
+    void AddWaiter(const std::string &key, Waiter waiter) { filling_[key].push_back(std::move(waiter)); }
+
+    /// 结束生成应答，entry不为空时加入缓存
+    /// @return 等待该键的请求，由调用者决定在何时调用
+    std::vector<Waiter> EndFill(const std::string &key, std::shared_ptr<const Entry> entry) {
+      std::vector<Waiter> waiters;
+      auto it = filling_.find(key);
+      if (it != filling_.end()) {
+        waiters = std::move(it->second);
+        filling_.erase(it);
+      }
+      if (entry) Put(key, std::move(entry));
+      return waiters;
+    }
+
+    /// @return 缓存的应答数量
+    [[nodiscard]] size_t Size() const { return lru_.size(); }
+    /// @return 缓存的应答的总字节数
+    [[nodiscard]] size_t Bytes() const { return bytes_; }
+
+   private:
+    using Lru = std::list<std::pair<std::string, std::shared_ptr<const Entry>>>;  ///< 最近使用的在前
+    using Index = std::unordered_map<std::string_view, Lru::iterator>;            ///< key指向lru中的键
+
+    void Put(const std::string &key, std::shared_ptr<const Entry> entry) {
+      auto it = index_.find(key);
+      if (it != index_.end()) Erase(it);
+      bytes_ += entry->bytes.size();
+      lru_.emplace_front(key, std::move(entry));
+      index_.emplace(lru_.front().first, lru_.begin());
+      while (!lru_.empty() && (lru_.size() > options_->max_entries || bytes_ > options_->max_bytes)) {
+        Erase(index_.find(lru_.back().first));
+      }
+    }
+
+    void Erase(Index::iterator it) {
+      auto pos = it->second;
+      bytes_ -= pos->second->bytes.size();
+      index_.erase(it);
+      lru_.erase(pos);
+    }
+
+    const HttpMicroCacheOptions *options_;
+    Lru lru_;
+    Index index_;
+    size_t bytes_;
+    std::unordered_map<std::string, std::vector<Waiter>> filling_;   ///< 正在生成应答的键以及等待它的请求
+  };
+
+  explicit HttpMicroCache(HttpMicroCacheOptions options = {})
+      : options_(std::make_shared<const HttpMicroCacheOptions>(std::move(options))) {}
+
+  /// @return request是否可以使用缓存
+  static bool IsCacheable(const HttpRequest &request) {
+    return request.GetMethod() == HttpMethod::Get || request.GetMethod() == HttpMethod::Head;
+  }
+
+  /// 由请求方法、url与options.key_headers生成缓存键
+  /// @param vary_encoding 应答会根据Accept-Encoding压缩时为true，将其一并加入缓存键
+  [[nodiscard]] std::string MakeKey(const HttpRequest &request, bool vary_encoding) const {
+    std::string key(ToString(request.GetMethod()));
+    key.push_back(' ');
+    key.append(request.GetUrl());
+    for (auto &name: options_->key_headers) {
+      key.push_back('\n');
+      key.append(request.GetHeader(name));
+    }
+    if (vary_encoding) {
+      key.push_back('\n');
+      key.append(request.GetHeader(HttpHeaderId::AcceptEncoding));
+    }
+    return key;
+  }
+
+  /// 序列化reply作为缓存项
+  /// @return reply不能缓存时返回nullptr
+  [[nodiscard]] std::shared_ptr<const Entry> MakeEntry(const HttpReply &reply) const {
+    HttpStatusCode status = reply.GetStatusCode();
+    if (status != HttpStatusCode::k200Ok && status != HttpStatusCode::k301MovedPermanently &&
+        status != HttpStatusCode::k404NotFound) {
+      return nullptr;
+    }
+    if (reply.IsChunked() || reply.HasFileContent() || reply.HasHeader(HttpHeaderId::SetCookie) ||
+        reply.HasHeader(HttpHeaderId::Connection)) {
+      return nullptr;
+    }
+    std::string_view cache_control = reply.GetHeader(HttpHeaderId::CacheControl);
+    for (std::string_view directive: {"private", "no-store", "no-cache"}) {
+      if (cache_control.find(directive) != std::string_view::npos) return nullptr;
+    }
+    auto entry = std::make_shared<Entry>();
+    reply.SerializeTo(entry->bytes);
+    if (entry->bytes.size() > options_->max_entry_size) return nullptr;
+    entry->head_size = entry->bytes.find("\r\n\r\n") + 4;
+    entry->date_offset = std::string::npos;
+    if (!reply.HasHeader(HttpHeaderId::Date)) {
+      std::string_view head = std::string_view(entry->bytes).substr(0, entry->head_size - 2);
+      size_t pos = head.find("\r\nDate: ");
+      if (pos != std::string_view::npos) entry->date_offset = pos + 8;
+    }
+    entry->reply = reply;
+    entry->expire = Clock::now() + options_->ttl;
+    return entry;
+  }
+
+  /// 将entry追加到output中，Date替换为当前时间
+  /// @param head_only 为true时只追加状态行与头部(HEAD请求)
+  static void AppendEntry(const Entry &entry, std::string &output, bool head_only = false) {
+    std::string_view bytes = entry.bytes;
+    if (head_only) bytes = bytes.substr(0, entry.head_size);
+    if (entry.date_offset == std::string::npos) {
+      output.append(bytes);
+      return;
+    }
+    output.append(bytes.substr(0, entry.date_offset));
+    output.append(GetHttpDateNow());
+    output.append(bytes.substr(entry.date_offset + kHttpDateSize));
+  }
+
+  /// @return 当前线程的分片，不存在则创建
+  Shard &GetLocalShard() {
+    return shards_.Get(options_).shard;
+  }
+
+  [[nodiscard]] const HttpMicroCacheOptions &GetOptions() const { return *options_; }
+
+ private:
+  /// 线程本地的分片，持有选项以保证缓存析构之后其仍然有效
+  struct LocalShard {
+    explicit LocalShard(std::shared_ptr<const HttpMicroCacheOptions> options)
+        : options(std::move(options)), shard(this->options.get()) {}
+
+    std::shared_ptr<const HttpMicroCacheOptions> options;
+    Shard shard;
+  };
+
+  std::shared_ptr<const HttpMicroCacheOptions> options_;   ///< 由缓存以及各个线程的分片共同持有
+  ThreadLocalInstance<LocalShard> shards_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_HTTP_HTTP_MICRO_CACHE_HPP_
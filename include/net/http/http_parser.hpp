@@ -3,55 +3,439 @@
 
 #include "net/http/http_request.hpp"
 #include "net/http/http_reply.hpp"
+#include "net/util/string.hpp"
+
+#include <cstring>
+#include <functional>
 
 namespace net {
 
-namespace detail {
-
-inline bool ParseRequestLine(const net::BufferPtr &buffer, HttpRequest &request) {
-  auto pos = buffer->Find(' ');
-  if (pos == nullptr) return false;
-  request.SetMethod(net::ToHttpMethod(buffer->RetriveTo(pos)));
-  buffer->HasRead(1);
-  pos = buffer->Find(' ');
-  if (pos == nullptr) return false;
-  request.SetUrl(buffer->RetriveTo(pos));
-  buffer->HasRead(1);
-  pos = buffer->Search(kCRLF);
-  if (pos == nullptr) return false;
-  request.SetVersion(net::ToHttpVersion(buffer->RetriveTo(pos)));
-  buffer->HasRead(kCRLFSize);
-  return true;
-}
-
-inline bool ParseHeaders(const net::BufferPtr &buffer, HttpRequest &request) {
-  auto end = buffer->Search(kCRLF);
-  if (!end) return false;
-  do {
-    auto pos = buffer->Find(':');
-    if (pos == nullptr) break;  // 读到了空行
-    std::string key = buffer->RetriveTo(pos);
-    buffer->HasRead(1);
-    auto first_not_space = buffer->FindIf([](char c) { return !isspace(c); });
-    buffer->HasRead(first_not_space - buffer->GetReadPtr());
-    std::string value = buffer->RetriveTo(end);
-    request.AddHeader(key, value);
-    buffer->HasRead(kCRLFSize);
-    end = buffer->Search(kCRLF);
-    if (end == nullptr) return false;
-  } while (true);
-  return true;
-}
-
-} // namespace net::detail
-
-inline bool Parse(const net::BufferPtr &buffer, HttpRequest &request) {
-  if (!detail::ParseRequestLine(buffer, request)) return false;
-  if (!detail::ParseHeaders(buffer, request)) return false;
-  buffer->HasRead(kCRLFSize); // 读取空行
-  request.SetContent(buffer->RetriveAll());
-  return true;
-}
+enum class HttpParseResult {
+  NeedMore,   ///< 数据不完整，等待更多数据后再次调用Parse
+  Complete,   ///< 已经解析出一个完整的请求
+  Error,      ///< 请求格式错误，应当关闭连接
+};
+
+/// 可恢复的增量式HTTP/1.1请求解析器，每个连接持有一个
+///
+/// 解析过程中只记录已经扫描过的位置以及各个字段在请求中的偏移，
+/// 下一次调用Parse时从该位置继续查找行尾，因此无论请求被拆分成多少次到达，总的解析时间都是O(n)。
+/// 请求体的长度由Content-Length或者chunked编码确定，没有两者的请求没有请求体，
+/// 因此同一个buffer中流水线(pipelining)发送的多个请求可以被逐个解析出来。
+///
+/// 默认情况下请求体被完整地缓存在buffer中(chunked编码的请求体在buffer中原地解码为连续的数据)，
+/// 解析完成后，请求中的url、头部以及请求体都是指向buffer的string_view(期间buffer扩容或者整理也不影响偏移)，
+/// 合并重复头部等需要新内存的数据分配在解析器的Arena中，不需要为每个字段单独分配内存。
+/// 如果HeaderCallback为某个请求返回了BodyCallback，该请求的头部被复制到Arena中，
+/// 请求体每到达一段就交给BodyCallback并从buffer中消费，上传大文件时不需要缓存整个请求体
+class HttpRequestParser : noncopyable {
+ public:
+  static constexpr size_t kDefaultMaxHeaderSize = 64 * 1024;        ///< 请求行与所有头部的最大总长度
+  static constexpr size_t kDefaultMaxBodySize = 8 * 1024 * 1024;    ///< 缓存的请求体(解码后)的最大长度
+
+  /// 流式接收请求体时，每到达一段请求体数据调用一次，参数只在回调期间有效
+  using BodyCallback = std::function<void(std::string_view)>;
+  /// 头部解析完成时调用，返回非空的BodyCallback表示以流的方式接收该请求的请求体
+  using HeaderCallback = std::function<BodyCallback(const HttpRequest &)>;
+
+  explicit HttpRequestParser(size_t max_header_size = kDefaultMaxHeaderSize,
+                             size_t max_body_size = kDefaultMaxBodySize)
+      : max_header_size_(max_header_size),
+        max_body_size_(max_body_size),
+        state_(State::RequestLine),
+        error_status_(HttpStatusCode::k400BadRequest),
+        scan_offset_(0),
+        line_begin_(0),
+        header_size_(0),
+        body_size_(0),
+        remaining_(0),
+        framing_size_(0),
+        trailer_size_(0) {
+    request_.SetArena(&arena_);
+  }
+
+  void SetHeaderCallback(HeaderCallback cb) { header_callback_ = std::move(cb); }
+
+  /// 从buffer的可读区域的起始位置继续解析
+  /// @note 返回Complete之后，请求引用buffer中的前GetRequestSize()个字节，
+  ///       处理完请求后请消费这些字节并调用Reset，再解析下一个请求
+  /// @note 缓存模式下只会修改当前请求的chunked请求体所在的区域，流式模式下会消费已经交给BodyCallback的数据
+  HttpParseResult Parse(const BufferPtr &buffer) {
+    while (state_ == State::RequestLine || state_ == State::Headers) {
+      Range line{};
+      HttpParseResult result = NextLine(buffer, max_header_size_, line);
+      if (result != HttpParseResult::Complete) {
+        if (result == HttpParseResult::Error) {
+          error_status_ = HttpStatusCode::k431RequestHeaderFieldsTooLarge;
+        }
+        return result;
+      }
+      const char *begin = buffer->GetReadPtr();
+      bool ok = state_ == State::RequestLine ? ParseRequestLine(begin, line) : ParseHeaderLine(begin, line);
+      if (!ok) {
+        return Fail(HttpStatusCode::k400BadRequest);
+      }
+    }
+    if (state_ == State::HeadersComplete && !OnHeadersComplete(buffer)) {
+      return HttpParseResult::Error;
+    }
+    HttpParseResult result = ParseBody(buffer);
+    if (body_callback_) {
+      // 流式模式下已经交付的数据不再需要，偏移相应地前移
+      buffer->HasRead(line_begin_);
+      scan_offset_ -= line_begin_;
+      line_begin_ = 0;
+      header_size_ = 0;
+    }
+    if (result == HttpParseResult::Complete && state_ != State::Complete) {
+      state_ = State::Complete;
+      Materialize(buffer->GetReadPtr());
+    }
+    return result;
+  }
+
+  /// 重置解析状态，准备解析下一个请求，同时释放Arena中的数据
+  void Reset() {
+    state_ = State::RequestLine;
+    error_status_ = HttpStatusCode::k400BadRequest;
+    scan_offset_ = 0;
+    line_begin_ = 0;
+    header_size_ = 0;
+    body_size_ = 0;
+    remaining_ = 0;
+    framing_size_ = 0;
+    trailer_size_ = 0;
+    header_range_vec_.clear();
+    body_callback_ = nullptr;
+    request_.Clear();
+    arena_.Reset();
+  }
+
+  [[nodiscard]] HttpRequest &GetRequest() { return request_; }
+  [[nodiscard]] bool IsComplete() const { return state_ == State::Complete; }
+  /// @return 请求的头部是否已经解析完成，此后GetRequest中的请求行与头部有效
+  [[nodiscard]] bool IsHeadersComplete() const {
+    return state_ != State::RequestLine && state_ != State::Headers && state_ != State::Error;
+  }
+  /// @return 请求体是否以流的方式交给了BodyCallback
+  [[nodiscard]] bool IsStreaming() const { return body_callback_ != nullptr; }
+  /// @return Content-Length是否不超过缓存的请求体的最大长度，chunked编码的请求体在接收时检查，总是返回true
+  /// @note 只在HeaderCallback中有效，超过时HeaderCallback返回之后解析失败(413)，除非以流的方式接收请求体
+  [[nodiscard]] bool IsBodySizeAllowed() const { return state_ != State::Body || remaining_ <= max_body_size_; }
+  /// @return Parse返回Error时，应当回复的状态码
+  [[nodiscard]] HttpStatusCode GetErrorStatus() const { return error_status_; }
+  /// @return 请求行与头部(包括结尾的空行)的总长度，在Parse返回Complete之后有效，流式模式下为0(已经被消费)
+  [[nodiscard]] size_t GetHeaderSize() const { return header_size_; }
+  /// @return 整个请求在buffer中的长度，在Parse返回Complete之后有效，
+  ///         处理完请求之后从buffer中消费这么多字节，剩余的数据属于下一个请求
+  [[nodiscard]] size_t GetRequestSize() const { return line_begin_; }
+
+ private:
+  enum class State {
+    RequestLine,
+    Headers,
+    HeadersComplete,
+    Body,             ///< Content-Length确定长度的请求体
+    ChunkSize,
+    ChunkData,
+    ChunkDataEnd,     ///< 数据块之后的CRLF
+    Trailers,
+    Complete,
+    Error,
+  };
+
+  /// 相对于buffer可读区域起始位置的偏移，buffer扩容或整理之后仍然有效
+  struct Range {
+    size_t offset;
+    size_t size;
+
+    [[nodiscard]] std::string_view Resolve(const char *base) const { return {base + offset, size}; }
+  };
+
+  HttpParseResult Fail(HttpStatusCode status) {
+    state_ = State::Error;
+    error_status_ = status;
+    return HttpParseResult::Error;
+  }
+
+  /// 从line_begin_开始取出下一行(不包括行尾的CRLF或LF)
+  /// @return 找到完整的行返回Complete，行长度超过max_line_size时返回Error
+  HttpParseResult NextLine(const BufferPtr &buffer, size_t max_line_size, Range &line) {
+    const char *begin = buffer->GetReadPtr();
+    size_t readable = buffer->ReadableBytes();
+    const void *eol = scan_offset_ < readable ?
+                      memchr(begin + scan_offset_, '\n', readable - scan_offset_) : nullptr;
+    if (eol == nullptr) {
+      scan_offset_ = readable;
+      if (readable > max_line_size) {
+        state_ = State::Error;
+        return HttpParseResult::Error;
+      }
+      return HttpParseResult::NeedMore;
+    }
+    size_t line_end = static_cast<const char *>(eol) - begin;
+    if (line_end + 1 > max_line_size) {
+      state_ = State::Error;
+      return HttpParseResult::Error;
+    }
+    line = {line_begin_, line_end - line_begin_};
+    if (line.size > 0 && begin[line_end - 1] == '\r') {
+      --line.size;
+    }
+    line_begin_ = scan_offset_ = line_end + 1;
+    return HttpParseResult::Complete;
+  }
+
+  /// METHOD SP URL SP VERSION
+  bool ParseRequestLine(const char *base, Range range) {
+    std::string_view line = range.Resolve(base);
+    if (line.empty()) return true;  // RFC 7230: 请求行之前的空行应当被忽略
+    size_t first_space = line.find(' ');
+    if (first_space == std::string_view::npos) return false;
+    size_t last_space = line.rfind(' ');
+    if (last_space == first_space) return false;
+    HttpMethod method = net::ToHttpMethod(line.substr(0, first_space));
+    HttpVersion version = net::ToHttpVersion(line.substr(last_space + 1));
+    if (method == HttpMethod::Invalid || version == HttpVersion::Invalid) return false;
+    if (last_space == first_space + 1) return false;  // url为空
+    request_.SetMethod(method);
+    request_.SetVersion(version);
+    url_range_ = {range.offset + first_space + 1, last_space - first_space - 1};
+    state_ = State::Headers;
+    return true;
+  }
+
+  /// field-name ":" OWS field-value OWS，空行表示头部结束
+  bool ParseHeaderLine(const char *base, Range range) {
+    std::string_view line = range.Resolve(base);
+    if (line.empty()) {
+      state_ = State::HeadersComplete;
+      header_size_ = line_begin_;
+      return true;
+    }
+    size_t colon = line.find(':');
+    if (colon == 0 || colon == std::string_view::npos) return false;
+    if (line[colon - 1] == ' ' || line[colon - 1] == '\t') return false;  // 字段名与冒号之间不允许有空白
+    Range key{range.offset, colon};
+    size_t value_begin = line.find_first_not_of(" \t", colon + 1);
+    Range value{range.offset + line.size(), 0};
+    if (value_begin != std::string_view::npos) {
+      size_t value_end = line.find_last_not_of(" \t") + 1;
+      value = {range.offset + value_begin, value_end - value_begin};
+    }
+    // 常用头部在解析时就转换为HttpHeaderId，之后的查找不需要再比较字符串
+    header_range_vec_.push_back({ToHttpHeaderId(key.Resolve(base)), key, value});
+    return true;
+  }
+
+  /// 根据Content-Length与Transfer-Encoding确定请求体的编码方式，并决定是否以流的方式接收请求体
+  bool OnHeadersComplete(const BufferPtr &buffer) {
+    const char *base = buffer->GetReadPtr();
+    bool has_length = false;
+    bool chunked = false;
+    size_t content_length = 0;
+    for (auto &[id, key_range, value_range]: header_range_vec_) {
+      std::string_view value = value_range.Resolve(base);
+      if (id == HttpHeaderId::TransferEncoding) {
+        // 只支持chunked作为最后一个编码，其他编码无法确定请求体的边界
+        size_t comma = value.rfind(',');
+        std::string_view last = comma == std::string_view::npos ? value : value.substr(comma + 1);
+        last.remove_prefix(std::min(last.find_first_not_of(" \t"), last.size()));
+        if (!EqualsIgnoreCase(last, "chunked")) {
+          Fail(HttpStatusCode::k501NotImplemented);
+          return false;
+        }
+        chunked = true;
+      } else if (id == HttpHeaderId::ContentLength) {
+        size_t length = 0;
+        if (!ParseContentLength(value, length) || (has_length && length != content_length)) {
+          // 多个不一致的Content-Length会导致请求边界有歧义(请求走私)，直接拒绝
+          Fail(HttpStatusCode::k400BadRequest);
+          return false;
+        }
+        content_length = length;
+        has_length = true;
+      }
+    }
+    if (chunked && has_length) {
+      // RFC 7230 3.3.3: 同时存在时可能是请求走私，直接拒绝
+      Fail(HttpStatusCode::k400BadRequest);
+      return false;
+    }
+    state_ = chunked ? State::ChunkSize : State::Body;
+    remaining_ = content_length;
+
+    if (header_callback_) {
+      Materialize(base);
+      // 请求头之后的数据都可能被消费，因此流式模式下头部需要复制到Arena中
+      BodyCallback body_callback = header_callback_(request_);
+      if (body_callback) {
+        request_.RelocateUrl(arena_.Copy(request_.GetUrl()));
+        auto &headers = request_.GetMutableHeaders();
+        for (size_t i = 0; i < headers.Size(); ++i) {
+          auto &[key, value] = headers.At(i);
+          key = arena_.Copy(key);
+          value = arena_.Copy(value);
+        }
+        body_callback_ = std::move(body_callback);
+      }
+    }
+    // 流式接收的请求体不占用内存，长度由BodyCallback自行限制
+    if (!body_callback_ && content_length > max_body_size_) {
+      Fail(HttpStatusCode::k413PayloadTooLarge);
+      return false;
+    }
+    return true;
+  }
+
+  static bool ParseContentLength(std::string_view value, size_t &length) {
+    if (value.empty() || value.size() > 18) return false;
+    length = 0;
+    for (char c: value) {
+      if (c < '0' || c > '9') return false;
+      length = length * 10 + (c - '0');
+    }
+    return true;
+  }
+
+  /// 解析请求体，请求体的数据在缓存模式下移动到头部之后使其连续，流式模式下交给BodyCallback
+  HttpParseResult ParseBody(const BufferPtr &buffer) {
+    while (true) {
+      switch (state_) {
+        case State::Body:
+        case State::ChunkData: {
+          size_t n = std::min(remaining_, buffer->ReadableBytes() - line_begin_);
+          DeliverBody(buffer, n);
+          remaining_ -= n;
+          if (remaining_ > 0) return HttpParseResult::NeedMore;
+          if (state_ == State::Body) return HttpParseResult::Complete;
+          state_ = State::ChunkDataEnd;
+          break;
+        }
+        case State::ChunkSize:
+        case State::ChunkDataEnd:
+        case State::Trailers: {
+          Range range{};
+          size_t line_begin = line_begin_;
+          HttpParseResult result = NextLine(buffer, line_begin_ + kMaxChunkLineSize, range);
+          if (result == HttpParseResult::NeedMore) return result;
+          if (result == HttpParseResult::Error) return Fail(HttpStatusCode::k400BadRequest);
+          // 缓存模式下数据块的分隔与尾部头部都留在buffer中，直到请求结束，需要限制其总长度
+          if (state_ == State::Trailers) {
+            trailer_size_ += line_begin_ - line_begin;
+            if (header_size_ + trailer_size_ > max_header_size_) {
+              return Fail(HttpStatusCode::k431RequestHeaderFieldsTooLarge);
+            }
+          } else {
+            framing_size_ += line_begin_ - line_begin;
+            if (!body_callback_ && framing_size_ > max_body_size_) {
+              return Fail(HttpStatusCode::k413PayloadTooLarge);
+            }
+          }
+          std::string_view line = range.Resolve(buffer->GetReadPtr());
+          if (state_ == State::ChunkDataEnd) {
+            if (!line.empty()) return Fail(HttpStatusCode::k400BadRequest);
+            state_ = State::ChunkSize;
+          } else if (state_ == State::Trailers) {
+            // 尾部头部被忽略，空行表示请求结束
+            if (line.empty()) return HttpParseResult::Complete;
+          } else {
+            size_t chunk_size = 0;
+            if (!ParseChunkSize(line, chunk_size)) return Fail(HttpStatusCode::k400BadRequest);
+            if (!body_callback_ && chunk_size > max_body_size_ - body_size_) {
+              return Fail(HttpStatusCode::k413PayloadTooLarge);
+            }
+            remaining_ = chunk_size;
+            state_ = chunk_size == 0 ? State::Trailers : State::ChunkData;
+          }
+          break;
+        }
+        case State::Complete:
+          return HttpParseResult::Complete;
+        default:
+          return HttpParseResult::Error;
+      }
+    }
+  }
+
+  /// chunk-size [ chunk-ext ]，chunk-size为十六进制
+  static bool ParseChunkSize(std::string_view line, size_t &size) {
+    size_t end = std::min(line.find_first_of("; \t"), line.size());
+    if (end == 0 || end > 15) return false;
+    size = 0;
+    for (size_t i = 0; i < end; ++i) {
+      char c = line[i];
+      int digit;
+      if (c >= '0' && c <= '9') digit = c - '0';
+      else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+      else return false;
+      size = size * 16 + digit;
+    }
+    return true;
+  }
+
+  /// 交付从line_begin_开始的n字节请求体数据
+  void DeliverBody(const BufferPtr &buffer, size_t n) {
+    if (n == 0) return;
+    char *base = buffer->GetReadPtr();
+    if (body_callback_) {
+      body_callback_({base + line_begin_, n});
+    } else if (header_size_ + body_size_ != line_begin_) {
+      // chunked编码的数据块之间有分隔，向前移动使请求体连续
+      memmove(base + header_size_ + body_size_, base + line_begin_, n);
+    }
+    body_size_ += n;
+    line_begin_ += n;
+    scan_offset_ = line_begin_;
+  }
+
+  /// 根据记录的偏移生成指向buffer的string_view
+  void Materialize(const char *base) {
+    if (body_callback_) return;  // 流式模式下头部已经复制到Arena中，没有缓存的请求体
+    request_.RelocateUrl(url_range_.Resolve(base));  // buffer扩容之后路径参数也需要指向新的位置
+    auto &headers = request_.GetMutableHeaders();
+    headers.Clear();
+    for (auto &[id, key_range, value_range]: header_range_vec_) {
+      std::string_view key = key_range.Resolve(base);
+      std::string_view value = value_range.Resolve(base);
+      if (std::string_view *old_value = headers.Find(id, key)) {
+        // RFC 7230 3.2.2: 重复的头部等价于以逗号连接的一个头部
+        *old_value = arena_.Concat({*old_value, ", ", value});
+      } else {
+        headers.Add(id, key, value);
+      }
+    }
+    request_.SetContent({base + header_size_, body_size_});
+  }
+
+  static constexpr size_t kMaxChunkLineSize = 4096;   ///< 数据块大小行以及尾部头部的最大长度
+
+  size_t max_header_size_;
+  size_t max_body_size_;
+  State state_;
+  HttpStatusCode error_status_;
+  size_t scan_offset_;    ///< 已经扫描过(确认不包含'\n')的字节数
+  size_t line_begin_;     ///< 当前行的起始偏移，也是已经解析的数据的总长度
+  size_t header_size_;    ///< 请求行与头部的总长度，缓存模式下解码后的请求体紧接在其后
+  size_t body_size_;      ///< 已经解码的请求体长度
+  size_t remaining_;      ///< 当前Content-Length请求体或者数据块中尚未到达的字节数
+  size_t framing_size_;   ///< chunked编码中数据块大小行与数据块之后的行尾的总长度
+  size_t trailer_size_;   ///< chunked编码的尾部头部的总长度
+  Range url_range_{};
+  /// 解析头部时记录的位置
+  struct HeaderRange {
+    HttpHeaderId id;
+    Range key;
+    Range value;
+  };
+
+  std::vector<HeaderRange> header_range_vec_;
+  HeaderCallback header_callback_;
+  BodyCallback body_callback_;
+  Arena arena_;
+  HttpRequest request_;
+};
 
 // TODO: bool Parse(const net::BufferPtr &buffer, HttpReply &reply)
 
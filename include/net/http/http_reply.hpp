@@ -3,11 +3,22 @@
 
 #include "net/buffer.hpp"
 #include "net/http/common.hpp"
+#include "net/http/http_chunked_writer.hpp"
+#include "net/http/http_date.hpp"
+#include "net/http/http_header.hpp"
 
-#include <map>
+#include <charconv>
 
 namespace net {
 
+/// 作为应答体的一段文件，由连接通过sendfile发送
+struct HttpFileRegion {
+  int fd = -1;
+  off_t offset = 0;
+  size_t length = 0;
+  std::shared_ptr<const void> holder;   ///< 在发送完之前持有，保证fd不被关闭
+};
+
 class HttpReply {
  public:
   HttpReply() : version_(HttpVersion::Invalid), status_code_(HttpStatusCode::kUnknown) {}
@@ -20,81 +31,141 @@ class HttpReply {
 
   [[nodiscard]] std::string GetStatusMessage() const { return net::ToString(status_code_); }
 
-  [[nodiscard]] const std::string &GetHeader(const std::string &key,
-                                             const std::string &default_value = "") const {
-    auto pos = headers_.find(key);
-    if (pos != headers_.end()) {
-      return pos->second;
-    } else {
-      return default_value;
-    }
+  /// @note 头部名称的比较忽略大小写
+  [[nodiscard]] std::string_view GetHeader(std::string_view key, std::string_view default_value = {}) const {
+    return headers_.Get(key, default_value);
   }
-  void SetHeader(const std::string &key, const std::string &value) {
-    headers_[key] = value;
+  [[nodiscard]] std::string_view GetHeader(HttpHeaderId id, std::string_view default_value = {}) const {
+    return headers_.Get(id, default_value);
   }
+  [[nodiscard]] bool HasHeader(std::string_view key) const { return headers_.Has(key); }
+  [[nodiscard]] bool HasHeader(HttpHeaderId id) const { return headers_.Has(id); }
+  /// 设置头部的值，已经存在时替换
+  void SetHeader(std::string_view key, std::string_view value) { headers_.Set(key, value); }
+  /// 以规范名称设置常用头部
+  void SetHeader(HttpHeaderId id, std::string_view value) { headers_.Set(id, value); }
+  [[nodiscard]] const std::vector<HttpHeaderMap<std::string>::Header> &GetHeaders() const { return headers_.GetAll(); }
 
   void SetContentType(std::string_view content_type) {
-    headers_[kContentTypeField] = content_type;
+    headers_.Set(HttpHeaderId::ContentType, content_type);
   }
 
   [[nodiscard]] const std::string &GetContent() const { return content_; }
+  /// @return content_是否单独作为应答体发送
+  [[nodiscard]] bool HasContent() const {
+    return !IsChunked() && !HasFileContent() && !IsBodilessStatus(status_code_);
+  }
   void SetContent(const std::string &content) { content_ = content; }
 
-  std::string SerializedToString() {
-    AddConnectionField();
-    AddContentLengthField();
-    std::string str;
-    str.append(net::ToString(version_));
-    str.append(" ");
-    str.append(std::to_string(static_cast<int>(status_code_)));
-    str.append(" ");
-    str.append(net::ToString(status_code_));
-    str.append(kCRLF);
-    for (auto &[key, value]: headers_) {
-      str.append(key);
-      str.append(": ");
-      str.append(value);
-      str.append(kCRLF);
+  /// 应答体中的一段文件，以及在其之前发送的数据(例如multipart/byteranges中每一部分的头部)
+  using FilePart = std::pair<std::string, HttpFileRegion>;
+
+  /// 以文件中的一段作为应答体，发送时不经过用户态，之前SetContent设置的内容被清空
+  void SetFileContent(HttpFileRegion file) {
+    content_.clear();
+    files_.clear();
+    files_.emplace_back(std::string(), std::move(file));
+  }
+  /// 在应答体中追加先发送的prefix与之后的一段文件
+  /// @note 存在文件时，SetContent设置的内容作为结尾在所有文件之后发送
+  void AddFileContent(std::string prefix, HttpFileRegion file) {
+    files_.emplace_back(std::move(prefix), std::move(file));
+  }
+  [[nodiscard]] bool HasFileContent() const { return !files_.empty(); }
+  [[nodiscard]] const std::vector<FilePart> &GetFileContents() const { return files_; }
+
+  /// 以chunked编码流式发送应答体，状态行与头部在处理函数返回后立即发送，不再设置Content-Length
+  /// @note 请在调用之前设置好状态码与头部，之后通过返回的写入器发送应答体，SetContent设置的内容将被忽略
+  std::shared_ptr<HttpChunkedWriter> BeginChunked() {
+    if (!chunked_writer_) {
+      chunked_writer_ = std::make_shared<HttpChunkedWriter>();
     }
-    str.append(kCRLF);
-    str.append(content_);
-    return str;
+    return chunked_writer_;
   }
-
-  void SerializedToString(const BufferPtr &buffer) {
-    AddConnectionField();
-    AddContentLengthField();
-    buffer->Append(net::ToString(version_));
-    buffer->Append(" ");
-    buffer->Append(std::to_string(static_cast<int>(status_code_)));
-    buffer->Append(" ");
-    buffer->Append(net::ToString(status_code_));
-    buffer->Append(kCRLF);
-    for (auto &[key, value]: headers_) {
-      buffer->Append(key);
-      buffer->Append(": ");
-      buffer->Append(value);
-      buffer->Append(kCRLF);
+  [[nodiscard]] bool IsChunked() const { return chunked_writer_ != nullptr; }
+  [[nodiscard]] const std::shared_ptr<HttpChunkedWriter> &GetChunkedWriter() const { return chunked_writer_; }
+
+  /// 将状态行与头部(包括结尾的空行)追加到output中
+  ///
+  /// 状态行使用预先生成的字符串，Content-Length在栈上格式化，Date使用每个线程缓存的值，
+  /// 只有output的容量不足时才会分配内存(连接复用output时通常不需要)
+  /// @note Content-Length总是由应答体的长度决定，SetHeader设置的值将被忽略；304等不能包含应答体的状态码不发送Content-Length
+  template<typename Output>
+  void SerializeHeadTo(Output &output) const {
+    char length_buf[24];
+    std::string_view content_length;
+    if (!IsChunked() && !IsBodilessStatus(status_code_)) {  // 应答体的长度由chunked编码或者关闭连接确定
+      size_t length = content_.size();
+      if (HasFileContent()) {
+        for (auto &[prefix, file]: files_) {
+          length += prefix.size() + file.length;
+        }
+      }
+      auto [end, ec] = std::to_chars(length_buf, length_buf + sizeof(length_buf), length);
+      content_length = std::string_view(length_buf, end - length_buf);
     }
-    buffer->Append(kCRLF);
-    buffer->Append(content_);
+    std::string_view date = headers_.Has(HttpHeaderId::Date) ? std::string_view() : GetHttpDateNow();
+    std::string_view status_line = GetStatusLine(version_, status_code_);
+
+    auto field_size = [](std::string_view key, std::string_view value) {
+      return key.size() + 2 + value.size() + kCRLFSize;
+    };
+    size_t size = status_line.size() + kCRLFSize;
+    if (!content_length.empty()) size += field_size(kContentLengthField, content_length);
+    if (!date.empty()) size += field_size(ToString(HttpHeaderId::Date), date);
+    for (auto &[key, value]: headers_.GetAll()) {
+      size += field_size(key, value);
+    }
+    Reserve(output, size);
+
+    Append(output, status_line);
+    auto append_field = [&output](std::string_view key, std::string_view value) {
+      Append(output, key);
+      Append(output, ": ");
+      Append(output, value);
+      Append(output, kCRLF);
+    };
+    const std::string *ignored_length = headers_.Find(HttpHeaderId::ContentLength, kContentLengthField);
+    for (auto &[key, value]: headers_.GetAll()) {
+      if (&value != ignored_length) {
+        append_field(key, value);
+      }
+    }
+    if (!date.empty()) append_field(ToString(HttpHeaderId::Date), date);
+    if (!content_length.empty()) append_field(kContentLengthField, content_length);
+    Append(output, kCRLF);
   }
 
- private:
-  void AddContentLengthField() {
-    headers_[kContentLengthField] = std::to_string(content_.size());
+  /// 将整个应答追加到output中
+  /// @note 应答体包含文件时只追加状态行与头部，应答体需要另外发送
+  template<typename Output>
+  void SerializeTo(Output &output) const {
+    SerializeHeadTo(output);
+    if (HasContent()) Append(output, content_);
   }
 
-  void AddConnectionField() {
-    if (!headers_[kConnectionField].empty()) {
-      headers_[kConnectionField] = kConnectionKeepAlive;
-    }
+  [[nodiscard]] std::string SerializedToString() const {
+    std::string str;
+    SerializeTo(str);
+    return str;
+  }
+
+  void SerializedToString(const BufferPtr &buffer) const {
+    SerializeTo(*buffer);
   }
 
+ private:
+  static void Reserve(std::string &output, size_t n) { output.reserve(output.size() + n); }
+  static void Reserve(Buffer &output, size_t n) { output.EnsureWritableBytes(n); }
+  static void Append(std::string &output, std::string_view s) { output.append(s); }
+  static void Append(Buffer &output, std::string_view s) { output.Append(s); }
+
   HttpVersion version_;
   HttpStatusCode status_code_;
-  std::map<std::string, std::string> headers_;
+  HttpHeaderMap<std::string> headers_;
   std::string content_;
+  std::vector<FilePart> files_;
+  std::shared_ptr<HttpChunkedWriter> chunked_writer_;
 };
 
 }
@@ -3,55 +3,108 @@
 
 #include "net/buffer.hpp"
 #include "net/http/common.hpp"
+#include "net/http/http_header.hpp"
+#include "net/util/arena.hpp"
 
-#include <map>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <vector>
 
 // TODO: 支持form解析
 
 namespace net {
 
+/// HTTP请求，url、头部以及请求体都是string_view，不拥有数据
+///
+/// 由HttpRequestParser解析得到的请求指向连接输入缓冲区中尚未消费的区域，
+/// 需要规范化的数据(例如合并后的重复头部)存放在解析器的Arena中，两者都在处理完该请求之后失效
 class HttpRequest {
  public:
-  HttpRequest() : method_(HttpMethod::Invalid), version_(HttpVersion::Invalid) {}
+  using Header = HttpHeaderMap<std::string_view>::Header;
+  using PathParam = std::pair<std::string_view, std::string_view>;   ///< 路由匹配到的路径参数，名称与值
+
+  HttpRequest() : method_(HttpMethod::Invalid), version_(HttpVersion::Invalid), arena_(nullptr) {}
 
   [[nodiscard]] HttpMethod GetMethod() const { return method_; }
   void SetMethod(HttpMethod method) { method_ = method; }
 
-  [[nodiscard]] const std::string &GetUrl() const { return url_; }
-  void SetUrl(const std::string &url) { url_ = url; }
+  [[nodiscard]] std::string_view GetUrl() const { return url_; }
+  /// @note url需要在请求的生命周期内有效
+  void SetUrl(std::string_view url) { url_ = url; }
 
-  [[nodiscard]] std::string GetRouteUrl() const {
-    auto pos = url_.find('?');
-    return url_.substr(0, pos);
+  /// @return url中'?'之前的路径部分
+  [[nodiscard]] std::string_view GetRouteUrl() const {
+    return url_.substr(0, url_.find('?'));
   }
 
-  [[nodiscard]] std::string GetRawParams() const {
+  /// @return url中'?'之后的查询参数部分
+  [[nodiscard]] std::string_view GetRawParams() const {
     auto pos = url_.find('?');
-    return pos == std::string::npos ? "" : url_.substr(pos + 1);
+    return pos == std::string_view::npos ? std::string_view() : url_.substr(pos + 1);
+  }
+
+  /// 替换url的存储位置(例如复制到Arena中)，已经匹配到的路径参数随之指向新的url
+  /// @note url的内容需要与原来的相同
+  void RelocateUrl(std::string_view url) {
+    for (auto &param: path_params_) {
+      param.second = url.substr(param.second.data() - url_.data(), param.second.size());
+    }
+    url_ = url;
   }
 
+  /// @return 路由中":name"或者"*name"匹配到的路径参数，不存在时返回default_value
+  [[nodiscard]] std::string_view GetPathParam(std::string_view name, std::string_view default_value = {}) const {
+    for (auto &[k, v]: path_params_) {
+      if (k == name) return v;
+    }
+    return default_value;
+  }
+  [[nodiscard]] const std::vector<PathParam> &GetPathParams() const { return path_params_; }
+  /// 由HttpRoute在匹配时填充，值指向url
+  std::vector<PathParam> &GetMutablePathParams() { return path_params_; }
+
   [[nodiscard]] HttpVersion GetVersion() const { return version_; }
   void SetVersion(HttpVersion version) { version_ = version; }
 
-  [[nodiscard]] const std::string &GetHeader(const std::string &key,
-                                             const std::string &default_value = "") const {
-    auto pos = headers_.find(key);
-    if (pos != headers_.end()) {
-      return pos->second;
-    } else {
-      return default_value;
-    }
+  /// @note 头部名称的比较忽略大小写
+  [[nodiscard]] std::string_view GetHeader(std::string_view key, std::string_view default_value = {}) const {
+    return headers_.Get(key, default_value);
   }
-  void AddHeader(const std::string &key, const std::string &value) {
-    headers_[key] = value;
+  /// 常用头部的O(1)查找
+  [[nodiscard]] std::string_view GetHeader(HttpHeaderId id, std::string_view default_value = {}) const {
+    return headers_.Get(id, default_value);
+  }
+  [[nodiscard]] bool HasHeader(std::string_view key) const { return headers_.Has(key); }
+  [[nodiscard]] bool HasHeader(HttpHeaderId id) const { return headers_.Has(id); }
+  /// 追加一个头部，不检查是否重复
+  /// @note key和value需要在请求的生命周期内有效
+  void AddHeader(std::string_view key, std::string_view value) { headers_.Add(key, value); }
+  /// 设置头部的值，已经存在时替换
+  void SetHeader(std::string_view key, std::string_view value) { headers_.Set(key, value); }
+  [[nodiscard]] const std::vector<Header> &GetHeaders() const { return headers_.GetAll(); }
+  /// 由HttpRequestParser在解析时填充，值指向输入缓冲区或者Arena
+  HttpHeaderMap<std::string_view> &GetMutableHeaders() { return headers_; }
+  void ClearHeaders() { headers_.Clear(); }
+
+  [[nodiscard]] std::string_view GetContent() const { return content_; }
+  /// @note content需要在请求的生命周期内有效
+  void SetContent(std::string_view content) { content_ = content; }
+
+  /// @return 请求所属的Arena，处理请求时可以在其中分配与请求生命周期相同的数据，可能为nullptr
+  [[nodiscard]] Arena *GetArena() const { return arena_; }
+  void SetArena(Arena *arena) { arena_ = arena; }
+
+  /// 清空请求以便复用，保留头部与路径参数数组的容量
+  void Clear() {
+    method_ = HttpMethod::Invalid;
+    url_ = {};
+    path_params_.clear();
+    version_ = HttpVersion::Invalid;
+    headers_.Clear();
+    content_ = {};
   }
 
-  [[nodiscard]] const std::string &GetContent() const { return content_; }
-  void SetContent(const std::string &content) { content_ = content; }
-
-  std::string SerializedToString() {
+  [[nodiscard]] std::string SerializedToString() const {
     std::string str;
     str.append(net::ToString(method_));
     str.append(" ");
@@ -59,7 +112,7 @@ class HttpRequest {
     str.append(" ");
     str.append(net::ToString(version_));
     str.append(kCRLF);
-    for (auto &[key, value]: headers_) {
+    for (auto &[key, value]: headers_.GetAll()) {
       str.append(key);
       str.append(": ");
       str.append(value);
@@ -70,14 +123,14 @@ class HttpRequest {
     return str;
   }
 
-  void SerializedToString(const BufferPtr &buffer) {
+  void SerializedToString(const BufferPtr &buffer) const {
     buffer->Append(net::ToString(method_));
     buffer->Append(" ");
     buffer->Append(url_);
     buffer->Append(" ");
     buffer->Append(net::ToString(version_));
     buffer->Append(kCRLF);
-    for (auto &[key, value]: headers_) {
+    for (auto &[key, value]: headers_.GetAll()) {
       buffer->Append(key);
       buffer->Append(": ");
       buffer->Append(value);
@@ -89,10 +142,12 @@ class HttpRequest {
 
  private:
   HttpMethod method_;
-  std::string url_;
+  std::string_view url_;
+  std::vector<PathParam> path_params_;
   HttpVersion version_;
-  std::map<std::string, std::string> headers_;
-  std::string content_;
+  HttpHeaderMap<std::string_view> headers_;
+  std::string_view content_;
+  Arena *arena_;
 };
 
 } // namespace net
@@ -1,41 +1,288 @@
 #ifndef NET_INCLUDE_NET_HTTP_HTTP_ROUTE_HPP_
 #define NET_INCLUDE_NET_HTTP_HTTP_ROUTE_HPP_
 
+#include "net/log.hpp"
+#include "net/http/http_micro_cache.hpp"
 #include "net/http/http_request.hpp"
 #include "net/http/http_reply.hpp"
 #include "net/util/string.hpp"
+#include "net/util/thread_pool.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
 
 namespace net {
 
-// 非常简陋的实现，只支持绝对匹配
-// TODO: 采用RadixTree
+/// 流式接收请求体的处理器，每个请求创建一个，处理器内部的状态(例如正在写入的文件)可以由两个回调共同捕获
+struct HttpBodyReader {
+  std::function<void(std::string_view)> on_data;                   ///< 每到达一段请求体数据调用一次
+  std::function<void(const HttpRequest &, HttpReply &)> on_complete;  ///< 请求体接收完毕后生成应答
+};
 
-class HttpRoute {
+/// 延迟应答的完成令牌，由HttpServer创建并交给延迟处理函数
+///
+/// 可以复制，在任意线程中调用Reply完成应答，只有第一次调用有效；应答回到连接所在的Reactor线程中补充头部并发送，
+/// 与同一连接上pipelining的其他请求保持顺序。所有副本都析构时仍未完成的请求回复500，连接不会一直等待
+class HttpDeferredReply {
  public:
+  using Callback = std::function<void(HttpReply &&)>;
+
+  HttpDeferredReply() = default;
+  explicit HttpDeferredReply(Callback callback) : state_(std::make_shared<State>(std::move(callback))) {}
+
+  /// 完成应答，没有设置状态码时为200 OK
+  /// @return 已经完成过时返回false
+  bool Reply(HttpReply reply) const {
+    return state_ && state_->Complete(std::move(reply));
+  }
+
+  [[nodiscard]] bool IsDone() const {
+    return !state_ || state_->done.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct State {
+    explicit State(Callback callback) : callback(std::move(callback)) {}
+    ~State() {
+      HttpReply reply;
+      reply.SetStatusCode(HttpStatusCode::k500InternalServerError);
+      Complete(std::move(reply));
+    }
+
+    bool Complete(HttpReply &&reply) {
+      if (done.exchange(true, std::memory_order_acq_rel)) return false;
+      // 回调持有的连接等资源在调用之后立即释放
+      Callback cb = std::move(callback);
+      cb(std::move(reply));
+      return true;
+    }
+
+    Callback callback;
+    std::atomic<bool> done{false};
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+/// 路由到的处理函数，handle、stream与deferred三者之一非空
+struct HttpHandler {
   using HandleFunction = std::function<void(const HttpRequest &, HttpReply &)>;
+  /// 头部解析完成后调用，请求头在整个请求期间有效，请求体为空
+  using StreamHandleFunction = std::function<HttpBodyReader(const HttpRequest &)>;
+  /// 通过HttpDeferredReply稍后完成应答，请求在应答完成之前有效
+  using DeferredHandleFunction = std::function<void(const HttpRequest &, HttpDeferredReply)>;
+
+  [[nodiscard]] bool Empty() const { return !handle && !stream && !deferred; }
+
+  HandleFunction handle;          ///< 请求体完整地缓存之后调用
+  StreamHandleFunction stream;    ///< 以流的方式接收请求体
+  std::shared_ptr<HttpMicroCache> cache;  ///< 不为空时handle或deferred生成的应答使用微缓存
+  DeferredHandleFunction deferred;        ///< 请求体完整地缓存之后调用，应答由完成令牌提交
+  /// 执行策略: 为空时handle与deferred在Reactor线程中执行，否则在该线程池中执行；stream总是在Reactor线程中执行
+  ThreadPool *thread_pool = nullptr;
+};
+
+/// 基于压缩前缀树(radix tree)的路由，查找的时间只与路径的长度有关，与注册的路由数量无关
+///
+/// 路由的每一段可以是:
+/// - 静态文本，例如"/api/users"
+/// - ":name"，匹配一个非空的路径段(直到下一个'/')，例如"/users/:id"
+/// - "*name"，匹配剩余的整个路径(可以为空)，只能位于路由的末尾，例如"/static/*path"
+/// 以'/'结尾的路由匹配以其为前缀的所有路径，即"/static/"等价于"/static/*"，"/"匹配所有路径。
+/// 同一位置同时存在多种可能时，优先级为 静态文本 > ":name" > "*name"，失败时回溯尝试下一种，
+/// 路由终点没有该请求方法的处理函数也视为失败，例如注册了"GET /users/new"与"DELETE /users/:id"时，
+/// "DELETE /users/new"由后者处理。
+/// 匹配到的参数以指向url的string_view的形式保存在HttpRequest::GetPathParams中，不复制数据。
+/// 每个路由可以为不同的请求方法注册不同的处理函数，不指定方法时处理所有方法
+/// @note 注册路由不是线程安全的，请在启动服务器之前完成注册
+class HttpRoute : noncopyable {
+ public:
+  using HandleFunction = HttpHandler::HandleFunction;
+  using StreamHandleFunction = HttpHandler::StreamHandleFunction;
+  using PathParams = std::vector<HttpRequest::PathParam>;
 
   HttpRoute() = default;
 
+  /// 注册处理所有请求方法的处理函数，已经存在时替换
   void RegisterHandler(const std::string &path, const HandleFunction &handle_function) {
-    path_to_handle_function_[path] = handle_function;
+    RegisterHandler(HttpMethod::Invalid, path, handle_function);
+  }
+  void RegisterStreamHandler(const std::string &path, const StreamHandleFunction &stream_function) {
+    RegisterStreamHandler(HttpMethod::Invalid, path, stream_function);
+  }
+  /// 注册只处理method请求的处理函数，优先于处理所有请求方法的处理函数
+  void RegisterHandler(HttpMethod method, const std::string &path, const HandleFunction &handle_function) {
+    HttpHandler handler;
+    handler.handle = handle_function;
+    Insert(method, path, std::move(handler));
+  }
+  void RegisterStreamHandler(HttpMethod method, const std::string &path, const StreamHandleFunction &stream_function) {
+    HttpHandler handler;
+    handler.stream = stream_function;
+    Insert(method, path, std::move(handler));
+  }
+
+  /// 注册完整的处理器，method为HttpMethod::Invalid时处理所有请求方法
+  void RegisterHandler(HttpMethod method, const std::string &path, HttpHandler handler) {
+    NET_ASSERT(!handler.Empty());
+    Insert(method, path, std::move(handler));
+  }
+
+  /// 查找处理函数
+  /// @param params 不为空时，追加匹配到的路径参数，值指向path
+  /// @return 没有匹配的路由，或者匹配的路由都没有该方法的处理函数时返回nullptr
+  HttpHandler *GetHandler(HttpMethod method, std::string_view path, PathParams *params = nullptr) {
+    const Node *node = Match(&root_, path, method, params);
+    return node ? node->GetHandler(method) : nullptr;
   }
 
-  HandleFunction *GetHandler(const std::string &path) {
-    auto pos = path_to_handle_function_.find(path);
-    if (pos != path_to_handle_function_.end()) {
-      return &(pos->second);
+  /// @return 能够处理path的请求方法(可能来自不同的路由)，以", "分隔，可用于405应答的Allow头部；
+  ///         没有匹配的路由时返回空字符串
+  [[nodiscard]] std::string GetAllowedMethods(std::string_view path) const {
+    std::string methods;
+    for (size_t i = 1; i < kMethodNum; ++i) {
+      auto method = static_cast<HttpMethod>(i);
+      if (Match(&root_, path, method, nullptr)) {
+        if (!methods.empty()) methods.append(", ");
+        methods.append(net::ToString(method));
+      }
+    }
+    return methods;
+  }
+
+ private:
+  static constexpr size_t kMethodNum = static_cast<size_t>(HttpMethod::Patch) + 1;
+
+  /// 静态节点匹配text；param_child匹配一个非空的路径段，catch_all_child匹配剩余的整个路径，两者的text为参数名
+  struct Node {
+    explicit Node(std::string_view text = {}) : text(text) {}
+
+    /// @return method的处理函数，没有时返回处理所有方法的处理函数，都没有时返回nullptr
+    HttpHandler *GetHandler(HttpMethod method) const {
+      if (!handlers) return nullptr;
+      HttpHandler *handler = &(*handlers)[static_cast<size_t>(method)];
+      if (handler->Empty()) handler = &(*handlers)[0];
+      return handler->Empty() ? nullptr : handler;
     }
-    for (auto &[p, h]: path_to_handle_function_) {
-      if (net::HasPrefix(path, p) ||
-          net::HasPrefix(path + '/', p)) {
-        return &h;
+
+    std::string text;
+    std::string indices;  ///< 各个静态子节点前缀的首字符，与children一一对应
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> param_child;
+    std::unique_ptr<Node> catch_all_child;
+    /// 以HttpMethod为下标，下标0(HttpMethod::Invalid)表示所有方法，只有路由的终点才分配
+    std::unique_ptr<std::array<HttpHandler, kMethodNum>> handlers;
+  };
+
+  void Insert(HttpMethod method, std::string path, HttpHandler handler) {
+    NET_ASSERT(!path.empty() && path[0] == '/');
+    if (path.back() == '/') {
+      path.push_back('*');
+    }
+    Node *node = &root_;
+    size_t pos = 0;
+    while (pos < path.size()) {
+      // 参数只能出现在一个路径段的开头
+      size_t special = pos;
+      while (special < path.size() &&
+          !((path[special] == ':' || path[special] == '*') && path[special - 1] == '/')) {
+        ++special;
       }
+      node = InsertStatic(node, std::string_view(path).substr(pos, special - pos));
+      if (special == path.size()) break;
+
+      size_t end = path.find('/', special);
+      if (end == std::string::npos) end = path.size();
+      std::string_view name = std::string_view(path).substr(special + 1, end - special - 1);
+      if (path[special] == ':') {
+        NET_ASSERT(!name.empty());
+        if (!node->param_child) {
+          node->param_child = std::make_unique<Node>(name);
+        }
+        // 同一位置的参数必须同名，否则无法确定参数名
+        NET_ASSERT(node->param_child->text == name);
+        node = node->param_child.get();
+      } else {
+        NET_ASSERT(end == path.size());
+        if (!node->catch_all_child) {
+          node->catch_all_child = std::make_unique<Node>(name);
+        }
+        NET_ASSERT(node->catch_all_child->text == name);
+        node = node->catch_all_child.get();
+      }
+      pos = end;
+    }
+    if (!node->handlers) {
+      node->handlers = std::make_unique<std::array<HttpHandler, kMethodNum>>();
+    }
+    (*node->handlers)[static_cast<size_t>(method)] = std::move(handler);
+  }
+
+  /// 在node之后插入静态文本，必要时分裂已有的节点
+  /// @return text的终点所在的节点
+  static Node *InsertStatic(Node *node, std::string_view text) {
+    while (!text.empty()) {
+      size_t i = node->indices.find(text[0]);
+      if (i == std::string::npos) {
+        node->indices.push_back(text[0]);
+        node->children.push_back(std::make_unique<Node>(text));
+        return node->children.back().get();
+      }
+      Node *child = node->children[i].get();
+      size_t common = 0;
+      while (common < text.size() && common < child->text.size() && text[common] == child->text[common]) {
+        ++common;
+      }
+      if (common < child->text.size()) {
+        // 公共前缀成为新的节点，原来的节点保留剩余的部分
+        auto split = std::make_unique<Node>(std::string_view(child->text).substr(0, common));
+        child->text.erase(0, common);
+        split->indices.push_back(child->text[0]);
+        split->children.push_back(std::move(node->children[i]));
+        node->children[i] = std::move(split);
+        child = node->children[i].get();
+      }
+      node = child;
+      text.remove_prefix(common);
+    }
+    return node;
+  }
+
+  /// 在node之后匹配path，只接受有method的处理函数的路由终点
+  /// @return 匹配到的路由终点，失败时返回nullptr并且不修改params
+  static const Node *Match(const Node *node, std::string_view path, HttpMethod method, PathParams *params) {
+    if (!path.empty()) {
+      size_t i = node->indices.find(path[0]);
+      if (i != std::string::npos) {
+        const Node *child = node->children[i].get();
+        if (net::HasPrefix(path, child->text)) {
+          const Node *result = Match(child, path.substr(child->text.size()), method, params);
+          if (result) return result;
+        }
+      }
+      if (node->param_child) {
+        size_t end = std::min(path.find('/'), path.size());
+        if (end > 0) {
+          if (params) params->emplace_back(node->param_child->text, path.substr(0, end));
+          const Node *result = Match(node->param_child.get(), path.substr(end), method, params);
+          if (result) return result;
+          if (params) params->pop_back();
+        }
+      }
+    } else if (node->GetHandler(method)) {
+      return node;
+    }
+    if (node->catch_all_child && node->catch_all_child->GetHandler(method)) {
+      if (params && !node->catch_all_child->text.empty()) {
+        params->emplace_back(node->catch_all_child->text, path);
+      }
+      return node->catch_all_child.get();
     }
     return nullptr;
   }
 
- private:
-  std::unordered_map<std::string, HandleFunction> path_to_handle_function_;
+  Node root_;
 };
 
 } // namespace net
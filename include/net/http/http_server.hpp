@@ -2,6 +2,7 @@
 #define NET_INCLUDE_NET_HTTP_HTTP_SERVER_HPP_
 
 #include "net/tcp/tcp_server.hpp"
+#include "net/http/http_compression.hpp"
 #include "net/http/http_parser.hpp"
 #include "net/http/http_route.hpp"
 
@@ -10,11 +11,20 @@ namespace net {
 class HttpServer {
  public:
   using HandleFunction = HttpRoute::HandleFunction;
+  using StreamHandleFunction = HttpRoute::StreamHandleFunction;
+  using DeferredHandleFunction = HttpHandler::DeferredHandleFunction;
+
+  /// 应答体超过该长度时不复制到输出缓冲区中，而是与头部一起通过writev发送
+  static constexpr size_t kCopyContentLimit = 16 * 1024;
 
   HttpServer(Reactor *reactor, const InetAddress &listen_addr)
-      : tcp_server_(reactor, listen_addr) {
+      : tcp_server_(reactor, listen_addr),
+        max_body_size_(HttpRequestParser::kDefaultMaxBodySize) {
+    tcp_server_.SetConnectionCallback([this](const TcpConnectionPtr &conn) {
+      OnConnection(conn);
+    });
     tcp_server_.SetMessageCallback([this](const TcpConnectionPtr &conn, const BufferPtr &buffer) {
-      MessageCallback(conn, buffer);
+      OnMessage(conn, buffer);
     });
   }
 
@@ -23,38 +33,491 @@ class HttpServer {
     tcp_server_.SetThreadNum(thread_num);
   }
 
+  /// 缓存的请求体(解码后)的最大长度，超过时回复413并关闭连接，对之后建立的连接生效
+  /// @note 以流的方式接收的请求体不受该限制
+  void SetMaxBodySize(size_t max_body_size) { max_body_size_ = max_body_size; }
+
+  /// 注册处理所有请求方法的处理函数，路由的语法参见HttpRoute，路径参数通过HttpRequest::GetPathParam获取
   void Handle(const std::string &path, const HandleFunction &handle_function) {
     route_.RegisterHandler(path, handle_function);
   }
+  /// 注册只处理method请求的处理函数，路径匹配而方法不匹配的请求回复405
+  void Handle(HttpMethod method, const std::string &path, const HandleFunction &handle_function) {
+    route_.RegisterHandler(method, path, handle_function);
+  }
+  /// 注册在线程池中执行的处理函数，适用于会阻塞的处理(例如访问数据库)，不会拖慢同一Reactor上的其他连接
+  /// @param method 为HttpMethod::Invalid时处理所有请求方法
+  /// @param thread_pool 请确保其生命周期长于HttpServer
+  /// @note 处理函数执行期间，同一连接之后的请求暂不处理，应答按请求的顺序发送
+  void Handle(HttpMethod method, const std::string &path, const HandleFunction &handle_function,
+              ThreadPool *thread_pool) {
+    HttpHandler handler;
+    handler.handle = handle_function;
+    handler.thread_pool = thread_pool;
+    route_.RegisterHandler(method, path, std::move(handler));
+  }
+  /// 注册延迟应答的处理函数: 处理函数得到HttpDeferredReply，可以在任意线程中完成应答，
+  /// 例如在异步客户端的回调中；应答回到连接所在的Reactor线程中按请求的顺序发送
+  /// @param thread_pool 不为空时处理函数本身也在其中执行
+  void HandleDeferred(HttpMethod method, const std::string &path, const DeferredHandleFunction &deferred_function,
+                      ThreadPool *thread_pool = nullptr) {
+    HttpHandler handler;
+    handler.deferred = deferred_function;
+    handler.thread_pool = thread_pool;
+    route_.RegisterHandler(method, path, std::move(handler));
+  }
+  /// 注册处理函数并开启微缓存，参见HttpMicroCache: ttl内相同的GET/HEAD请求直接发送缓存的应答，不再调用处理函数
+  /// @param method 为HttpMethod::Invalid时处理所有请求方法，但只有GET/HEAD请求使用缓存
+  /// @param thread_pool 不为空时处理函数在其中执行
+  void HandleCached(HttpMethod method, const std::string &path, const HandleFunction &handle_function,
+                    HttpMicroCacheOptions options = {}, ThreadPool *thread_pool = nullptr) {
+    HttpHandler handler;
+    handler.handle = handle_function;
+    handler.cache = std::make_shared<HttpMicroCache>(std::move(options));
+    handler.thread_pool = thread_pool;
+    route_.RegisterHandler(method, path, std::move(handler));
+  }
+  /// 以流的方式接收请求体: 头部解析完成后调用stream_function创建HttpBodyReader，
+  /// 请求体每到达一段就交给on_data并从输入缓冲区中释放，全部到达后由on_complete生成应答
+  void HandleStream(const std::string &path, const StreamHandleFunction &stream_function) {
+    route_.RegisterStreamHandler(path, stream_function);
+  }
+  void HandleStream(HttpMethod method, const std::string &path, const StreamHandleFunction &stream_function) {
+    route_.RegisterStreamHandler(method, path, stream_function);
+  }
+
+  /// 开启动态应答的压缩，参见HttpCompressor；以文件、chunked编码发送的应答不压缩
+  /// @param thread_pool 较大的应答体在其中压缩，为空时在Reactor线程中压缩；请确保其生命周期长于HttpServer
+  void EnableCompression(HttpCompressionOptions options = {}, ThreadPool *thread_pool = nullptr) {
+    compressor_ = std::make_unique<HttpCompressor>(std::move(options), thread_pool);
+  }
 
   void Start() {
     tcp_server_.Start();
   }
 
+  /// 连接建立与断开时由TcpServer调用，也可以用于自行管理的TcpConnection
+  void OnConnection(const TcpConnectionPtr &conn) {
+    if (conn->Connected()) return;
+    auto context = std::static_pointer_cast<Context>(conn->GetContext());
+    if (context && context->writer) {
+      // 通知正在生产流式应答的一方停止，同时打破连接与写入器之间的循环引用
+      auto writer = std::move(context->writer);
+      writer->OnClose();
+    }
+  }
+
+  /// 依次处理buffer中所有完整的请求(HTTP/1.1 pipelining)，应答按请求的顺序拼接后一次性发送，
+  /// 不完整的请求保留在buffer中等待后续数据。流式应答结束或者其他线程中的应答完成之前，后续的请求暂不处理
+  void OnMessage(const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+    // 每个连接持有一个解析器，请求被拆分到多次读取中时从上次停止的位置继续解析
+    auto context = std::static_pointer_cast<Context>(conn->GetContext());
+    if (!context) {
+      context = NewContext(conn.get());
+      conn->SetContext(context);
+    }
+    if (context->writer || context->deferred) return;
+    HttpRequestParser &parser = context->parser;
+    while (true) {
+      HttpParseResult result = parser.Parse(buffer);
+      if (result == HttpParseResult::NeedMore) break;
+      if (result == HttpParseResult::Error) {
+        // 请求格式错误时无法再确定下一个请求的边界，应答后关闭连接
+        HttpReply reply;
+        reply.SetVersion(HttpVersion::Http11);
+        reply.SetStatusCode(parser.GetErrorStatus());
+        reply.SetHeader(HttpHeaderId::Connection, kConnectionClose);
+        buffer->Reset();
+        parser.Reset();
+        context->handler = nullptr;
+        context->body_reader = {};
+        WriteReply(conn, context.get(), reply);
+        SendAndShutdown(conn, context.get());
+        return;
+      }
+
+      const HttpRequest &request = parser.GetRequest();
+      HttpHandler *handler = context->handler;
+      HttpMicroCache *fill_cache = nullptr;   ///< 应答生成后加入该缓存
+      std::string fill_key;
+      if (handler && handler->cache && HttpMicroCache::IsCacheable(request)) {
+        std::string key = handler->cache->MakeKey(request, compressor_ != nullptr);
+        HttpMicroCache::Shard &shard = handler->cache->GetLocalShard();
+        if (auto entry = shard.Find(key)) {
+          bool close = WriteCachedReply(conn, context.get(), request, *entry);
+          buffer->HasRead(parser.GetRequestSize());
+          parser.Reset();
+          context->handler = nullptr;
+          if (close) {
+            SendAndShutdown(conn, context.get());
+            return;
+          }
+          continue;
+        }
+        if (shard.IsFilling(key)) {
+          // 相同的请求正在生成应答，请求保留在buffer中，完成后重新解析并查找缓存
+          parser.Reset();
+          context->handler = nullptr;
+          WaitForFill(conn, context, buffer, shard, key);
+          return;
+        }
+        shard.BeginFill(key);
+        fill_cache = handler->cache.get();
+        fill_key = std::move(key);
+      }
+      if (handler && (handler->deferred || handler->thread_pool)) {
+        // 请求保留在buffer中直到应答完成
+        Dispatch(conn, context, buffer, handler, fill_cache, std::move(fill_key));
+        return;
+      }
+
+      HttpReply reply;
+      reply.SetVersion(HttpVersion::Http11);
+      reply.SetStatusCode(HttpStatusCode::k200Ok);  // 默认返回200 OK
+      if (context->body_reader.on_complete) {
+        context->body_reader.on_complete(request, reply);
+      } else if (handler && handler->handle) {
+        handler->handle(request, reply);
+      } else {
+        std::string allowed_methods = route_.GetAllowedMethods(request.GetRouteUrl());
+        if (allowed_methods.empty()) {
+          reply.SetStatusCode(HttpStatusCode::k404NotFound);
+        } else {
+          reply.SetStatusCode(HttpStatusCode::k405MethodNotAllowed);
+          reply.SetHeader(HttpHeaderId::Allow, allowed_methods);
+        }
+      }
+      if (!OnReply(conn, context, buffer, std::move(reply), fill_cache, std::move(fill_key))) return;
+    }
+    if (buffer->ReadableBytes() == 0) {
+      buffer->Reset();
+    }
+    if (!context->output.empty()) {
+      conn->Send(context->output);
+      context->output.clear();
+    }
+  }
+
  private:
-  void MessageCallback(const TcpConnectionPtr &conn, const BufferPtr &buffer) {
-    HttpRequest request;
-    HttpReply reply;
+  /// 每个连接的状态
+  struct Context {
+    explicit Context(size_t max_body_size)
+        : parser(HttpRequestParser::kDefaultMaxHeaderSize, max_body_size),
+          handler(nullptr) {}
+
+    HttpRequestParser parser;
+    HttpHandler *handler;         ///< 当前请求路由到的处理函数
+    HttpBodyReader body_reader;   ///< 当前请求以流的方式接收请求体时的处理器
+    std::string output;           ///< 已经生成但尚未发送的应答
+    std::shared_ptr<HttpChunkedWriter> writer;  ///< 正在进行的流式应答
+    bool deferred = false;        ///< 是否有应答正在其他线程中生成
+  };
+
+  std::shared_ptr<Context> NewContext(TcpConnection *conn) {
+    auto context = std::make_shared<Context>(max_body_size_);
+    // 流式应答根据输出缓冲区的水位控制生产速度
+    conn->SetHighWaterMarkCallback(nullptr, HttpChunkedWriter::kHighWaterMark);
+    conn->SetLowWaterMarkCallback([context = context.get()](const TcpConnectionPtr &, size_t) {
+      if (context->writer) {
+        context->writer->OnWritable();
+      }
+    }, HttpChunkedWriter::kLowWaterMark);
+    context->parser.SetHeaderCallback([this, context = context.get(), conn](const HttpRequest &request) {
+      // 路径参数指向请求的url，解析器在移动url时会一并更新
+      context->handler = route_.GetHandler(request.GetMethod(), request.GetRouteUrl(),
+                                           &context->parser.GetRequest().GetMutablePathParams());
+      HttpRequestParser::BodyCallback body_callback;
+      if (context->handler && context->handler->stream) {
+        context->body_reader = context->handler->stream(request);
+        body_callback = context->body_reader.on_data;
+      }
+      // 客户端在发送请求体之前等待确认，只有确定会接收请求体时才让其继续，
+      // 没有处理函数(404/405)或者请求体过大(413)时不发送100，直接回复最终的应答
+      if (context->handler && (body_callback || context->parser.IsBodySizeAllowed()) &&
+          request.GetVersion() == HttpVersion::Http11 &&
+          EqualsIgnoreCase(request.GetHeader(HttpHeaderId::Expect), "100-continue")) {
+        // 先发送之前的应答以保证顺序
+        context->output.append("HTTP/1.1 100 Continue\r\n\r\n");
+        conn->Send(context->output);
+        context->output.clear();
+      }
+      return body_callback;
+    });
+    return context;
+  }
+
+  /// HTTP/1.1默认保持连接，除非请求中有Connection: close；HTTP/1.0默认关闭连接，除非请求中有Connection: Keep-Alive
+  static bool IsKeepAlive(const HttpRequest &request) {
+    std::string_view connection = request.GetHeader(HttpHeaderId::Connection);
+    if (request.GetVersion() == HttpVersion::Http10) {
+      return EqualsIgnoreCase(connection, kConnectionKeepAlive);
+    }
+    return !EqualsIgnoreCase(connection, kConnectionClose);
+  }
+
+  /// 请求中没有要求关闭连接时保持连接，HTTP/1.0需要显式地回复Keep-Alive
+  static void SetConnectionHeader(const HttpRequest &request, HttpReply &reply) {
+    if (reply.HasHeader(HttpHeaderId::Connection)) return;
+    if (!IsKeepAlive(request)) {
+      reply.SetHeader(HttpHeaderId::Connection, kConnectionClose);
+    } else if (request.GetVersion() == HttpVersion::Http10) {
+      reply.SetHeader(HttpHeaderId::Connection, kConnectionKeepAlive);
+    }
+  }
+
+  /// 发送缓存的应答，HTTP/1.1保持连接的请求直接使用序列化好的字节，其他请求需要修改Connection头部
+  /// @return 是否需要关闭连接
+  static bool WriteCachedReply(const TcpConnectionPtr &conn, Context *context, const HttpRequest &request,
+                               const HttpMicroCache::Entry &entry) {
+    bool head_only = request.GetMethod() == HttpMethod::Head;
+    if (request.GetVersion() == HttpVersion::Http11 && IsKeepAlive(request)) {
+      HttpMicroCache::AppendEntry(entry, context->output, head_only);
+      return false;
+    }
+    HttpReply reply = entry.reply;
+    SetConnectionHeader(request, reply);
+    WriteReply(conn, context, reply, head_only);
+    return EqualsIgnoreCase(reply.GetHeader(HttpHeaderId::Connection), kConnectionClose);
+  }
+
+  /// 先发送之前的应答并暂停读取，当前请求的应答完成之前不处理之后的请求，以保证应答的顺序
+  static void Defer(const TcpConnectionPtr &conn, Context *context) {
+    if (!context->output.empty()) {
+      conn->Send(context->output);
+      context->output.clear();
+    }
+    context->deferred = true;
+    conn->PauseReading();
+  }
+
+  /// 发送已经生成的应答后关闭连接
+  static void SendAndShutdown(const TcpConnectionPtr &conn, Context *context) {
+    if (!context->output.empty()) {
+      conn->Send(context->output);
+      context->output.clear();
+    }
+    conn->Shutdown();
+  }
+
+  /// 相同的请求生成应答后再继续处理
+  void WaitForFill(const TcpConnectionPtr &conn, const std::shared_ptr<Context> &context, const BufferPtr &buffer,
+                   HttpMicroCache::Shard &shard, const std::string &key) {
+    Defer(conn, context.get());
+    shard.AddWaiter(key, [this, conn, context, buffer] {
+      context->deferred = false;
+      if (!conn->Connected()) return;
+      conn->ResumeReading();
+      OnMessage(conn, buffer);
+    });
+  }
+
+  /// 将生成的应答加入缓存，在下一轮事件循环中唤醒等待该键的请求
+  /// @param entry 为空时只唤醒等待的请求，由它们各自调用处理函数
+  /// @note 连接已经断开时也需要调用，否则等待的请求不会被唤醒
+  static void FillCache(const TcpConnectionPtr &conn, HttpMicroCache *cache, const std::string &key,
+                        std::shared_ptr<const HttpMicroCache::Entry> entry) {
+    auto waiters = cache->GetLocalShard().EndFill(key, std::move(entry));
+    for (auto &waiter: waiters) {
+      conn->GetReactor()->SubmitTask(std::move(waiter));
+    }
+  }
+
+  /// 按执行策略调用处理函数，应答通过完成令牌回到Reactor线程
+  void Dispatch(const TcpConnectionPtr &conn, const std::shared_ptr<Context> &context, const BufferPtr &buffer,
+                HttpHandler *handler, HttpMicroCache *fill_cache, std::string fill_key) {
+    Defer(conn, context.get());
+    HttpDeferredReply token([this, conn, context, buffer, fill_cache, fill_key = std::move(fill_key)](
+        HttpReply &&reply) {
+      // 可能在任意线程中调用，连接的引用随任务移动到Reactor线程中释放
+      auto pending = std::make_shared<HttpReply>(std::move(reply));
+      conn->GetReactor()->SubmitTask([this, conn, context, buffer, pending, fill_cache, fill_key] {
+        OnDeferredReply(conn, context, buffer, std::move(*pending), fill_cache, fill_key);
+      });
+    });
+    // 请求在应答完成之前不会被释放或者修改
+    const HttpRequest *request = &context->parser.GetRequest();
+    auto handle = [handler, request, token = std::move(token)] {
+      if (handler->deferred) {
+        handler->deferred(*request, token);
+        return;
+      }
+      HttpReply reply;
+      reply.SetStatusCode(HttpStatusCode::k200Ok);
+      handler->handle(*request, reply);
+      token.Reply(std::move(reply));
+    };
+    if (handler->thread_pool) {
+      handler->thread_pool->SubmitTask(std::move(handle));
+    } else {
+      handle();
+    }
+  }
+
+  /// 处理函数提交的应答回到Reactor线程之后，与同步生成的应答一样发送，然后继续处理在此期间到达的请求
+  void OnDeferredReply(const TcpConnectionPtr &conn, const std::shared_ptr<Context> &context, const BufferPtr &buffer,
+                       HttpReply &&reply, HttpMicroCache *fill_cache, std::string fill_key) {
+    context->deferred = false;
+    if (!conn->Connected()) {
+      if (fill_cache) FillCache(conn, fill_cache, fill_key, nullptr);
+      return;
+    }
     reply.SetVersion(HttpVersion::Http11);
-    if (net::Parse(buffer, request)) {
-      auto handler = route_.GetHandler(request.GetRouteUrl());
-      if (handler) {
-        reply.SetStatusCode(HttpStatusCode::k200Ok);  // 默认返回200 OK
-        (*handler)(request, reply);
+    if (reply.GetStatusCode() == HttpStatusCode::kUnknown) {
+      reply.SetStatusCode(HttpStatusCode::k200Ok);
+    }
+    if (OnReply(conn, context, buffer, std::move(reply), fill_cache, std::move(fill_key))) {
+      conn->ResumeReading();
+      OnMessage(conn, buffer);
+    }
+  }
+
+  /// 当前请求的应答已经生成: 补充头部，释放请求，按需压缩后写入output
+  /// @return 可以继续处理之后的请求时返回true；连接需要关闭(已经关闭)、应答正在压缩或者流式应答尚未结束时返回false
+  bool OnReply(const TcpConnectionPtr &conn, const std::shared_ptr<Context> &context, const BufferPtr &buffer,
+               HttpReply &&reply, HttpMicroCache *fill_cache, std::string &&fill_key) {
+    HttpRequestParser &parser = context->parser;
+    const HttpRequest &request = parser.GetRequest();
+    bool chunked = false;
+    if (reply.IsChunked()) {
+      chunked = request.GetVersion() == HttpVersion::Http11;
+      if (chunked) {
+        reply.SetHeader(HttpHeaderId::TransferEncoding, "chunked");
       } else {
-        reply.SetStatusCode(HttpStatusCode::k404NotFound);
+        // HTTP/1.0不支持chunked编码，以关闭连接表示应答体结束
+        reply.SetHeader(HttpHeaderId::Connection, kConnectionClose);
       }
+    }
+    SetConnectionHeader(request, reply);
+    HttpContentCoding coding = compressor_ ? compressor_->Negotiate(request, reply) : HttpContentCoding::Identity;
+    bool close = EqualsIgnoreCase(reply.GetHeader(HttpHeaderId::Connection), kConnectionClose);
+    // HEAD请求的应答与GET的头部(包括Content-Length)相同，但不发送应答体
+    bool head_only = request.GetMethod() == HttpMethod::Head;
+    // 应答已经生成，请求引用的数据可以释放了
+    buffer->HasRead(parser.GetRequestSize());
+    parser.Reset();
+    context->handler = nullptr;
+    context->body_reader = {};
+
+    if (coding != HttpContentCoding::Identity && !compressor_->TryCompress(coding, reply)) {
+      CompressInThreadPool(conn, context, buffer, std::move(reply), coding, close, head_only, fill_cache,
+                           std::move(fill_key));
+      return false;
+    }
+    if (fill_cache) {
+      FillCache(conn, fill_cache, fill_key, fill_cache->MakeEntry(reply));
+    }
+    return WriteFinalReply(conn, context, buffer, reply, chunked, close, head_only);
+  }
+
+  /// 将最终的应答写入output，流式应答交给写入器
+  /// @param head_only 为true时只写入状态行与头部，流式应答的写入器直接结束，之后写入的数据被丢弃
+  /// @return 同OnReply
+  bool WriteFinalReply(const TcpConnectionPtr &conn, const std::shared_ptr<Context> &context, const BufferPtr &buffer,
+                       const HttpReply &reply, bool chunked, bool close, bool head_only) {
+    if (head_only || !reply.IsChunked()) {
+      WriteReply(conn, context.get(), reply, head_only);
+      if (reply.IsChunked()) reply.GetChunkedWriter()->Discard();
     } else {
-      reply.SetStatusCode(HttpStatusCode::k400BadRequest);
+      // 流式应答的头部追加在之前的应答之后一起发送
+      reply.SerializeHeadTo(context->output);
+      const auto &writer = reply.GetChunkedWriter();
+      writer->Attach(conn, context->output, chunked, [this, context = context.get(), buffer, close](
+          const TcpConnectionPtr &conn) {
+        OnChunkedReplyEnd(conn, context, buffer, close);
+      });
+      context->output.clear();
+      if (!writer->IsEnded()) {
+        // 流式应答结束之前暂停读取，避免后续的请求堆积在输入缓冲区中
+        context->writer = writer;
+        conn->PauseReading();
+        // 处理函数中因为缓存的数据过多而暂停的生产者，在数据交给连接之后继续
+        conn->GetReactor()->SubmitTask([writer] { writer->OnWritable(); });
+        return false;
+      }
+    }
+    if (close) {
+      SendAndShutdown(conn, context.get());
+      return false;
     }
-    conn->Send(reply.SerializedToString());
-    if (reply.GetHeader(kConnectionField) == kConnectionClose) {
+    return true;
+  }
+
+  /// 将非流式的应答追加到output中，较大的应答体与文件直接交给连接发送
+  /// @param head_only 为true时只追加状态行与头部(HEAD请求)
+  static void WriteReply(const TcpConnectionPtr &conn, Context *context, const HttpReply &reply,
+                         bool head_only = false) {
+    if (head_only) {
+      reply.SerializeHeadTo(context->output);
+      return;
+    }
+    if (reply.HasFileContent() && !IsBodilessStatus(reply.GetStatusCode())) {
+      // 文件通过sendfile发送，连接保证其与之前以及之后的数据之间的顺序
+      reply.SerializeHeadTo(context->output);
+      for (auto &[prefix, file]: reply.GetFileContents()) {
+        context->output.append(prefix);
+        conn->Send(context->output);
+        context->output.clear();
+        conn->SendFile(file.fd, file.offset, file.length, file.holder);
+      }
+      context->output.append(reply.GetContent());
+      return;
+    }
+    const std::string &content = reply.GetContent();
+    if (reply.HasContent() && content.size() >= kCopyContentLimit) {
+      // 较大的应答体不复制到output中，与之前的应答一起通过writev发送
+      reply.SerializeHeadTo(context->output);
+      conn->Send({context->output, content});
+      context->output.clear();
+    } else {
+      // 直接序列化到连接复用的output中，通常不需要分配内存
+      reply.SerializeTo(context->output);
+    }
+  }
+
+  /// 在线程池中压缩，压缩完成后回到Reactor线程发送该应答，再继续处理之后的请求
+  /// @param fill_cache 不为空时压缩后的应答加入该缓存
+  void CompressInThreadPool(const TcpConnectionPtr &conn, const std::shared_ptr<Context> &context,
+                            const BufferPtr &buffer, HttpReply &&reply, HttpContentCoding coding, bool close,
+                            bool head_only, HttpMicroCache *fill_cache, std::string fill_key) {
+    Defer(conn, context.get());
+    auto pending = std::make_shared<HttpReply>(std::move(reply));
+    compressor_->GetThreadPool()->SubmitTask([this, conn, context, buffer, pending, coding, close, head_only,
+                                                 fill_cache, fill_key = std::move(fill_key)]() mutable {
+      auto compressed = compressor_->Compress(coding, pending->GetContent());
+      // 连接的引用移动到Reactor线程中释放
+      Reactor *reactor = conn->GetReactor();
+      reactor->SubmitTask([this, conn = std::move(conn), context = std::move(context), buffer = std::move(buffer),
+                              pending = std::move(pending), compressed = std::move(compressed), coding, close,
+                              head_only, fill_cache, fill_key = std::move(fill_key)] {
+        HttpCompressor::Apply(coding, compressed, *pending);
+        if (fill_cache) {
+          FillCache(conn, fill_cache, fill_key, fill_cache->MakeEntry(*pending));
+        }
+        context->deferred = false;
+        if (!conn->Connected()) return;
+        if (WriteFinalReply(conn, context, buffer, *pending, false, close, head_only)) {
+          conn->ResumeReading();
+          OnMessage(conn, buffer);
+        }
+      });
+    });
+  }
+
+  /// 流式应答结束后，继续处理在此期间到达的请求
+  void OnChunkedReplyEnd(const TcpConnectionPtr &conn, Context *context, const BufferPtr &buffer, bool close) {
+    context->writer.reset();
+    if (close) {
       conn->Shutdown();
+      return;
     }
+    conn->ResumeReading();
+    OnMessage(conn, buffer);
   }
 
   TcpServer tcp_server_;
   HttpRoute route_;
+  size_t max_body_size_;
+  std::unique_ptr<HttpCompressor> compressor_;
 };
 
 } // namespace net
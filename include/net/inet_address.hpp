@@ -7,39 +7,153 @@
 #include <cstring>
 #include <netinet/in.h>
 #include <string_view>
+#include <sys/un.h>
 
 namespace net {
 
-/// IPv4地址
+/// 流式socket的端点地址，支持IPv4、IPv6以及Unix域socket(包括抽象命名空间)
 class InetAddress {
  public:
-  explicit InetAddress(uint16_t port) {
+  /// 监听所有网卡的port端口，ipv6为true时使用IPv6的通配地址
+  explicit InetAddress(uint16_t port, bool ipv6 = false) {
     bzero(&addr_, sizeof(addr_));
-    addr_.sin_family = AF_INET;
-    addr_.sin_addr.s_addr = htonl(INADDR_ANY);
-    addr_.sin_port = htons(port);
+    if (ipv6) {
+      addr_.in6.sin6_family = AF_INET6;
+      addr_.in6.sin6_addr = in6addr_any;
+      addr_.in6.sin6_port = htons(port);
+      len_ = sizeof(struct sockaddr_in6);
+    } else {
+      addr_.in.sin_family = AF_INET;
+      addr_.in.sin_addr.s_addr = htonl(INADDR_ANY);
+      addr_.in.sin_port = htons(port);
+      len_ = sizeof(struct sockaddr_in);
+    }
   }
+  /// ip中包含':'时将被解析为IPv6地址，否则解析为IPv4地址
   InetAddress(std::string_view ip, uint16_t port) {
     bzero(&addr_, sizeof(addr_));
-    addr_.sin_family = AF_INET;
-    if (inet_pton(AF_INET, ip.data(), &addr_.sin_addr) != 1) {
-      LOG_ERROR("inet_pton() failed");
+    std::string ip_str(ip);  // inet_pton需要以'\0'结尾的字符串
+    if (ip.find(':') != std::string_view::npos) {
+      addr_.in6.sin6_family = AF_INET6;
+      if (inet_pton(AF_INET6, ip_str.c_str(), &addr_.in6.sin6_addr) != 1) {
+        LOG_ERROR("inet_pton() failed");
+      }
+      addr_.in6.sin6_port = htons(port);
+      len_ = sizeof(struct sockaddr_in6);
+    } else {
+      addr_.in.sin_family = AF_INET;
+      if (inet_pton(AF_INET, ip_str.c_str(), &addr_.in.sin_addr) != 1) {
+        LOG_ERROR("inet_pton() failed");
+      }
+      addr_.in.sin_port = htons(port);
+      len_ = sizeof(struct sockaddr_in);
     }
-    addr_.sin_port = htons(port);
   }
-  explicit InetAddress(const struct sockaddr_in &addr) : addr_(addr) {}
+  explicit InetAddress(const struct sockaddr_in &addr) : len_(sizeof(addr)) {
+    bzero(&addr_, sizeof(addr_));
+    addr_.in = addr;
+  }
+  explicit InetAddress(const struct sockaddr_in6 &addr) : len_(sizeof(addr)) {
+    bzero(&addr_, sizeof(addr_));
+    addr_.in6 = addr;
+  }
+  /// 从getsockname/accept等接口返回的地址构造
+  InetAddress(const struct sockaddr *addr, socklen_t len) {
+    bzero(&addr_, sizeof(addr_));
+    len_ = std::min<socklen_t>(len, sizeof(addr_));
+    memcpy(&addr_, addr, len_);
+  }
 
-  [[nodiscard]] const sockaddr_in &GetAddr() const { return addr_; }
+  /// 文件系统中的Unix域socket地址
+  /// @note 路径超过sun_path的长度时返回无效的地址，使用它的bind()/connect()会失败
+  static InetAddress UnixPath(std::string_view path) {
+    return Unix(path, false);
+  }
+  /// 抽象命名空间中的Unix域socket地址(不会在文件系统中创建文件)
+  static InetAddress AbstractUnix(std::string_view name) {
+    return Unix(name, true);
+  }
+
+  [[nodiscard]] sa_family_t GetFamily() const { return addr_.sa.sa_family; }
+  [[nodiscard]] bool IsUnix() const { return GetFamily() == AF_UNIX; }
+
+  [[nodiscard]] const struct sockaddr *GetSockAddr() const { return &addr_.sa; }
+  [[nodiscard]] socklen_t GetSockLen() const { return len_; }
+
+  /// @note 仅对IPv4地址有意义
+  [[nodiscard]] const sockaddr_in &GetAddr() const { return addr_.in; }
+
+  /// @return IP地址的端口号，Unix域socket返回0
+  [[nodiscard]] uint16_t GetPort() const {
+    switch (GetFamily()) {
+      case AF_INET: return ntohs(addr_.in.sin_port);
+      case AF_INET6: return ntohs(addr_.in6.sin6_port);
+      default: return 0;
+    }
+  }
+
+  /// @return 文件系统中的Unix域socket路径，其他地址返回空字符串
+  [[nodiscard]] std::string GetUnixPath() const {
+    if (!IsUnix() || IsAbstractUnix()) return "";
+    return {addr_.un.sun_path, strnlen(addr_.un.sun_path, sizeof(addr_.un.sun_path))};
+  }
 
   [[nodiscard]] std::string ToString() const {
-    char host[INET_ADDRSTRLEN] = "INVALID";
-    ::inet_ntop(AF_INET, &addr_.sin_addr, host, sizeof(host));
-    uint16_t port = ntohs(addr_.sin_port);
-    return fmt::format("{}:{}", host, port);
+    switch (GetFamily()) {
+      case AF_INET: {
+        char host[INET_ADDRSTRLEN] = "INVALID";
+        ::inet_ntop(AF_INET, &addr_.in.sin_addr, host, sizeof(host));
+        return fmt::format("{}:{}", host, GetPort());
+      }
+      case AF_INET6: {
+        char host[INET6_ADDRSTRLEN] = "INVALID";
+        ::inet_ntop(AF_INET6, &addr_.in6.sin6_addr, host, sizeof(host));
+        return fmt::format("[{}]:{}", host, GetPort());
+      }
+      case AF_UNIX: {
+        if (len_ == 0) return "INVALID";
+        if (IsAbstractUnix()) {
+          auto name_len = len_ - offsetof(struct sockaddr_un, sun_path) - 1;
+          return fmt::format("unix:@{}", std::string_view(addr_.un.sun_path + 1, name_len));
+        }
+        return fmt::format("unix:{}", GetUnixPath());
+      }
+      default:
+        return "INVALID";
+    }
   }
 
  private:
-  struct sockaddr_in addr_{};
+  InetAddress() : len_(0) { bzero(&addr_, sizeof(addr_)); }
+
+  static InetAddress Unix(std::string_view path, bool abstract) {
+    InetAddress addr;
+    addr.addr_.un.sun_family = AF_UNIX;
+    // 抽象命名空间的地址以'\0'开头，名字不需要结尾的'\0'；文件路径需要为结尾的'\0'保留一个字节
+    size_t offset = abstract ? 1 : 0;
+    size_t max_len = sizeof(addr.addr_.un.sun_path) - (abstract ? 0 : 1);
+    if (path.size() + offset > max_len) {
+      // 截断后的地址会指向另一个socket，保持地址长度为0，使bind()/connect()失败
+      LOG_ERROR("unix socket path too long: {}", path);
+      return addr;
+    }
+    memcpy(addr.addr_.un.sun_path + offset, path.data(), path.size());
+    // 抽象地址的长度需要精确到名字的末尾，文件路径则包含结尾的'\0'
+    addr.len_ = offsetof(struct sockaddr_un, sun_path) + offset + path.size() + (abstract ? 0 : 1);
+    return addr;
+  }
+
+  [[nodiscard]] bool IsAbstractUnix() const {
+    return IsUnix() && len_ > offsetof(struct sockaddr_un, sun_path) && addr_.un.sun_path[0] == '\0';
+  }
+
+  union {
+    struct sockaddr sa;
+    struct sockaddr_in in;
+    struct sockaddr_in6 in6;
+    struct sockaddr_un un;
+  } addr_{};
+  socklen_t len_;
 };
 
 using SA = struct sockaddr;
@@ -52,24 +166,28 @@ inline const SA *SACast(const struct sockaddr_in *addr) {
   return reinterpret_cast<const SA *>(addr);
 }
 
-inline struct sockaddr_in GetLocalAddr(int fd) {
-  struct sockaddr_in local_addr{};
+inline SA *SACast(struct sockaddr_storage *addr) {
+  return reinterpret_cast<SA *>(addr);
+}
+
+inline InetAddress GetLocalAddr(int fd) {
+  struct sockaddr_storage local_addr{};
   bzero(&local_addr, sizeof(local_addr));
   socklen_t addr_len = sizeof(local_addr);
   if (::getsockname(fd, SACast(&local_addr), &addr_len) < 0) {
     LOG_ERROR("getsockname() failed");
   }
-  return local_addr;
+  return {SACast(&local_addr), addr_len};
 }
 
-inline struct sockaddr_in GetPeerAddr(int fd) {
-  struct sockaddr_in peer_addr{};
+inline InetAddress GetPeerAddr(int fd) {
+  struct sockaddr_storage peer_addr{};
   bzero(&peer_addr, sizeof(peer_addr));
   socklen_t addr_len = sizeof(peer_addr);
   if (::getpeername(fd, SACast(&peer_addr), &addr_len) < 0) {
     LOG_ERROR("getpeername() failed");
   }
-  return peer_addr;
+  return {SACast(&peer_addr), addr_len};
 }
 
 } // namespace net
@@ -1,37 +1,75 @@
 #ifndef NET_INCLUDE_NET_SERVER_ACCEPTOR_HPP_
 #define NET_INCLUDE_NET_SERVER_ACCEPTOR_HPP_
 
+#include "net/socket_options.hpp"
 #include "net/reactor/reactor.hpp"
 
+#include <sys/stat.h>
+
 namespace net {
 
-/// 监听某个InetAddress, 通过调用Listen()接口将Acceptor注册到Reactor中
+/// 监听某个InetAddress(IPv4/IPv6/Unix域), 通过调用Listen()接口将Acceptor注册到Reactor中
 class Acceptor : noncopyable {
  public:
   using NewConnectionCallback = std::function<void(int conn_fd, const InetAddress &peer_addr)>;
 
   Acceptor(Reactor *reactor, const InetAddress &listen_addr)
       : reactor_(reactor),
-        channel_(NewNonBlockTcpSocketFd()) {
-    net::SetReuseAddr(channel_.GetFd(), true);
-    net::Bind(channel_.GetFd(), listen_addr);
+        channel_(NewNonBlockTcpSocketFd(listen_addr.GetFamily())) {
+    if (listen_addr.IsUnix()) {
+      RemoveStaleUnixSocket(listen_addr);
+    } else {
+      net::SetReuseAddr(channel_.GetFd(), true);
+    }
+    if (net::Bind(channel_.GetFd(), listen_addr) && listen_addr.IsUnix()) {
+      unix_path_ = listen_addr.GetUnixPath();
+    }
     channel_.SetReadCallback([this] { HandleRead(); });
   }
+  ~Acceptor() {
+    net::Close(channel_.GetFd());
+    // 只删除自己绑定的socket文件
+    if (!unix_path_.empty()) {
+      ::unlink(unix_path_.c_str());
+    }
+  }
 
   void SetNewConnectionCallback(NewConnectionCallback &&cb) {
     new_connection_callback_ = std::move(cb);
   }
 
+  /// 设置监听socket的选项，将在Listen()时生效
+  void SetSocketOptions(const SocketOptions &options) { options_ = options; }
+
   /// 开启监听，并将Acceptor中的Channel注册到Reactor中
   /// @note 线程安全(可在另一个线程调用该函数)
   void Listen() {
-    net::Listen(channel_.GetFd());
+    net::ApplyListenSocketOptions(channel_.GetFd(), options_);
+    net::Listen(channel_.GetFd(), options_.listen_backlog);
     channel_.EnableRead();
     reactor_->UpdateChannel(&channel_);
   }
  private:
+  /// 上次运行残留的socket文件会使bind()失败，只有确认它是没有进程监听的socket时才删除；
+  /// 普通文件或者仍在监听的socket保持不变，由bind()报错，避免误删文件或者抢占正在运行的服务器
+  static void RemoveStaleUnixSocket(const InetAddress &addr) {
+    std::string path = addr.GetUnixPath();
+    if (path.empty()) return;  // 抽象命名空间的地址没有文件
+    struct stat st{};
+    if (::lstat(path.c_str(), &st) < 0 || !S_ISSOCK(st.st_mode)) return;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return;
+    // 非阻塞连接，监听队列已满时返回EAGAIN而不是阻塞
+    bool stale = ::connect(fd, addr.GetSockAddr(), addr.GetSockLen()) < 0 && errno == ECONNREFUSED;
+    ::close(fd);
+    if (stale) {
+      ::unlink(path.c_str());
+    }
+  }
+
   void HandleRead() {
-    auto[conn_fd, peer_addr] = net::Accept(channel_.GetFd());
+    // TcpConnection要求连接socket是非阻塞的
+    auto[conn_fd, peer_addr] = net::NonBlockAccept(channel_.GetFd());
     if (conn_fd >= 0) {
       new_connection_callback_(conn_fd, peer_addr);
     } else {
@@ -41,7 +79,9 @@ class Acceptor : noncopyable {
 
   Reactor *reactor_;
   Channel channel_;
+  SocketOptions options_;
   NewConnectionCallback new_connection_callback_;
+  std::string unix_path_;   ///< 绑定成功的Unix域socket文件，析构时删除
 };
 
 } // namespace net
@@ -17,7 +17,7 @@ class Channel {
     Mod,
   };
 
-  explicit Channel(int fd) : fd_(fd), events_(0), revents_(0), state_(State::Add) {}
+  explicit Channel(int fd) : fd_(fd), events_(0), revents_(0), state_(State::Add), flush_pending_(false) {}
 
   [[nodiscard]] int GetFd() const { return fd_; }
 
@@ -27,6 +27,7 @@ class Channel {
   void DisableWrite() { events_ &= ~kWriteEvent; }
   void DisableAll() { events_ = kNoneEvent; }
 
+  [[nodiscard]] bool ReadEnabled() const { return events_ & kReadEvent; }
   [[nodiscard]] bool WriteEnabled() const { return events_ & kWriteEvent; }
   [[nodiscard]] int GetEvents() const { return events_; }
   [[nodiscard]] bool IsNoneEvent() const { return events_ == kNoneEvent; }
@@ -36,10 +37,21 @@ class Channel {
   void SetWriteCallback(const EventCallback &cb) { write_callback_ = cb; }
   void SetCloseCallback(const EventCallback &cb) { close_callback_ = cb; }
   void SetErrorCallback(const EventCallback &cb) { error_callback_ = cb; }
+  void SetFlushCallback(const EventCallback &cb) { flush_callback_ = cb; }
 
   void SetState(State state) { state_ = state; }
   [[nodiscard]] State GetState() const { return state_; }
 
+  /// 由Reactor维护，表示该Channel是否已在Reactor的待刷新列表中
+  void SetFlushPending(bool pending) { flush_pending_ = pending; }
+  [[nodiscard]] bool IsFlushPending() const { return flush_pending_; }
+
+  void HandleFlush() {
+    if (flush_callback_) {
+      flush_callback_();
+    }
+  }
+
   void HandleEvents() {
     if (revents_ & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) {
       if (read_callback_) {
@@ -73,8 +85,10 @@ class Channel {
   EventCallback write_callback_;
   EventCallback close_callback_;
   EventCallback error_callback_;
+  EventCallback flush_callback_;
 
   State state_;
+  bool flush_pending_;
 };
 
 } // namespace net
@@ -1,11 +1,12 @@
 #ifndef NET_INCLUDE_NET_CLIENT_CONNECTOR_HPP_
 #define NET_INCLUDE_NET_CLIENT_CONNECTOR_HPP_
 
+#include "net/socket_options.hpp"
 #include "net/reactor/reactor.hpp"
 
 namespace net {
 
-/// 连接某个InetAddress
+/// 连接某个InetAddress(IPv4/IPv6/Unix域)
 class Connector : noncopyable {
   static constexpr Duration kInitRetryDelay = std::chrono::milliseconds(500);
   static constexpr Duration kMaxRetryDelay = std::chrono::seconds(30);
@@ -32,6 +33,9 @@ class Connector : noncopyable {
     new_connection_callback_ = std::move(cb);
   }
 
+  /// 设置连接socket的选项，将在每次connect()之前生效
+  void SetSocketOptions(const SocketOptions &options) { options_ = options; }
+
   /// 向Reactor中添加一个启动任务
   /// @note 线程安全(可从另一个线程调用该函数)
   void Start() {
@@ -64,7 +68,8 @@ class Connector : noncopyable {
   void RealStart() {
     if (stopped_) return;
     NET_ASSERT(state_ == State::Disconnected);
-    int fd = net::NewNonBlockTcpSocketFd();
+    int fd = net::NewNonBlockTcpSocketFd(server_addr_.GetFamily());
+    net::ApplyConnectSocketOptions(fd, options_);
     int ret = net::Connect(fd, server_addr_);
     int saved_errno = ret == 0 ? 0 : errno;
     switch (saved_errno) {
@@ -80,6 +85,7 @@ class Connector : noncopyable {
       case EADDRNOTAVAIL:
       case ECONNREFUSED:
       case ENETUNREACH:
+      case ENOENT:          // Unix域socket文件尚未创建
         Retry(fd);
         break;
 
@@ -114,7 +120,10 @@ class Connector : noncopyable {
     net::Close(fd);
     state_ = State::Disconnected;
     if (!stopped_) {
-      reactor_->AddTimerAfter(retry_delay_, [this] { RealStart(); });
+      timer_id_ = reactor_->AddTimerAfter(retry_delay_, [this] {
+        timer_id_ = -1;
+        RealStart();
+      });
       retry_delay_ = std::min(retry_delay_ * 2, kMaxRetryDelay);
     }
   }
@@ -131,12 +140,14 @@ class Connector : noncopyable {
       Retry(fd);
     } else {
       state_ = State::Connected;
+      retry_delay_ = kInitRetryDelay;  // 连接成功后重置退避时间
       new_connection_callback_(fd);
     }
   }
   void HandleError() {
+    // 可写事件与错误事件可能同时到达，此时HandleWrite已经处理过了
+    if (state_ != State::Connecting) return;
     LOG_ERROR("Connector GetError");
-    NET_ASSERT(state_ == State::Connecting);
     int fd = ResetAndRemoveChannel();
     Retry(fd);
   }
@@ -145,7 +156,9 @@ class Connector : noncopyable {
     int fd = channel_->GetFd();
     channel_->DisableAll();
     reactor_->RemoveChannel(channel_.get());
-    channel_.reset();
+    // 当前正处于该Channel的HandleEvents中，不能立即析构，延迟到任务中释放
+    std::shared_ptr<Channel> channel(std::move(channel_));
+    reactor_->SubmitTask([channel] {});
     return fd;
   }
 
@@ -157,6 +170,7 @@ class Connector : noncopyable {
 
   Reactor *reactor_;
   InetAddress server_addr_;
+  SocketOptions options_;
   NewConnectionCallback new_connection_callback_;
   Duration retry_delay_;
   TimerQueue::TimerId timer_id_;
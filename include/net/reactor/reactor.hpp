@@ -37,16 +37,19 @@ class Reactor : noncopyable {
     stopped_ = false;
     while (!stopped_) {
       bool handled_many = HandleTasks();
+      HandlePendingFlush();
       int poll_time = handled_many ? 0 : kDefaultPollMs;
       is_polling_ = true;
       poller_.Poll(poll_time);
       is_polling_ = false;
+      HandlePendingFlush();
     }
     // 处理任务队列中剩余的任务
     Task task;
     while (task_queue_.try_dequeue(task)) {
       task();
     }
+    HandlePendingFlush();
   }
 
   void Stop() {
@@ -81,13 +84,26 @@ class Reactor : noncopyable {
     timer_queue_.CancleTimer(timer_id);
   }
 
+  /// 将channel加入待刷新列表，在本轮任务或事件处理完成之后，统一调用一次其FlushCallback
+  /// @note 同一个channel在一轮中重复加入只会被刷新一次
+  void QueueFlush(Channel *channel) {
+    if (channel->IsFlushPending()) return;
+    channel->SetFlushPending(true);
+    pending_flush_vec_.push_back(channel);
+  }
+
   // 根据https://stackoverflow.com/questions/7058737/is-epoll-thread-safe, epoll是线程安全的
   // 也就代表以下函数是线程安全的
   // 以下函数只建议在框架内部使用
   void UpdateChannel(Channel *channel) {
     poller_.UpdateChannel(channel);
   }
+  /// @note 如果channel在待刷新列表中，会将其移除，此时只能在Reactor绑定线程中调用
   void RemoveChannel(Channel *channel) {
+    if (channel->IsFlushPending()) {
+      channel->SetFlushPending(false);
+      std::replace(pending_flush_vec_.begin(), pending_flush_vec_.end(), channel, static_cast<Channel *>(nullptr));
+    }
     poller_.RemoveChannel(channel);
   }
 
@@ -107,10 +123,22 @@ class Reactor : noncopyable {
     return false;
   }
 
+  /// 调用所有待刷新Channel的FlushCallback，FlushCallback中可能会再次调用QueueFlush或RemoveChannel
+  void HandlePendingFlush() {
+    for (size_t i = 0; i < pending_flush_vec_.size(); ++i) {
+      Channel *channel = pending_flush_vec_[i];
+      if (channel == nullptr) continue;  // 已被RemoveChannel移除
+      channel->SetFlushPending(false);
+      channel->HandleFlush();
+    }
+    pending_flush_vec_.clear();
+  }
+
   containers::MPMCQueue<Task> task_queue_;  // TODO: 使用MPSC队列性能可能会更好
   TimerQueue timer_queue_;
   Waker waker_;
   Poller poller_;
+  std::vector<Channel *> pending_flush_vec_;  // 本轮中需要刷新的Channel
   bool stopped_;
   bool is_polling_;             // poller正在轮询中
   std::thread::id thread_id_;   // 当前Reactor所绑定到的线程的ID
@@ -5,6 +5,7 @@
 #include "net/util/chrono.hpp"
 
 #include <set>
+#include <unordered_map>
 #include <sys/timerfd.h>
 
 namespace net {
@@ -31,7 +32,8 @@ inline void SetTimerFd(int timer_fd, TimePoint expiration) {
   struct itimerspec old_val{};
   bzero(&new_val, sizeof(new_val));
   bzero(&old_val, sizeof(old_val));
-  new_val.it_value = ToTimespec(expiration - GetNow());
+  // it_value为0会关闭定时器，因此对已经过期的时间设置一个最小值
+  new_val.it_value = ToTimespec(std::max(expiration - GetNow(), Duration(std::chrono::microseconds(100))));
   if (::timerfd_settime(timer_fd, 0, &new_val, &old_val) < 0) {
     LOG_ERROR("timerfd_settime() failed");
   }
@@ -51,12 +53,14 @@ class TimerQueue {
         : task(std::move(task)),
           expiration(expiration),
           interval(interval),
-          timer_id(timer_id) {}
+          timer_id(timer_id),
+          cancelled(false) {}
 
     Task task;              ///< 过期时需要运行的任务
     TimePoint expiration;   ///< 过期时间
     Duration interval;      ///< 重复间隔
     TimerId timer_id;       ///< 在TimerQueue中的唯一标识
+    bool cancelled;         ///< 是否在本轮过期之后被取消
   };
 
   TimerQueue()
@@ -76,43 +80,49 @@ class TimerQueue {
 
   TimerId AddTimer(TimePoint expiration, Duration interval, Task &&task) {
     auto timer = new Timer(std::move(task), expiration, interval, ++id_);
+    timer_map_.emplace(timer->timer_id, timer);
     bool earliest_changed = Insert(timer);
     if (earliest_changed) {
       detail::SetTimerFd(channel_.GetFd(), expiration);
     }
     return timer->timer_id;
   }
-  // 考虑到CancleTimer的需求应该不是很多，所以实现为O(N)级别的复杂度，如果要优化的话，可以考虑用空间换时间
+  /// 通过timer_map_查找Timer，复杂度为O(logN)，可用于大量频繁取消的超时定时器(例如RPC调用的超时)
   void CancleTimer(TimerId timer_id) {
-    auto pos = std::find_if(timer_set_.begin(), timer_set_.end(), [timer_id](const Entry &entry) {
-      auto timer = entry.second;
-      return timer->timer_id == timer_id;
-    });
-    if (pos != timer_set_.end()) {
-      delete (*pos).second;
-      timer_set_.erase(pos);
+    auto pos = timer_map_.find(timer_id);
+    if (pos == timer_map_.end()) return;
+    Timer *timer = pos->second;
+    if (timer_set_.erase({timer->expiration, timer}) > 0) {
+      timer_map_.erase(pos);
+      delete timer;
+      return;
     }
+    // 在Timer的Task中取消本轮过期的Timer(可能正是正在运行的Task本身)，
+    // 此时不能销毁Task，只做标记，由HandleRead负责释放
+    timer->cancelled = true;
   }
  private:
   void HandleRead() {
     detail::ReadTimerFd(channel_.GetFd());
     auto sentinel = std::make_pair(GetNow(), reinterpret_cast<Timer *>(UINTPTR_MAX));
     auto expired_end = timer_set_.lower_bound(sentinel);
-    std::set<Entry> renew_timer_set;
+    // 先将过期的Timer从timer_set_中取出，避免Task中新添加的Timer在本轮中被误调用
+    expired_vec_.assign(timer_set_.begin(), expired_end);
+    timer_set_.erase(timer_set_.begin(), expired_end);
     // 调用所有过期的Timer的Task
-    for (auto it = timer_set_.begin(); it != expired_end; ++it) {
-      auto timer = it->second;
-      timer->task();
-      if (timer->interval != Duration(0)) { // 是需要重复的Timer
+    for (auto &[tp, timer]: expired_vec_) {
+      if (!timer->cancelled) {
+        timer->task();
+      }
+      if (!timer->cancelled && timer->interval != Duration(0)) { // 是需要重复的Timer
         timer->expiration += timer->interval;
-        renew_timer_set.emplace(timer->expiration, timer);
+        timer_set_.emplace(timer->expiration, timer);
       } else {
+        timer_map_.erase(timer->timer_id);
         delete timer;
       }
     }
-    timer_set_.erase(timer_set_.begin(), expired_end);
-    // TODO: 使用set_union可能比insert更好, 或者考虑把renew_timer从set换成其他可以线性插入的容器
-    timer_set_.insert(renew_timer_set.begin(), renew_timer_set.end());
+    expired_vec_.clear();
     auto next_expiration = timer_set_.empty() ?
                            TimePoint{} :
                            timer_set_.begin()->second->expiration;
@@ -134,6 +144,8 @@ class TimerQueue {
 
   Channel channel_;
   std::set<Entry> timer_set_;
+  std::vector<Entry> expired_vec_;  ///< 正在处理中的过期Timer
+  std::unordered_map<TimerId, Timer *> timer_map_;  ///< 所有未释放的Timer，用于取消Timer
   TimerId id_;                      ///< 用于给Timer分配Id
 };
 
@@ -0,0 +1,161 @@
+#ifndef NET_INCLUDE_NET_RPC_RPC_CHANNEL_HPP_
+#define NET_INCLUDE_NET_RPC_RPC_CHANNEL_HPP_
+
+#include "net/rpc/rpc_protocol.hpp"
+#include "net/tcp/tcp_client.hpp"
+
+#include <unordered_map>
+
+namespace net {
+
+/// 客户端的RPC通道，在一个连接上同时发起多个调用，通过call_id匹配乱序返回的响应，
+/// 每个调用的截止时间由连接所属Reactor的TimerQueue负责
+/// @note 非线程安全，所有接口都需要在连接所属的Reactor线程中调用，跨线程调用请使用RpcClient
+/// @note 请在Reactor停止之后再销毁RpcChannel
+class RpcChannel : noncopyable {
+ public:
+  /// 第二个参数为响应的内容，只在回调期间有效
+  using ResponseCallback = std::function<void(RpcStatus, std::string_view)>;
+
+  static constexpr Duration kDefaultTimeout = std::chrono::seconds(5);
+
+  explicit RpcChannel(size_t max_frame_size = rpc::RpcCodec::kDefaultMaxFrameSize)
+      : codec_([this](const TcpConnectionPtr &, std::string_view frame) { HandleFrame(frame); },
+               max_frame_size),
+        reactor_(nullptr),
+        next_call_id_(1) {}
+
+  /// 在连接的ConnectionCallback中调用，连接断开时所有未完成的调用都将以ConnectionClosed结束
+  void OnConnection(const TcpConnectionPtr &conn) {
+    if (conn->Connected()) {
+      connection_ = conn;
+      reactor_ = conn->GetReactor();
+    } else {
+      connection_.reset();
+      FailAll(RpcStatus::ConnectionClosed);
+    }
+  }
+  /// 作为连接的MessageCallback
+  void OnMessage(const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+    codec_.OnMessage(conn, buffer);
+  }
+
+  /// 发起一次调用，不等待之前的调用完成
+  /// @param cb 收到响应、超时或者连接断开时调用，并且只调用一次
+  void Call(uint32_t method_id, std::string_view request, ResponseCallback &&cb,
+            Duration timeout = kDefaultTimeout) {
+    if (!connection_ || !connection_->Connected()) {
+      cb(RpcStatus::NotConnected, {});
+      return;
+    }
+    uint64_t call_id = next_call_id_++;
+    auto timer_id = reactor_->AddTimerAfter(timeout, [this, call_id] { HandleTimeout(call_id); });
+    pending_call_map_.emplace(call_id, PendingCall{std::move(cb), timer_id});
+    RpcHeader header;
+    header.kind = RpcHeader::Kind::Request;
+    header.method_id = method_id;
+    header.call_id = call_id;
+    rpc::SendMessage(connection_, header, request);
+  }
+
+  /// @return 尚未完成的调用数
+  [[nodiscard]] size_t GetPendingCallNum() const { return pending_call_map_.size(); }
+
+ private:
+  struct PendingCall {
+    ResponseCallback callback;
+    Reactor::TimerId timer_id;
+  };
+
+  void HandleFrame(std::string_view frame) {
+    RpcHeader header;
+    if (!header.Decode(frame) || header.kind != RpcHeader::Kind::Response) {
+      LOG_ERROR("invalid rpc response");
+      return;
+    }
+    auto pos = pending_call_map_.find(header.call_id);
+    if (pos == pending_call_map_.end()) return;  // 已经超时
+    PendingCall call = std::move(pos->second);
+    pending_call_map_.erase(pos);
+    reactor_->CancleTimer(call.timer_id);
+    call.callback(header.status, frame.substr(RpcHeader::kSize));
+  }
+  void HandleTimeout(uint64_t call_id) {
+    auto pos = pending_call_map_.find(call_id);
+    if (pos == pending_call_map_.end()) return;
+    PendingCall call = std::move(pos->second);
+    pending_call_map_.erase(pos);
+    call.callback(RpcStatus::Timeout, {});
+  }
+  void FailAll(RpcStatus status) {
+    // 回调中可能发起新的调用，因此先将未完成的调用取出
+    auto pending_call_map = std::move(pending_call_map_);
+    pending_call_map_.clear();
+    for (auto &[call_id, call]: pending_call_map) {
+      reactor_->CancleTimer(call.timer_id);
+      call.callback(status, {});
+    }
+  }
+
+  rpc::RpcCodec codec_;
+  TcpConnectionPtr connection_;
+  Reactor *reactor_;
+  uint64_t next_call_id_;
+  std::unordered_map<uint64_t, PendingCall> pending_call_map_;
+};
+
+/// 使用TcpClient连接RpcServer的客户端
+class RpcClient : noncopyable {
+ public:
+  using ConnectionCallback = TcpClient::ConnectionCallback;
+  using ResponseCallback = RpcChannel::ResponseCallback;
+
+  RpcClient(Reactor *reactor, const InetAddress &server_addr)
+      : client_(reactor, server_addr) {
+    client_.SetConnectionCallback([this](const TcpConnectionPtr &conn) {
+      channel_.OnConnection(conn);
+      if (connection_callback_) {
+        connection_callback_(conn);
+      }
+    });
+    client_.SetMessageCallback([this](const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+      channel_.OnMessage(conn, buffer);
+    });
+  }
+
+  void SetConnectionCallback(const ConnectionCallback &cb) {
+    connection_callback_ = cb;
+  }
+  void SetRetry(bool on) { client_.SetRetry(on); }
+  void SetSocketOptions(const SocketOptions &options) { client_.SetSocketOptions(options); }
+  /// 参见TcpConnection::SetCork，开启后同一轮中发起的多个调用将合并成一次写
+  void SetCork(bool on) { client_.SetCork(on); }
+
+  void Connect() { client_.Connect(); }
+  void Disconnect() { client_.Disconnect(); }
+
+  /// 发起一次调用，参见RpcChannel::Call，回调总是在Reactor线程中执行
+  /// @note 线程安全，从其他线程调用时会复制一份request
+  void Call(uint32_t method_id, std::string_view request, ResponseCallback &&cb,
+            Duration timeout = RpcChannel::kDefaultTimeout) {
+    Reactor *reactor = client_.GetReactor();
+    if (reactor->InCurrentReactorThread()) {
+      channel_.Call(method_id, request, std::move(cb), timeout);
+    } else {
+      reactor->SubmitTask([this, method_id, str = std::string(request), cb = std::move(cb), timeout]() mutable {
+        channel_.Call(method_id, str, std::move(cb), timeout);
+      });
+    }
+  }
+
+  Reactor *GetReactor() const { return client_.GetReactor(); }
+
+ private:
+  TcpClient client_;
+  RpcChannel channel_;
+  ConnectionCallback connection_callback_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_RPC_RPC_CHANNEL_HPP_
@@ -0,0 +1,80 @@
+#ifndef NET_INCLUDE_NET_RPC_RPC_PROTOCOL_HPP_
+#define NET_INCLUDE_NET_RPC_RPC_PROTOCOL_HPP_
+
+#include "net/codec/length_field_codec.hpp"
+
+namespace net {
+
+/// RPC调用的结果
+enum class RpcStatus : uint8_t {
+  Ok = 0,
+  MethodNotFound = 1,     ///< 服务端没有注册该方法
+  Timeout = 2,            ///< 在截止时间之前没有收到响应
+  ConnectionClosed = 3,   ///< 等待响应时连接断开
+  NotConnected = 4,       ///< 发起调用时连接尚未建立
+  Error = 5,              ///< 服务端处理失败
+};
+
+inline std::string_view ToString(RpcStatus status) {
+  switch (status) {
+    case RpcStatus::Ok: return "Ok";
+    case RpcStatus::MethodNotFound: return "MethodNotFound";
+    case RpcStatus::Timeout: return "Timeout";
+    case RpcStatus::ConnectionClosed: return "ConnectionClosed";
+    case RpcStatus::NotConnected: return "NotConnected";
+    case RpcStatus::Error: return "Error";
+  }
+  return "Unknown";
+}
+
+/// RPC消息头，位于LengthFieldCodec<uint32_t>一帧消息体的开头，其后为请求或响应的内容
+///
+/// | kind(1) | status(1) | reserved(2) | method_id(4) | call_id(8) |，多字节整数均为网络字节序
+struct RpcHeader {
+  enum class Kind : uint8_t {
+    Request = 0,
+    Response = 1,
+  };
+
+  static constexpr size_t kSize = 16;
+
+  Kind kind = Kind::Request;
+  RpcStatus status = RpcStatus::Ok;
+  uint32_t method_id = 0;
+  uint64_t call_id = 0;   ///< 请求的关联ID，响应中原样带回，用于在同一连接上匹配乱序返回的响应
+
+  void Encode(char *out) const {
+    out[0] = static_cast<char>(kind);
+    out[1] = static_cast<char>(status);
+    out[2] = out[3] = 0;
+    LengthFieldCodec<uint32_t>::EncodeLength(method_id, out + 4);
+    LengthFieldCodec<uint64_t>::EncodeLength(call_id, out + 8);
+  }
+  /// @return 帧的长度不足一个消息头时返回false
+  bool Decode(std::string_view frame) {
+    if (frame.size() < kSize) return false;
+    kind = static_cast<Kind>(frame[0]);
+    status = static_cast<RpcStatus>(frame[1]);
+    method_id = static_cast<uint32_t>(LengthFieldCodec<uint32_t>::DecodeLength(frame.data() + 4));
+    call_id = LengthFieldCodec<uint64_t>::DecodeLength(frame.data() + 8);
+    return true;
+  }
+};
+
+namespace rpc {
+
+using RpcCodec = LengthFieldCodec<uint32_t>;
+
+/// 发送一条RPC消息，消息头和内容通过一次writev写出
+/// @note 线程安全
+inline void SendMessage(const TcpConnectionPtr &conn, const RpcHeader &header, std::string_view body) {
+  char buf[RpcHeader::kSize];
+  header.Encode(buf);
+  RpcCodec::Send(conn, std::string_view(buf, sizeof(buf)), body);
+}
+
+} // namespace net::rpc
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_RPC_RPC_PROTOCOL_HPP_
@@ -0,0 +1,137 @@
+#ifndef NET_INCLUDE_NET_RPC_RPC_SERVER_HPP_
+#define NET_INCLUDE_NET_RPC_RPC_SERVER_HPP_
+
+#include "net/rpc/rpc_protocol.hpp"
+#include "net/tcp/tcp_server.hpp"
+
+#include <unordered_map>
+
+namespace net {
+
+/// 服务端对一次调用的应答句柄，可以保存下来稍后在任意线程中应答，同一连接上的响应可以乱序返回
+/// 析构时如果还没有应答，将自动以RpcStatus::Error应答
+class RpcResponder {
+ public:
+  RpcResponder(TcpConnectionPtr conn, uint32_t method_id, uint64_t call_id)
+      : connection_(std::move(conn)),
+        method_id_(method_id),
+        call_id_(call_id) {}
+  RpcResponder(RpcResponder &&other) noexcept = default;
+  RpcResponder &operator=(RpcResponder &&other) noexcept {
+    if (this != &other) {
+      Fail();
+      connection_ = std::move(other.connection_);
+      method_id_ = other.method_id_;
+      call_id_ = other.call_id_;
+    }
+    return *this;
+  }
+  ~RpcResponder() { Fail(); }
+
+  /// 以RpcStatus::Ok应答
+  void Reply(std::string_view response) {
+    Send(RpcStatus::Ok, response);
+  }
+  /// 以错误状态应答，message将作为响应的内容
+  void Fail(RpcStatus status = RpcStatus::Error, std::string_view message = {}) {
+    Send(status, message);
+  }
+
+  /// @return 是否已经应答
+  [[nodiscard]] bool Replied() const { return !connection_; }
+  [[nodiscard]] const TcpConnectionPtr &GetConnection() const { return connection_; }
+
+ private:
+  void Send(RpcStatus status, std::string_view body) {
+    if (!connection_) return;  // 每次调用只能应答一次
+    RpcHeader header;
+    header.kind = RpcHeader::Kind::Response;
+    header.status = status;
+    header.method_id = method_id_;
+    header.call_id = call_id_;
+    rpc::SendMessage(connection_, header, body);
+    connection_.reset();
+  }
+
+  TcpConnectionPtr connection_;
+  uint32_t method_id_;
+  uint64_t call_id_;
+};
+
+/// 按照method_id将请求分发到注册的方法上
+class RpcDispatcher : noncopyable {
+ public:
+  /// 第一个参数为请求的内容，只在调用期间有效
+  using Method = std::function<void(std::string_view, RpcResponder)>;
+
+  explicit RpcDispatcher(size_t max_frame_size = rpc::RpcCodec::kDefaultMaxFrameSize)
+      : codec_([this](const TcpConnectionPtr &conn, std::string_view frame) { HandleFrame(conn, frame); },
+               max_frame_size) {}
+
+  /// @note 请在开始处理请求之前注册，非线程安全
+  void RegisterMethod(uint32_t method_id, Method method) {
+    method_map_[method_id] = std::move(method);
+  }
+
+  /// 作为连接的MessageCallback
+  void OnMessage(const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+    codec_.OnMessage(conn, buffer);
+  }
+
+ private:
+  void HandleFrame(const TcpConnectionPtr &conn, std::string_view frame) {
+    RpcHeader header;
+    if (!header.Decode(frame) || header.kind != RpcHeader::Kind::Request) {
+      LOG_ERROR("invalid rpc request, force close");
+      conn->ForceClose();
+      return;
+    }
+    RpcResponder responder(conn, header.method_id, header.call_id);
+    auto pos = method_map_.find(header.method_id);
+    if (pos == method_map_.end()) {
+      responder.Fail(RpcStatus::MethodNotFound);
+      return;
+    }
+    pos->second(frame.substr(RpcHeader::kSize), std::move(responder));
+  }
+
+  rpc::RpcCodec codec_;
+  std::unordered_map<uint32_t, Method> method_map_;
+};
+
+/// 基于TcpServer的RPC服务端
+class RpcServer : noncopyable {
+ public:
+  using ConnectionCallback = TcpServer::ConnectionCallback;
+  using Method = RpcDispatcher::Method;
+
+  RpcServer(Reactor *reactor, const InetAddress &listen_addr)
+      : server_(reactor, listen_addr) {
+    server_.SetMessageCallback([this](const TcpConnectionPtr &conn, const BufferPtr &buffer) {
+      dispatcher_.OnMessage(conn, buffer);
+    });
+  }
+
+  /// @note 请确保线程数大于0
+  void SetThreadNum(int thread_num) { server_.SetThreadNum(thread_num); }
+  void SetConnectionCallback(const ConnectionCallback &cb) { server_.SetConnectionCallback(cb); }
+  void SetSocketOptions(const SocketOptions &options) { server_.SetSocketOptions(options); }
+  /// 参见TcpConnection::SetCork，开启后同一轮中的多个响应将合并成一次写
+  void SetCork(bool on) { server_.SetCork(on); }
+
+  /// 注册方法，方法在连接所属的Reactor线程中调用
+  /// @note 请在Start之前注册
+  void RegisterMethod(uint32_t method_id, Method method) {
+    dispatcher_.RegisterMethod(method_id, std::move(method));
+  }
+
+  void Start() { server_.Start(); }
+
+ private:
+  TcpServer server_;
+  RpcDispatcher dispatcher_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_RPC_RPC_SERVER_HPP_
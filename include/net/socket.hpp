@@ -4,13 +4,26 @@
 #include "net/buffer.hpp"
 #include "net/inet_address.hpp"
 
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <unistd.h>
+#include <sys/sendfile.h>
 #include <sys/uio.h>
 
 namespace net {
 
 inline constexpr int kMaxSegmentSize = 65536;
 
+namespace detail {
+
+inline void SetIntOption(int fd, int level, int optname, int optval, const char *name) {
+  if (::setsockopt(fd, level, optname, &optval, sizeof(optval)) == -1) {
+    LOG_ERROR("setsockopt({}) failed: {}", name, strerror(errno));
+  }
+}
+
+} // namespace net::detail
+
 inline void SetReuseAddr(int fd, bool on) {
   int optval = on ? 1 : 0;
   if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) == -1) {
@@ -18,43 +31,100 @@ inline void SetReuseAddr(int fd, bool on) {
   }
 }
 
-inline void Bind(int fd, const InetAddress &addr) {
-  if (::bind(fd, SACast(&addr.GetAddr()), sizeof(struct sockaddr_in)) == -1) {
+/// SO_REUSEPORT，多个socket可以绑定同一个地址，由内核在它们之间分发连接或数据报
+inline void SetReusePort(int fd, bool on) {
+  detail::SetIntOption(fd, SOL_SOCKET, SO_REUSEPORT, on ? 1 : 0, "SO_REUSEPORT");
+}
+
+inline void SetTcpNoDelay(int fd, bool on) {
+  detail::SetIntOption(fd, IPPROTO_TCP, TCP_NODELAY, on ? 1 : 0, "TCP_NODELAY");
+}
+
+/// @note Linux会在一段时间后自动清除TCP_QUICKACK，因此只对设置之后的若干ACK生效
+inline void SetTcpQuickAck(int fd, bool on) {
+  detail::SetIntOption(fd, IPPROTO_TCP, TCP_QUICKACK, on ? 1 : 0, "TCP_QUICKACK");
+}
+
+inline void SetSendBufferSize(int fd, int size) {
+  detail::SetIntOption(fd, SOL_SOCKET, SO_SNDBUF, size, "SO_SNDBUF");
+}
+
+inline void SetRecvBufferSize(int fd, int size) {
+  detail::SetIntOption(fd, SOL_SOCKET, SO_RCVBUF, size, "SO_RCVBUF");
+}
+
+/// @param idle,interval,count 为0表示使用系统默认值，idle和interval的单位为秒
+inline void SetKeepAlive(int fd, bool on, int idle = 0, int interval = 0, int count = 0) {
+  detail::SetIntOption(fd, SOL_SOCKET, SO_KEEPALIVE, on ? 1 : 0, "SO_KEEPALIVE");
+  if (!on) return;
+  if (idle > 0) detail::SetIntOption(fd, IPPROTO_TCP, TCP_KEEPIDLE, idle, "TCP_KEEPIDLE");
+  if (interval > 0) detail::SetIntOption(fd, IPPROTO_TCP, TCP_KEEPINTVL, interval, "TCP_KEEPINTVL");
+  if (count > 0) detail::SetIntOption(fd, IPPROTO_TCP, TCP_KEEPCNT, count, "TCP_KEEPCNT");
+}
+
+/// 对监听socket设置TCP Fast Open的队列长度
+inline void SetTcpFastOpen(int fd, int queue_len) {
+  detail::SetIntOption(fd, IPPROTO_TCP, TCP_FASTOPEN, queue_len, "TCP_FASTOPEN");
+}
+
+/// 对客户端socket开启TCP Fast Open，需要在connect()之前调用
+inline void SetTcpFastOpenConnect(int fd, bool on) {
+#ifdef TCP_FASTOPEN_CONNECT
+  detail::SetIntOption(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, on ? 1 : 0, "TCP_FASTOPEN_CONNECT");
+#else
+  LOG_ERROR("TCP_FASTOPEN_CONNECT is not supported");
+#endif
+}
+
+inline void SetTcpNotSentLowat(int fd, int bytes) {
+  detail::SetIntOption(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, bytes, "TCP_NOTSENT_LOWAT");
+}
+
+/// @param usec 在没有数据时，阻塞读操作忙等待的微秒数
+inline void SetBusyPoll(int fd, int usec) {
+  detail::SetIntOption(fd, SOL_SOCKET, SO_BUSY_POLL, usec, "SO_BUSY_POLL");
+}
+
+/// @return bind()失败时返回false
+inline bool Bind(int fd, const InetAddress &addr) {
+  if (::bind(fd, addr.GetSockAddr(), addr.GetSockLen()) == -1) {
     LOG_ERROR("bind() failed");
+    return false;
   }
+  return true;
 }
 
-inline void Listen(int fd) {
-  if (::listen(fd, SOMAXCONN) == -1) {
+inline void Listen(int fd, int backlog = SOMAXCONN) {
+  if (::listen(fd, backlog) == -1) {
     LOG_ERROR("listen() failed");
   }
 }
 
 inline std::pair<int, InetAddress> Accept(int fd) {
-  struct sockaddr_in peer_addr{};
-  socklen_t addr_len = sizeof(struct sockaddr_in);
+  struct sockaddr_storage peer_addr{};
+  socklen_t addr_len = sizeof(peer_addr);
   int conn_fd = ::accept4(fd, SACast(&peer_addr),
                           &addr_len, SOCK_CLOEXEC);
   if (conn_fd == -1) {
     LOG_ERROR("accept4() failed");
   }
-  return {conn_fd, InetAddress(peer_addr)};
+  return {conn_fd, InetAddress(SACast(&peer_addr), addr_len)};
 }
 
 inline std::pair<int, InetAddress> NonBlockAccept(int fd) {
-  struct sockaddr_in peer_addr{};
-  socklen_t addr_len = sizeof(struct sockaddr_in);
+  struct sockaddr_storage peer_addr{};
+  socklen_t addr_len = sizeof(peer_addr);
   int conn_fd = ::accept4(fd, SACast(&peer_addr),
                           &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
   if (conn_fd == -1) {
     LOG_ERROR("accept4() failed");
   }
-  return {conn_fd, InetAddress(peer_addr)};
+  return {conn_fd, InetAddress(SACast(&peer_addr), addr_len)};
 }
 
 /// 对connect()的封装，不处理错误，需要使用者根据返回值自己进行处理
 inline int Connect(int fd, const InetAddress &addr) {
-  return ::connect(fd, SACast(&addr.GetAddr()), sizeof(struct sockaddr_in));
+  return ::connect(fd, addr.GetSockAddr(), addr.GetSockLen());
 }
 
 inline ssize_t Read(int fd, const BufferPtr &buffer) {
@@ -79,12 +149,29 @@ inline ssize_t Read(int fd, const BufferPtr &buffer) {
 
 inline ssize_t Write(int fd, const char *data, size_t len) {
   ssize_t n = ::write(fd, data, len);
-  if (n < 0) {
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {  // 发送缓冲区已满不是错误，剩余的数据等待可写事件
     LOG_ERROR("write() failed");
   }
   return n;
 }
 
+inline ssize_t Writev(int fd, const struct iovec *iov, int iovcnt) {
+  ssize_t n = ::writev(fd, iov, iovcnt);
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {  // 发送缓冲区已满不是错误，剩余的数据等待可写事件
+    LOG_ERROR("writev() failed");
+  }
+  return n;
+}
+
+/// 将in_fd中从*offset开始的count字节直接发送到out_fd，不经过用户态，*offset随之前移
+inline ssize_t SendFile(int out_fd, int in_fd, off_t *offset, size_t count) {
+  ssize_t n = ::sendfile(out_fd, in_fd, offset, count);
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    LOG_ERROR("sendfile() failed");
+  }
+  return n;
+}
+
 inline ssize_t Write(int fd, const BufferPtr &buffer) {
   return net::Write(fd, buffer->GetReadPtr(), buffer->ReadableBytes());
 }
@@ -111,30 +198,77 @@ inline int GetSocketError(int fd) {
   }
 }
 
+/// @return 返回socket所属的协议族(AF_INET/AF_INET6/AF_UNIX)
+inline int GetSocketDomain(int fd) {
+  int optval = 0;
+  socklen_t optlen = sizeof(optval);
+  if (::getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &optval, &optlen) < 0) {
+    LOG_ERROR("getsockopt(SO_DOMAIN) failed");
+  }
+  return optval;
+}
+
+/// 判断是否是TCP自连接(本地地址和对端地址相同)，Unix域socket不会出现自连接
 inline bool IsSelfConnect(int fd) {
-  struct sockaddr_in local_addr = net::GetLocalAddr(fd);
-  struct sockaddr_in peer_addr = net::GetPeerAddr(fd);
-  return local_addr.sin_port == peer_addr.sin_port &&
-      local_addr.sin_addr.s_addr == peer_addr.sin_addr.s_addr;
+  InetAddress local_addr = net::GetLocalAddr(fd);
+  InetAddress peer_addr = net::GetPeerAddr(fd);
+  if (local_addr.GetFamily() != peer_addr.GetFamily()) return false;
+  if (local_addr.GetFamily() == AF_INET) {
+    auto &local = reinterpret_cast<const struct sockaddr_in &>(*local_addr.GetSockAddr());
+    auto &peer = reinterpret_cast<const struct sockaddr_in &>(*peer_addr.GetSockAddr());
+    return local.sin_port == peer.sin_port &&
+        local.sin_addr.s_addr == peer.sin_addr.s_addr;
+  } else if (local_addr.GetFamily() == AF_INET6) {
+    auto &local = reinterpret_cast<const struct sockaddr_in6 &>(*local_addr.GetSockAddr());
+    auto &peer = reinterpret_cast<const struct sockaddr_in6 &>(*peer_addr.GetSockAddr());
+    return local.sin6_port == peer.sin6_port &&
+        memcmp(&local.sin6_addr, &peer.sin6_addr, sizeof(local.sin6_addr)) == 0;
+  }
+  return false;
 }
 
-inline int NewTcpSocketFd() {
-  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+/// @param family AF_INET、AF_INET6或AF_UNIX，AF_UNIX将创建Unix域流式socket
+inline int NewTcpSocketFd(int family = AF_INET) {
+  int protocol = family == AF_UNIX ? 0 : IPPROTO_TCP;
+  int fd = ::socket(family, SOCK_STREAM | SOCK_CLOEXEC, protocol);
   if (fd == -1) {
     LOG_FATAL("socket() failed");
   }
   return fd;
 }
 
-inline int NewNonBlockTcpSocketFd() {
-  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+/// @param family AF_INET、AF_INET6或AF_UNIX，AF_UNIX将创建Unix域流式socket
+inline int NewNonBlockTcpSocketFd(int family = AF_INET) {
+  int protocol = family == AF_UNIX ? 0 : IPPROTO_TCP;
+  int fd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
   if (fd == -1) {
     LOG_FATAL("socket() failed");
   }
   return fd;
 }
 
-/// IPv4 socket
+/// @param family AF_INET、AF_INET6或AF_UNIX，AF_UNIX将创建Unix域数据报socket
+inline int NewNonBlockUdpSocketFd(int family = AF_INET) {
+  int protocol = family == AF_UNIX ? 0 : IPPROTO_UDP;
+  int fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+  if (fd == -1) {
+    LOG_FATAL("socket() failed");
+  }
+  return fd;
+}
+
+/// 开启UDP GRO，内核会将同一个流上连续的数据报合并后一次交给recvmsg，并通过控制消息给出分段大小
+/// @return 内核不支持时返回false
+inline bool SetUdpGro(int fd, bool on) {
+#ifdef UDP_GRO
+  int optval = on ? 1 : 0;
+  return ::setsockopt(fd, IPPROTO_UDP, UDP_GRO, &optval, sizeof(optval)) == 0;
+#else
+  return false;
+#endif
+}
+
+/// 流式socket(IPv4/IPv6/Unix域)
 class Socket {
  public:
   explicit Socket(int fd) : fd_(fd) {}
@@ -145,12 +279,20 @@ class Socket {
     net::SetReuseAddr(fd_, on);
   }
 
+  void SetTcpNoDelay(bool on) const {
+    net::SetTcpNoDelay(fd_, on);
+  }
+
+  void SetKeepAlive(bool on) const {
+    net::SetKeepAlive(fd_, on);
+  }
+
   void Bind(const InetAddress &addr) const {
     net::Bind(fd_, addr);
   }
 
-  void Listen() const {
-    net::Listen(fd_);
+  void Listen(int backlog = SOMAXCONN) const {
+    net::Listen(fd_, backlog);
   }
 
   [[nodiscard]] std::pair<Socket, InetAddress> Accept() const {
@@ -187,12 +329,12 @@ class Socket {
   int fd_;
 };
 
-inline Socket NewTcpSocket() {
-  return Socket(NewTcpSocketFd());
+inline Socket NewTcpSocket(int family = AF_INET) {
+  return Socket(NewTcpSocketFd(family));
 }
 
-inline Socket NewNonBlockTcpSocket() {
-  return Socket(NewNonBlockTcpSocketFd());
+inline Socket NewNonBlockTcpSocket(int family = AF_INET) {
+  return Socket(NewNonBlockTcpSocketFd(family));
 }
 
 } // namespace net
@@ -0,0 +1,71 @@
+#ifndef NET_INCLUDE_NET_SOCKET_OPTIONS_HPP_
+#define NET_INCLUDE_NET_SOCKET_OPTIONS_HPP_
+
+#include "net/socket.hpp"
+
+namespace net {
+
+/// TcpServer/TcpClient/Acceptor/Connector使用的socket选项，默认值不会修改任何系统设置
+struct SocketOptions {
+  bool tcp_no_delay = false;        ///< TCP_NODELAY，关闭Nagle算法
+  bool tcp_quick_ack = false;       ///< TCP_QUICKACK
+  int send_buffer_size = 0;         ///< SO_SNDBUF，为0表示使用系统默认值
+  int recv_buffer_size = 0;         ///< SO_RCVBUF，为0表示使用系统默认值
+  bool keep_alive = false;          ///< SO_KEEPALIVE
+  int keep_alive_idle = 0;          ///< TCP_KEEPIDLE(秒)，为0表示使用系统默认值
+  int keep_alive_interval = 0;      ///< TCP_KEEPINTVL(秒)，为0表示使用系统默认值
+  int keep_alive_count = 0;         ///< TCP_KEEPCNT，为0表示使用系统默认值
+  int tcp_fast_open = 0;            ///< 监听socket为TCP_FASTOPEN队列长度，客户端大于0时开启TCP_FASTOPEN_CONNECT
+  int tcp_not_sent_lowat = 0;       ///< TCP_NOTSENT_LOWAT，为0表示使用系统默认值
+  int busy_poll = 0;                ///< SO_BUSY_POLL(微秒)，为0表示不开启
+  int listen_backlog = SOMAXCONN;   ///< listen()的backlog
+};
+
+namespace detail {
+
+inline bool HasTcpLevelOptions(const SocketOptions &options) {
+  return options.tcp_no_delay || options.tcp_quick_ack || options.keep_alive ||
+      options.tcp_not_sent_lowat > 0 || options.tcp_fast_open > 0;
+}
+
+} // namespace net::detail
+
+/// 对已建立(或即将connect)的连接socket应用选项
+/// @note 对Unix域socket只会应用socket层的选项
+inline void ApplySocketOptions(int fd, const SocketOptions &options) {
+  bool is_tcp = !detail::HasTcpLevelOptions(options) || net::GetSocketDomain(fd) != AF_UNIX;
+  if (options.send_buffer_size > 0) net::SetSendBufferSize(fd, options.send_buffer_size);
+  if (options.recv_buffer_size > 0) net::SetRecvBufferSize(fd, options.recv_buffer_size);
+  if (options.busy_poll > 0) net::SetBusyPoll(fd, options.busy_poll);
+  if (!is_tcp) return;
+  if (options.tcp_no_delay) net::SetTcpNoDelay(fd, true);
+  if (options.tcp_quick_ack) net::SetTcpQuickAck(fd, true);
+  if (options.keep_alive) {
+    net::SetKeepAlive(fd, true, options.keep_alive_idle,
+                      options.keep_alive_interval, options.keep_alive_count);
+  }
+  if (options.tcp_not_sent_lowat > 0) net::SetTcpNotSentLowat(fd, options.tcp_not_sent_lowat);
+}
+
+/// 对监听socket应用选项，需要在listen()之前调用
+/// @note SO_RCVBUF需要在listen()之前设置，才能影响窗口扩大因子的协商
+inline void ApplyListenSocketOptions(int fd, const SocketOptions &options) {
+  if (options.send_buffer_size > 0) net::SetSendBufferSize(fd, options.send_buffer_size);
+  if (options.recv_buffer_size > 0) net::SetRecvBufferSize(fd, options.recv_buffer_size);
+  if (options.busy_poll > 0) net::SetBusyPoll(fd, options.busy_poll);
+  if (options.tcp_fast_open > 0 && net::GetSocketDomain(fd) != AF_UNIX) {
+    net::SetTcpFastOpen(fd, options.tcp_fast_open);
+  }
+}
+
+/// 对客户端socket应用选项，需要在connect()之前调用
+inline void ApplyConnectSocketOptions(int fd, const SocketOptions &options) {
+  ApplySocketOptions(fd, options);
+  if (options.tcp_fast_open > 0 && net::GetSocketDomain(fd) != AF_UNIX) {
+    net::SetTcpFastOpenConnect(fd, true);
+  }
+}
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_SOCKET_OPTIONS_HPP_
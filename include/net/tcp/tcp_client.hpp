@@ -11,19 +11,29 @@ class TcpClient {
   using ConnectionCallback = TcpConnection::ConnectionCallback;
   using MessageCallback = TcpConnection::MessageCallback;
   using WriteCompleteCallback = TcpConnection::WriteCompleteCallback;
+  using HighWaterMarkCallback = TcpConnection::HighWaterMarkCallback;
+  using LowWaterMarkCallback = TcpConnection::LowWaterMarkCallback;
 
   TcpClient(Reactor *reactor, const InetAddress &server_addr)
       : reactor_(reactor),
         connector_(reactor, server_addr),
         connection_(nullptr),
         retry_(false),
-        stopped_(false) {
+        cork_(false),
+        stopped_(false),
+        high_water_mark_(TcpConnection::kDefaultHighWaterMark),
+        low_water_mark_(TcpConnection::kDefaultLowWaterMark),
+        max_output_buffer_size_(0) {
     connector_.SetNewConnectionCallback([this](int conn_fd) {
       NewConnectionCallback(conn_fd);
     });
   }
 
   void SetRetry(bool retry) { retry_ = retry; }
+  /// 设置连接socket的选项，将在每次connect()之前生效
+  void SetSocketOptions(const SocketOptions &options) { connector_.SetSocketOptions(options); }
+  /// 参见TcpConnection::SetCork
+  void SetCork(bool on) { cork_ = on; }
 
   void SetConnectionCallback(const ConnectionCallback &cb) {
     connection_callback_ = cb;
@@ -34,6 +44,23 @@ class TcpClient {
   void SetWriteCompleteCallback(const WriteCompleteCallback &cb) {
     write_complete_callback_ = cb;
   }
+  /// 参见TcpConnection::SetHighWaterMarkCallback
+  void SetHighWaterMarkCallback(const HighWaterMarkCallback &cb, size_t high_water_mark) {
+    high_water_mark_callback_ = cb;
+    high_water_mark_ = high_water_mark;
+  }
+  /// 参见TcpConnection::SetLowWaterMarkCallback
+  void SetLowWaterMarkCallback(const LowWaterMarkCallback &cb, size_t low_water_mark) {
+    low_water_mark_callback_ = cb;
+    low_water_mark_ = low_water_mark;
+  }
+  /// 参见TcpConnection::SetMaxOutputBufferSize
+  void SetMaxOutputBufferSize(size_t max_size) { max_output_buffer_size_ = max_size; }
+
+  /// @return 当前的连接，未连接时返回nullptr
+  /// @note 非线程安全
+  [[nodiscard]] const TcpConnectionPtr &GetConnection() const { return connection_; }
+  [[nodiscard]] Reactor *GetReactor() const { return reactor_; }
 
   void Connect() {
     stopped_ = false;
@@ -55,11 +82,15 @@ class TcpClient {
   }
  private:
   void NewConnectionCallback(int conn_fd) {
-    connection_ = std::make_shared<TcpConnection>();
+    connection_ = TcpConnection::New();
     connection_->Init(reactor_, conn_fd);
     connection_->SetConnectionCallback(connection_callback_);
     connection_->SetMessageCallback(message_callback_);
     connection_->SetWriteCompleteCallback(write_complete_callback_);
+    connection_->SetCork(cork_);
+    connection_->SetHighWaterMarkCallback(high_water_mark_callback_, high_water_mark_);
+    connection_->SetLowWaterMarkCallback(low_water_mark_callback_, low_water_mark_);
+    connection_->SetMaxOutputBufferSize(max_output_buffer_size_);
     connection_->SetCloseCallback([this](const TcpConnectionPtr &conn) {
       conn->Destroy();
       connection_.reset();
@@ -73,11 +104,17 @@ class TcpClient {
   Connector connector_;
   TcpConnectionPtr connection_;
   bool retry_;
+  bool cork_;
   bool stopped_;
 
   ConnectionCallback connection_callback_;
   MessageCallback message_callback_;
   WriteCompleteCallback write_complete_callback_;
+  HighWaterMarkCallback high_water_mark_callback_;
+  LowWaterMarkCallback low_water_mark_callback_;
+  size_t high_water_mark_;
+  size_t low_water_mark_;
+  size_t max_output_buffer_size_;
 };
 
 } // namespace net
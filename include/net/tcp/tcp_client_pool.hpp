@@ -0,0 +1,193 @@
+#ifndef NET_INCLUDE_NET_TCP_TCP_CLIENT_POOL_HPP_
+#define NET_INCLUDE_NET_TCP_TCP_CLIENT_POOL_HPP_
+
+#include "net/reactor/reactor_pool.hpp"
+#include "net/tcp/tcp_client.hpp"
+
+namespace net {
+
+/// 对同一个上游维护多个长连接，连接分散在ReactorPool的各个Reactor上
+/// 启动后会预先建立所有连接，连接断开后通过Connector的退避策略自动重连
+/// @note 请在ReactorPool停止之后再销毁TcpClientPool
+class TcpClientPool : noncopyable {
+  struct Slot {
+    /// connection会被其他线程读取，临界区只有一次TcpConnectionPtr的拷贝，因此使用自旋锁
+    TcpConnectionPtr LoadConnection() {
+      while (lock.test_and_set(std::memory_order_acquire)) {}
+      TcpConnectionPtr conn = connection;
+      lock.clear(std::memory_order_release);
+      return conn;
+    }
+    void StoreConnection(TcpConnectionPtr conn) {
+      while (lock.test_and_set(std::memory_order_acquire)) {}
+      connection.Swap(conn);
+      lock.clear(std::memory_order_release);
+      // 旧的连接在锁外释放
+    }
+
+    std::unique_ptr<TcpClient> client;
+    TcpConnectionPtr connection;              ///< 只通过LoadConnection/StoreConnection访问
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    std::atomic<int> outstanding{0};          ///< 该连接上尚未完成的请求数
+  };
+
+ public:
+  using ConnectionCallback = TcpClient::ConnectionCallback;
+  using MessageCallback = TcpClient::MessageCallback;
+  using WriteCompleteCallback = TcpClient::WriteCompleteCallback;
+
+  /// 租用的连接，析构(或调用Release)时归还，归还前该连接的未完成请求数会加一
+  class Lease : noncopyable {
+   public:
+    Lease() : slot_(nullptr) {}
+    Lease(Slot *slot, TcpConnectionPtr connection)
+        : slot_(slot),
+          connection_(std::move(connection)) {}
+    Lease(Lease &&other) noexcept
+        : slot_(other.slot_),
+          connection_(std::move(other.connection_)) {
+      other.slot_ = nullptr;
+    }
+    Lease &operator=(Lease &&other) noexcept {
+      if (this != &other) {
+        Release();
+        slot_ = other.slot_;
+        connection_ = std::move(other.connection_);
+        other.slot_ = nullptr;
+      }
+      return *this;
+    }
+    ~Lease() { Release(); }
+
+    explicit operator bool() const { return slot_ != nullptr; }
+    [[nodiscard]] const TcpConnectionPtr &GetConnection() const { return connection_; }
+    TcpConnection *operator->() const { return connection_.get(); }
+
+    /// 请求完成后归还连接
+    void Release() {
+      if (slot_) {
+        slot_->outstanding.fetch_sub(1, std::memory_order_relaxed);
+        slot_ = nullptr;
+        connection_.reset();
+      }
+    }
+
+   private:
+    Slot *slot_;
+    TcpConnectionPtr connection_;
+  };
+
+  TcpClientPool(ReactorPool *reactor_pool, const InetAddress &server_addr, int connection_num)
+      : reactor_pool_(reactor_pool),
+        server_addr_(server_addr),
+        connection_num_(connection_num),
+        cork_(false),
+        next_(0) {
+    NET_ASSERT(connection_num > 0);
+  }
+
+  void SetConnectionCallback(const ConnectionCallback &cb) {
+    connection_callback_ = cb;
+  }
+  void SetMessageCallback(const MessageCallback &cb) {
+    message_callback_ = cb;
+  }
+  void SetWriteCompleteCallback(const WriteCompleteCallback &cb) {
+    write_complete_callback_ = cb;
+  }
+  void SetSocketOptions(const SocketOptions &options) { socket_options_ = options; }
+  void SetCork(bool on) { cork_ = on; }
+
+  /// 创建所有TcpClient并开始连接，TcpClient通过RoundRobin分配到ReactorPool的各个Reactor上
+  /// @note 请在ReactorPool启动之后调用，非线程安全
+  void Start() {
+    slot_vec_.reserve(connection_num_);
+    for (int i = 0; i < connection_num_; ++i) {
+      auto slot = std::make_unique<Slot>();
+      slot->client = std::make_unique<TcpClient>(reactor_pool_->GetNextReactor(), server_addr_);
+      TcpClient *client = slot->client.get();
+      client->SetRetry(true);
+      client->SetCork(cork_);
+      client->SetSocketOptions(socket_options_);
+      client->SetMessageCallback(message_callback_);
+      client->SetWriteCompleteCallback(write_complete_callback_);
+      client->SetConnectionCallback([this, slot = slot.get()](const TcpConnectionPtr &conn) {
+        if (conn->Connected()) {
+          slot->StoreConnection(conn);
+          connected_num_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          slot->StoreConnection(nullptr);
+          connected_num_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (connection_callback_) {
+          connection_callback_(conn);
+        }
+      });
+      slot_vec_.push_back(std::move(slot));
+      client->Connect();
+    }
+  }
+
+  /// 停止所有连接，并且不再重连
+  /// @note 线程安全
+  void Stop() {
+    for (auto &slot: slot_vec_) {
+      TcpClient *client = slot->client.get();
+      client->GetReactor()->SubmitTask([client] {
+        client->Stop();
+        client->Disconnect();
+      });
+    }
+  }
+
+  /// 租用一个已连接的连接，选择未完成请求数最少的连接
+  /// @return 没有可用连接时，返回的Lease转换为bool的结果为false
+  /// @note 线程安全
+  Lease Acquire() {
+    size_t slot_num = slot_vec_.size();
+    if (slot_num == 0) return {};
+    // 从轮转的位置开始查找，使未完成请求数相同的连接能够被均匀使用
+    size_t start = next_.fetch_add(1, std::memory_order_relaxed) % slot_num;
+    Slot *best = nullptr;
+    TcpConnectionPtr best_connection;
+    int best_outstanding = 0;
+    for (size_t i = 0; i < slot_num; ++i) {
+      Slot *slot = slot_vec_[(start + i) % slot_num].get();
+      int outstanding = slot->outstanding.load(std::memory_order_relaxed);
+      if (best && outstanding >= best_outstanding) continue;
+      auto connection = slot->LoadConnection();
+      if (!connection) continue;
+      best = slot;
+      best_connection = std::move(connection);
+      best_outstanding = outstanding;
+      if (outstanding == 0) break;
+    }
+    if (!best) return {};
+    best->outstanding.fetch_add(1, std::memory_order_relaxed);
+    return {best, std::move(best_connection)};
+  }
+
+  /// @return 当前已建立的连接数
+  [[nodiscard]] int GetConnectedNum() const {
+    return connected_num_.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] int GetConnectionNum() const { return connection_num_; }
+
+ private:
+  ReactorPool *reactor_pool_;
+  InetAddress server_addr_;
+  int connection_num_;
+  SocketOptions socket_options_;
+  bool cork_;
+  std::vector<std::unique_ptr<Slot>> slot_vec_;
+  std::atomic<size_t> next_;
+  std::atomic<int> connected_num_{0};
+
+  ConnectionCallback connection_callback_;
+  MessageCallback message_callback_;
+  WriteCompleteCallback write_complete_callback_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_TCP_TCP_CLIENT_POOL_HPP_
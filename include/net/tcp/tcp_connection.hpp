@@ -2,16 +2,33 @@
 #define NET_INCLUDE_NET_TCP_TCP_CONNECTION_HPP_
 
 #include "net/reactor/reactor.hpp"
+#include "net/util/biased_ptr.hpp"
+#include "net/util/object_pool.hpp"
+
+#include <deque>
 
 namespace net {
 
-class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnection> {
+/// TcpConnection通过侵入式的偏向引用计数管理生命周期，参见BiasedRefCounted
+///
+/// 连接建立后，TcpConnection自身在所属的Reactor线程上持有一个引用(self_)，直到Destroy时释放，
+/// 因此在Reactor线程上传递、拷贝TcpConnectionPtr(例如每条消息的回调)都只修改非原子的计数，
+/// 只有在其他线程中持有TcpConnectionPtr时才会使用原子操作
+class TcpConnection : public BiasedRefCounted<TcpConnection> {
+  friend class BiasedRefCounted<TcpConnection>;
  public:
-  using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+  using TcpConnectionPtr = BiasedPtr<TcpConnection>;
   using ConnectionCallback = std::function<void(const TcpConnectionPtr &)>;
   using MessageCallback = std::function<void(const TcpConnectionPtr &, const BufferPtr &)>;
   using WriteCompleteCallback = std::function<void(const TcpConnectionPtr &)>;
   using CloseCallback = std::function<void(const TcpConnectionPtr &)>;
+  /// 第二个参数为当前输出缓冲区中待发送的字节数
+  using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr &, size_t)>;
+  using LowWaterMarkCallback = std::function<void(const TcpConnectionPtr &, size_t)>;
+
+  static constexpr size_t kDefaultHighWaterMark = 64 * 1024 * 1024;
+  static constexpr size_t kDefaultLowWaterMark = 0;
+  static constexpr size_t kMaxSendPieces = 8;   ///< 超过该段数的Send不会使用writev直接写入
 
   /// 为了能够使用ObjectPool，将初始化逻辑放到了Init函数中
   TcpConnection()
@@ -21,7 +38,25 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
         peer_addr_(0),
         input_buffer_(std::make_shared<Buffer>()),
         output_buffer_(std::make_shared<Buffer>()),
-        state_(State::Connecting) {}
+        bytes_after_last_file_(0),
+        cork_(false),
+        high_water_mark_(kDefaultHighWaterMark),
+        low_water_mark_(kDefaultLowWaterMark),
+        max_output_buffer_size_(0),
+        above_high_water_mark_(false),
+        state_(State::Connecting),
+        pool_(nullptr) {}
+
+  /// 创建一个TcpConnection，引用计数归零时delete
+  static TcpConnectionPtr New() {
+    return TcpConnectionPtr(new TcpConnection);
+  }
+  /// 从对象池中获取一个TcpConnection，引用计数归零时放回对象池
+  static TcpConnectionPtr New(ObjectPool<TcpConnection> *pool) {
+    TcpConnection *connection = pool->Get();
+    connection->pool_ = pool;
+    return TcpConnectionPtr(connection);
+  }
 
   /// 每次获取一个TcpConnection对象后，使用Init函数进行初始化
   void Init(Reactor *reactor, int conn_fd) {
@@ -31,6 +66,7 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
   }
 
   /// 每次获取一个TcpConnection对象后，使用Init函数进行初始化
+  /// @note conn_fd交由TcpConnection管理，在引用计数归零时关闭
   void Init(Reactor *reactor, int conn_fd, const InetAddress &local_addr, const InetAddress &peer_addr) {
     reactor_ = reactor;
     channel_ = Channel(conn_fd);
@@ -38,12 +74,20 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
     peer_addr_ = peer_addr;
     input_buffer_->Reset();
     output_buffer_->Reset();
+    output_files_.clear();
+    bytes_after_last_file_ = 0;
+    cork_ = false;
+    high_water_mark_ = kDefaultHighWaterMark;
+    low_water_mark_ = kDefaultLowWaterMark;
+    max_output_buffer_size_ = 0;
+    above_high_water_mark_ = false;
     state_.store(State::Connecting, std::memory_order_relaxed);
 
     channel_.SetReadCallback([this] { HandleRead(); });
     channel_.SetWriteCallback([this] { HandleWrite(); });
     channel_.SetCloseCallback([this] { HandleClose(); });
     channel_.SetErrorCallback([this] { HandleError(); });
+    channel_.SetFlushCallback([this] { HandleFlush(); });
   }
 
   void SetConnectionCallback(ConnectionCallback &&cb) {
@@ -67,6 +111,24 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
   void SetCloseCallback(CloseCallback &&cb) {
     close_callback_ = std::move(cb);
   }
+  /// 输出缓冲区中待发送的数据量由低于high_water_mark增长到不低于high_water_mark时调用
+  void SetHighWaterMarkCallback(const HighWaterMarkCallback &cb, size_t high_water_mark) {
+    high_water_mark_callback_ = cb;
+    high_water_mark_ = high_water_mark;
+  }
+  /// 超过高水位线之后，输出缓冲区中待发送的数据量回落到不高于low_water_mark时调用
+  void SetLowWaterMarkCallback(const LowWaterMarkCallback &cb, size_t low_water_mark) {
+    low_water_mark_callback_ = cb;
+    low_water_mark_ = low_water_mark;
+  }
+  /// 输出缓冲区的硬上限，超过该上限时将直接断开连接(丢弃未发送的数据)，为0表示不限制
+  void SetMaxOutputBufferSize(size_t max_size) { max_output_buffer_size_ = max_size; }
+
+  /// 开启后，Send不会立即写socket，而是先追加到输出缓冲区，
+  /// 在Reactor本轮事件(或任务)处理结束后统一写一次，从而将回调中的多次Send合并成一次系统调用
+  /// @note 请在Establish之前设置，或者在该连接所属的Reactor线程中设置
+  void SetCork(bool on) { cork_ = on; }
+  [[nodiscard]] bool IsCorked() const { return cork_; }
 
   // 可用于在ConnectionCallback中判断是Establish时调用的，还是Destroy时调用的
   bool Connected() {
@@ -80,18 +142,21 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
     state_.store(State::Connected, std::memory_order_relaxed);
     channel_.EnableRead();
     reactor_->UpdateChannel(&channel_);
+    self_ = TcpConnectionPtr(this);
     if (connection_callback_) {
-      connection_callback_(shared_from_this());
+      connection_callback_(self_);
     }
   }
   /// 销毁连接，将channel从Reactor中移除，并且调用ConnectionCallback
+  /// @note 调用者需要持有该连接的TcpConnectionPtr，Destroy会释放连接对自身的引用
   void Destroy() {
     state_.store(State::Disconnected, std::memory_order_release);
     channel_.DisableAll();
     if (connection_callback_) {
-      connection_callback_(shared_from_this());
+      connection_callback_(self_);
     }
     reactor_->RemoveChannel(&channel_);
+    self_.reset();
   }
 
   /// 向对端发送数据
@@ -114,6 +179,38 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
     }
   }
 
+  /// 将多段数据(例如协议头和消息体)连续地发送，直接写socket时使用writev，不需要先拼接成一个字符串
+  /// @note 线程安全
+  void Send(std::initializer_list<std::string_view> pieces) {
+    if (state_.load(std::memory_order_acquire) != State::Connected) return;
+    if (reactor_->InCurrentReactorThread()) {
+      RealSend(pieces.begin(), pieces.size());
+    } else {
+      std::string str;
+      for (auto piece: pieces) {
+        str.append(piece);
+      }
+      reactor_->SubmitTask([this, str = std::move(str)] {
+        RealSend(str.data(), str.size());
+      });
+    }
+  }
+
+  /// 将文件fd中从offset开始的length字节通过sendfile发送，与Send的数据保持先后顺序，文件内容不经过用户态
+  /// @param holder 在文件发送完之前持有，用于保证fd不被关闭
+  /// @note 线程安全
+  /// @note 文件数据不计入输出缓冲区，不影响高低水位线；发送时文件被截断的话将断开连接
+  void SendFile(int fd, off_t offset, size_t length, std::shared_ptr<const void> holder) {
+    if (state_.load(std::memory_order_acquire) != State::Connected) return;
+    if (reactor_->InCurrentReactorThread()) {
+      RealSendFile(fd, offset, length, std::move(holder));
+    } else {
+      reactor_->SubmitTask([this, fd, offset, length, holder = std::move(holder)]() mutable {
+        RealSendFile(fd, offset, length, std::move(holder));
+      });
+    }
+  }
+
   /// 主动关闭连接
   /// @note 线程安全
   void Shutdown() {
@@ -126,14 +223,59 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
     }
   }
 
+  /// 强制关闭连接，输出缓冲区中尚未发送的数据将被丢弃
+  /// @note 线程安全
+  void ForceClose() {
+    State state = state_.load(std::memory_order_acquire);
+    if (state != State::Connected && state != State::Disconnecting) return;
+    if (reactor_->InCurrentReactorThread()) {
+      RealForceClose();
+    } else {
+      reactor_->SubmitTask([self = TcpConnectionPtr(this)] { self->RealForceClose(); });
+    }
+  }
+
+  /// 停止从连接中读取数据(不再关注可读事件)，对端的发送将因TCP流量控制而被阻塞
+  /// @note 线程安全
+  void PauseReading() {
+    if (reactor_->InCurrentReactorThread()) {
+      RealPauseReading();
+    } else {
+      reactor_->SubmitTask([self = TcpConnectionPtr(this)] { self->RealPauseReading(); });
+    }
+  }
+  /// 恢复从连接中读取数据
+  /// @note 线程安全
+  void ResumeReading() {
+    if (reactor_->InCurrentReactorThread()) {
+      RealResumeReading();
+    } else {
+      reactor_->SubmitTask([self = TcpConnectionPtr(this)] { self->RealResumeReading(); });
+    }
+  }
+  [[nodiscard]] bool IsReading() const { return channel_.ReadEnabled(); }
+
+  /// @return 输出缓冲区中尚未发送的字节数，不包括SendFile尚未发送的文件数据
+  /// @note 非线程安全
+  [[nodiscard]] size_t GetPendingOutputBytes() const { return output_buffer_->ReadableBytes(); }
+
+  /// 设置与连接关联的上下文(例如协议的解析状态)，在连接的引用计数归零时释放
+  /// @note 非线程安全
+  void SetContext(std::shared_ptr<void> context) { context_ = std::move(context); }
+  [[nodiscard]] const std::shared_ptr<void> &GetContext() const { return context_; }
+
   Reactor *GetReactor() const { return reactor_; }
+  [[nodiscard]] const InetAddress &GetLocalAddress() const { return local_addr_; }
+  [[nodiscard]] const InetAddress &GetPeerAddress() const { return peer_addr_; }
 
  private:
   void HandleRead() {
     ssize_t n = net::Read(channel_.GetFd(), input_buffer_);
     if (n > 0) {
       if (message_callback_) {
-        message_callback_(shared_from_this(), input_buffer_);
+        // 回调中可能关闭连接，需要持有一个引用，这里只会修改非原子的计数
+        TcpConnectionPtr guard(self_);
+        message_callback_(guard, input_buffer_);
       }
     } else if (n == 0) {
       HandleClose();
@@ -143,63 +285,247 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
   }
   void HandleWrite() {
     if (!channel_.WriteEnabled()) return;
-    size_t n = net::Write(channel_.GetFd(), output_buffer_);
-    if (n > 0) {
-      output_buffer_->HasWritten(n);
-      if (output_buffer_->ReadableBytes() == 0) {
-        channel_.DisableWrite();
-        reactor_->UpdateChannel(&channel_);
-        if (write_complete_callback_) {
-          reactor_->SubmitTask([this, self = shared_from_this()] {
-            write_complete_callback_(self);
-          });
-        }
-        if (state_.load(std::memory_order_relaxed) == State::Disconnecting) {
-          RealShutdown();
-        }
-      }
-    }
+    WriteOutputBuffer();
   }
   void HandleClose() {
+    if (state_.load(std::memory_order_relaxed) == State::Disconnected) return;  // 已经关闭过了
+    state_.store(State::Disconnected, std::memory_order_release);
     channel_.DisableAll();
     reactor_->RemoveChannel(&channel_);
-    close_callback_(shared_from_this());
+    close_callback_(TcpConnectionPtr(this));
+  }
+  void RealForceClose() {
+    if (state_.load(std::memory_order_relaxed) == State::Disconnected) return;
+    // 关闭读写两个方向，使对端立即感知到连接断开，fd本身在引用计数归零时关闭
+    ::shutdown(channel_.GetFd(), SHUT_RDWR);
+    HandleClose();
   }
   void HandleError() {
     // 什么都不做
   }
+  /// 由Reactor在本轮处理结束后调用，将合并后的输出缓冲区一次性写出
+  void HandleFlush() {
+    if (channel_.WriteEnabled()) return;  // 等待可写事件时会继续写
+    WriteOutputBuffer();
+  }
+
+  [[nodiscard]] bool HasPendingOutput() const {
+    return output_buffer_->ReadableBytes() > 0 || !output_files_.empty();
+  }
+
+  /// 按顺序尽可能多地写出输出缓冲区中的数据以及排队的文件，没写完的话则关注可写事件
+  void WriteOutputBuffer() {
+    if (!HasPendingOutput()) return;
+    while (true) {
+      // 先写出排在第一个文件之前的数据
+      size_t bytes = output_files_.empty() ? output_buffer_->ReadableBytes() : output_files_.front().bytes_before;
+      if (bytes > 0) {
+        ssize_t n = net::Write(channel_.GetFd(), output_buffer_->GetReadPtr(), bytes);
+        if (n < 0) break;
+        output_buffer_->HasRead(n);
+        if (!output_files_.empty()) output_files_.front().bytes_before -= n;
+        if (static_cast<size_t>(n) < bytes) break;
+      }
+      if (output_files_.empty()) break;
+      OutputFile &file = output_files_.front();
+      ssize_t n = net::SendFile(channel_.GetFd(), file.fd, &file.offset, file.remaining);
+      if (n < 0) break;
+      if (n == 0) {
+        LOG_ERROR("file is truncated while sending, force close");
+        RealForceClose();
+        return;
+      }
+      file.remaining -= n;
+      if (file.remaining > 0) break;
+      output_files_.pop_front();
+      if (output_files_.empty()) bytes_after_last_file_ = 0;
+    }
+    CheckLowWaterMark();
+    if (!HasPendingOutput()) {
+      output_buffer_->Reset();
+      if (channel_.WriteEnabled()) {
+        channel_.DisableWrite();
+        reactor_->UpdateChannel(&channel_);
+      }
+      if (write_complete_callback_) {
+        reactor_->SubmitTask([this, self = TcpConnectionPtr(this)] {
+          write_complete_callback_(self);
+        });
+      }
+      if (state_.load(std::memory_order_relaxed) == State::Disconnecting) {
+        RealShutdown();
+      }
+    } else if (!channel_.WriteEnabled()) {
+      channel_.EnableWrite();
+      reactor_->UpdateChannel(&channel_);
+    }
+  }
 
   void RealSend(const char *data, size_t len) {
-    // 如果输出缓冲区中没有数据，则直接写入
-    ssize_t nwrote = 0;
-    if (!channel_.WriteEnabled() && output_buffer_->ReadableBytes() == 0) {
-      nwrote = net::Write(channel_.GetFd(), data, len);
-      if (nwrote >= 0) {
-        if (nwrote == len && write_complete_callback_) {
-          reactor_->SubmitTask([this, self = shared_from_this()] {
+    std::string_view piece(data, len);
+    RealSend(&piece, 1);
+  }
+  void RealSend(const std::string_view *pieces, size_t count) {
+    if (state_.load(std::memory_order_relaxed) == State::Disconnected) return;
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      total += pieces[i].size();
+    }
+    // 如果没有开启合并，并且没有待发送的数据，则直接写入
+    size_t nwrote = 0;
+    if (!cork_ && !channel_.WriteEnabled() && !HasPendingOutput() && count <= kMaxSendPieces) {
+      struct iovec vec[kMaxSendPieces];
+      for (size_t i = 0; i < count; ++i) {
+        vec[i].iov_base = const_cast<char *>(pieces[i].data());
+        vec[i].iov_len = pieces[i].size();
+      }
+      ssize_t n = net::Writev(channel_.GetFd(), vec, static_cast<int>(count));
+      if (n >= 0) {
+        nwrote = n;
+        if (nwrote == total && write_complete_callback_) {
+          reactor_->SubmitTask([this, self = TcpConnectionPtr(this)] {
             write_complete_callback_(self);
           });
         }
-      } else {
-        nwrote = 0;
       }
     }
-    // 如果没有进行直接写入，或者直接写入没有写完，则添加到缓冲区中
-    if (nwrote < len) {
-      output_buffer_->Append(data + nwrote, len - nwrote);
-      if (!channel_.WriteEnabled()) {
+    if (nwrote == total) return;
+    // 开启了合并，或者没有进行直接写入，或者直接写入没有写完，则将剩余的数据添加到缓冲区中
+    if (!output_files_.empty()) {
+      bytes_after_last_file_ += total - nwrote;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      if (nwrote >= pieces[i].size()) {
+        nwrote -= pieces[i].size();
+        continue;
+      }
+      output_buffer_->Append(pieces[i].data() + nwrote, pieces[i].size() - nwrote);
+      nwrote = 0;
+    }
+    WaitForFlush();
+    CheckHighWaterMark();
+  }
+
+  void RealSendFile(int fd, off_t offset, size_t length, std::shared_ptr<const void> holder) {
+    if (state_.load(std::memory_order_relaxed) == State::Disconnected || length == 0) return;
+    if (!cork_ && !channel_.WriteEnabled() && !HasPendingOutput()) {
+      ssize_t n = net::SendFile(channel_.GetFd(), fd, &offset, length);
+      if (n == 0) {
+        LOG_ERROR("file is truncated while sending, force close");
+        RealForceClose();
+        return;
+      }
+      if (n > 0) {
+        length -= n;
+        if (length == 0) {
+          if (write_complete_callback_) {
+            reactor_->SubmitTask([this, self = TcpConnectionPtr(this)] {
+              write_complete_callback_(self);
+            });
+          }
+          return;
+        }
+      }
+    }
+    size_t bytes_before = output_files_.empty() ? output_buffer_->ReadableBytes() : bytes_after_last_file_;
+    output_files_.push_back({fd, offset, length, bytes_before, std::move(holder)});
+    bytes_after_last_file_ = 0;
+    WaitForFlush();
+  }
+
+  /// 有数据等待发送时，开启合并的话等待本轮结束时统一刷新，否则关注可写事件
+  void WaitForFlush() {
+    if (!channel_.WriteEnabled()) {
+      if (cork_) {
+        // 等待Reactor在本轮结束时统一刷新
+        reactor_->QueueFlush(&channel_);
+      } else {
         channel_.EnableWrite();
         reactor_->UpdateChannel(&channel_);
       }
     }
   }
 
+  /// 输出缓冲区增长之后调用，超过硬上限时断开连接，首次越过高水位线时调用HighWaterMarkCallback
+  void CheckHighWaterMark() {
+    size_t pending = output_buffer_->ReadableBytes();
+    if (max_output_buffer_size_ > 0 && pending > max_output_buffer_size_) {
+      LOG_ERROR("output buffer size {} exceeds limit {}, force close", pending, max_output_buffer_size_);
+      output_buffer_->Reset();
+      output_files_.clear();
+      RealForceClose();
+      return;
+    }
+    if (!above_high_water_mark_ && pending >= high_water_mark_) {
+      above_high_water_mark_ = true;
+      if (high_water_mark_callback_) {
+        reactor_->SubmitTask([this, self = TcpConnectionPtr(this), pending] {
+          high_water_mark_callback_(self, pending);
+        });
+      }
+    }
+  }
+  /// 输出缓冲区减少之后调用，越过高水位线后回落到低水位线时调用LowWaterMarkCallback
+  void CheckLowWaterMark() {
+    size_t pending = output_buffer_->ReadableBytes();
+    if (above_high_water_mark_ && pending <= low_water_mark_) {
+      above_high_water_mark_ = false;
+      if (low_water_mark_callback_) {
+        reactor_->SubmitTask([this, self = TcpConnectionPtr(this), pending] {
+          low_water_mark_callback_(self, pending);
+        });
+      }
+    }
+  }
+
+  void RealPauseReading() {
+    if (state_.load(std::memory_order_relaxed) == State::Disconnected) return;
+    if (channel_.ReadEnabled()) {
+      channel_.DisableRead();
+      reactor_->UpdateChannel(&channel_);
+    }
+  }
+  void RealResumeReading() {
+    if (state_.load(std::memory_order_relaxed) == State::Disconnected) return;
+    if (!channel_.ReadEnabled()) {
+      channel_.EnableRead();
+      reactor_->UpdateChannel(&channel_);
+    }
+  }
+
   void RealShutdown() {
-    if (!channel_.WriteEnabled()) {
+    // 还有数据没有发送的话，等数据写完后再关闭
+    if (!channel_.WriteEnabled() && !HasPendingOutput()) {
       net::ShutDown(channel_.GetFd(), SHUT_WR);
     }
   }
 
+  // BiasedRefCounted所需的接口
+  [[nodiscard]] bool IsOwnerThread() const {
+    return reactor_ != nullptr && Reactor::GetCurrent() == reactor_;
+  }
+  void RunInOwnerThread(Reactor::Task &&task) {
+    reactor_->SubmitTask(std::move(task));
+  }
+  void OnRefCountZero() {
+    // 此时channel已经从Reactor中移除，并且不会再有其他线程使用该连接，可以安全地关闭fd
+    if (channel_.GetFd() >= 0) {
+      net::Close(channel_.GetFd());
+      channel_ = Channel(-1);
+    }
+    context_.reset();
+    output_files_.clear();
+    // 放回对象池之前清空reactor_，使下一次获取时创建的引用不会被误认为在拥有者线程上
+    reactor_ = nullptr;
+    ObjectPool<TcpConnection> *pool = pool_;
+    pool_ = nullptr;
+    if (pool) {
+      pool->Add(this);
+    } else {
+      delete this;
+    }
+  }
+
   enum class State {
     Connecting,
     Connected,
@@ -213,13 +539,34 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
   InetAddress peer_addr_;
   BufferPtr input_buffer_;
   BufferPtr output_buffer_;
+  /// 通过SendFile排队等待发送的一段文件
+  struct OutputFile {
+    int fd;
+    off_t offset;
+    size_t remaining;
+    size_t bytes_before;   ///< 输出缓冲区中需要在该文件之前发送的字节数(从上一个文件之后算起)
+    std::shared_ptr<const void> holder;
+  };
+  std::deque<OutputFile> output_files_;
+  size_t bytes_after_last_file_;  // 输出缓冲区中排在最后一个文件之后的字节数
+  bool cork_;                     // 是否合并同一轮中的多次Send
+  size_t high_water_mark_;
+  size_t low_water_mark_;
+  size_t max_output_buffer_size_;  // 输出缓冲区的硬上限，为0表示不限制
+  bool above_high_water_mark_;    // 输出缓冲区是否处于高水位线之上
 
   ConnectionCallback connection_callback_;
   MessageCallback message_callback_;
   WriteCompleteCallback write_complete_callback_;
   CloseCallback close_callback_;
+  HighWaterMarkCallback high_water_mark_callback_;
+  LowWaterMarkCallback low_water_mark_callback_;
+
+  std::shared_ptr<void> context_;
 
   std::atomic<State> state_;
+  TcpConnectionPtr self_;             // 连接建立后对自身的引用，Destroy时释放
+  ObjectPool<TcpConnection> *pool_;   // 所属的对象池，为nullptr时引用计数归零后直接delete
 };
 
 using TcpConnectionPtr = TcpConnection::TcpConnectionPtr;
@@ -15,10 +15,16 @@ class TcpServer : noncopyable {
   using ConnectionCallback = TcpConnection::ConnectionCallback;
   using MessageCallback = TcpConnection::MessageCallback;
   using WriteCompleteCallback = TcpConnection::WriteCompleteCallback;
+  using HighWaterMarkCallback = TcpConnection::HighWaterMarkCallback;
+  using LowWaterMarkCallback = TcpConnection::LowWaterMarkCallback;
 
   TcpServer(Reactor *reactor, const InetAddress &listen_addr)
       : main_reactor_(reactor),
-        acceptor_(reactor, listen_addr) {
+        acceptor_(reactor, listen_addr),
+        cork_(false),
+        high_water_mark_(TcpConnection::kDefaultHighWaterMark),
+        low_water_mark_(TcpConnection::kDefaultLowWaterMark),
+        max_output_buffer_size_(0) {
     acceptor_.SetNewConnectionCallback([this](int conn_fd, const InetAddress &peer_addr) {
       NewConnectionCallback(conn_fd, peer_addr);
     });
@@ -38,6 +44,28 @@ class TcpServer : noncopyable {
   void SetWriteCompleteCallback(const WriteCompleteCallback &cb) {
     write_complete_callback_ = cb;
   }
+  /// 参见TcpConnection::SetHighWaterMarkCallback
+  void SetHighWaterMarkCallback(const HighWaterMarkCallback &cb, size_t high_water_mark) {
+    high_water_mark_callback_ = cb;
+    high_water_mark_ = high_water_mark;
+  }
+  /// 参见TcpConnection::SetLowWaterMarkCallback
+  void SetLowWaterMarkCallback(const LowWaterMarkCallback &cb, size_t low_water_mark) {
+    low_water_mark_callback_ = cb;
+    low_water_mark_ = low_water_mark;
+  }
+  /// 参见TcpConnection::SetMaxOutputBufferSize
+  void SetMaxOutputBufferSize(size_t max_size) { max_output_buffer_size_ = max_size; }
+
+  /// 设置监听socket以及之后accept的连接socket的选项
+  /// @note 请在Start之前调用
+  void SetSocketOptions(const SocketOptions &options) {
+    socket_options_ = options;
+    acceptor_.SetSocketOptions(options);
+  }
+
+  /// 对之后建立的所有连接开启/关闭Send合并，参见TcpConnection::SetCork
+  void SetCork(bool on) { cork_ = on; }
 
   void Start() {
     acceptor_.Listen();
@@ -46,14 +74,19 @@ class TcpServer : noncopyable {
 
  private:
   void NewConnectionCallback(int conn_fd, const InetAddress &peer_addr) {
+    net::ApplySocketOptions(conn_fd, socket_options_);
     InetAddress local_addr(GetLocalAddr(conn_fd));
-    TcpConnectionPtr connection = connection_pool_.GetShared();
+    TcpConnectionPtr connection = TcpConnection::New(&connection_pool_);
     active_connection_set_.insert(connection);
     Reactor *sub_reactor = sub_reactor_pool_.GetNextReactor();
     connection->Init(sub_reactor, conn_fd, local_addr, peer_addr);
     connection->SetConnectionCallback(connection_callback_);
     connection->SetMessageCallback(message_callback_);
     connection->SetWriteCompleteCallback(write_complete_callback_);
+    connection->SetCork(cork_);
+    connection->SetHighWaterMarkCallback(high_water_mark_callback_, high_water_mark_);
+    connection->SetLowWaterMarkCallback(low_water_mark_callback_, low_water_mark_);
+    connection->SetMaxOutputBufferSize(max_output_buffer_size_);
     connection->SetCloseCallback([this, sub_reactor](const TcpConnectionPtr &conn) {
       main_reactor_->SubmitTask([this, conn, sub_reactor] {
         sub_reactor->SubmitTask([conn] { conn->Destroy(); });
@@ -68,10 +101,17 @@ class TcpServer : noncopyable {
   ReactorPool sub_reactor_pool_;
   ObjectPool<TcpConnection> connection_pool_;
   std::unordered_set<TcpConnectionPtr> active_connection_set_;
+  SocketOptions socket_options_;
+  bool cork_;
 
   ConnectionCallback connection_callback_;
   MessageCallback message_callback_;
   WriteCompleteCallback write_complete_callback_;
+  HighWaterMarkCallback high_water_mark_callback_;
+  LowWaterMarkCallback low_water_mark_callback_;
+  size_t high_water_mark_;
+  size_t low_water_mark_;
+  size_t max_output_buffer_size_;
 };
 
 } // namespace net
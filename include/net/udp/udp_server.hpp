@@ -0,0 +1,106 @@
+#ifndef NET_INCLUDE_NET_UDP_UDP_SERVER_HPP_
+#define NET_INCLUDE_NET_UDP_UDP_SERVER_HPP_
+
+#include "net/reactor/reactor_pool.hpp"
+#include "net/udp/udp_socket.hpp"
+
+namespace net {
+
+/// UDP服务器
+///
+/// 线程数为0时只在主Reactor上创建一个UdpSocket；否则在ReactorPool的每个Reactor上各创建一个
+/// 开启SO_REUSEPORT并绑定同一地址的UdpSocket，由内核按照四元组哈希将数据报分发到各个socket上，
+/// 同一个对端的数据报总是由同一个Reactor处理，回调中可以直接使用收到数据报的UdpSocket回复
+class UdpServer : noncopyable {
+ public:
+  using MessageCallback = UdpSocket::MessageCallback;
+
+  UdpServer(Reactor *main_reactor, const InetAddress &listen_addr)
+      : main_reactor_(main_reactor),
+        listen_addr_(listen_addr),
+        thread_num_(0),
+        started_(false),
+        stopped_(false) {
+  }
+  ~UdpServer() {
+    if (started_ && !stopped_) {
+      Stop();
+    }
+  }
+
+  /// 设置处理数据报的线程数，为0表示在主Reactor中处理
+  /// @note 请在Start之前调用
+  void SetThreadNum(int thread_num) {
+    NET_ASSERT(thread_num >= 0);
+    thread_num_ = thread_num;
+  }
+  /// @note 请在Start之前调用，线程数大于0时会自动开启reuse_port
+  void SetOptions(const UdpOptions &options) { options_ = options; }
+  void SetMessageCallback(const MessageCallback &cb) { message_callback_ = cb; }
+
+  /// 创建所有UdpSocket并开始接收数据报
+  /// @note 请在主Reactor线程中调用
+  void Start() {
+    if (started_) return;
+    started_ = true;
+    if (thread_num_ == 0) {
+      auto socket = std::make_unique<UdpSocket>(main_reactor_, listen_addr_, options_);
+      socket->SetMessageCallback(message_callback_);
+      socket->Start();
+      socket_vec_.push_back(std::move(socket));
+      return;
+    }
+    UdpOptions options = options_;
+    options.reuse_port = true;
+    sub_reactor_pool_.SetThreadNum(thread_num_);
+    sub_reactor_pool_.Start();
+    InetAddress bind_addr = listen_addr_;
+    for (int i = 0; i < thread_num_; ++i) {
+      auto socket = std::make_unique<UdpSocket>(sub_reactor_pool_.GetNextReactor(), bind_addr, options);
+      // 监听0端口时，其余的socket需要绑定第一个socket实际分配到的端口
+      bind_addr = socket->GetLocalAddress();
+      socket->SetMessageCallback(message_callback_);
+      UdpSocket *s = socket.get();
+      s->GetReactor()->SubmitTask([s] { s->Start(); });
+      socket_vec_.push_back(std::move(socket));
+    }
+  }
+
+  /// 停止接收数据报，并停止所有处理线程
+  /// @note 请在主Reactor线程中调用
+  void Stop() {
+    if (!started_ || stopped_) return;
+    stopped_ = true;
+    if (thread_num_ == 0) {
+      socket_vec_.front()->Stop();
+      return;
+    }
+    for (auto &socket: socket_vec_) {
+      UdpSocket *s = socket.get();
+      s->GetReactor()->SubmitTask([s] { s->Stop(); });
+    }
+    sub_reactor_pool_.Stop();
+  }
+
+  /// @return 实际绑定的地址(监听0端口时可以获取分配到的端口)
+  [[nodiscard]] InetAddress GetLocalAddress() const {
+    return socket_vec_.empty() ? listen_addr_ : socket_vec_.front()->GetLocalAddress();
+  }
+  [[nodiscard]] size_t GetSocketNum() const { return socket_vec_.size(); }
+  [[nodiscard]] UdpSocket *GetSocket(size_t index) const { return socket_vec_[index].get(); }
+
+ private:
+  Reactor *main_reactor_;
+  InetAddress listen_addr_;
+  UdpOptions options_;
+  int thread_num_;
+  bool started_;
+  bool stopped_;
+  ReactorPool sub_reactor_pool_;
+  std::vector<std::unique_ptr<UdpSocket>> socket_vec_;
+  MessageCallback message_callback_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_UDP_UDP_SERVER_HPP_
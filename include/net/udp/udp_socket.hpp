@@ -0,0 +1,350 @@
+#ifndef NET_INCLUDE_NET_UDP_UDP_SOCKET_HPP_
+#define NET_INCLUDE_NET_UDP_UDP_SOCKET_HPP_
+
+#include "net/reactor/reactor.hpp"
+
+namespace net {
+
+/// UdpSocket的选项
+struct UdpOptions {
+  size_t batch_size = 32;               ///< 每次recvmmsg/sendmmsg最多处理的数据报数量
+  size_t max_datagram_size = 2048;      ///< 接收的单个数据报的最大长度，超出部分将被截断，开启GRO时固定为64KB
+  size_t max_send_queue_size = 65536;   ///< 发送队列中最多缓存的数据报数量，超出时丢弃新的数据报
+  bool reuse_port = false;              ///< SO_REUSEPORT，用于在多个Reactor之间分片
+  bool gro = false;                     ///< 接收时开启UDP GRO，内核不支持时自动关闭
+  bool gso = false;                     ///< 发送时将发往同一地址的等长数据报合并成一次UDP GSO发送
+  int recv_buffer_size = 0;             ///< SO_RCVBUF，为0表示使用系统默认值
+  int send_buffer_size = 0;             ///< SO_SNDBUF，为0表示使用系统默认值
+};
+
+/// 集成到Reactor中的UDP socket
+///
+/// 每次可读时通过一次recvmmsg读取最多batch_size个数据报到预先分配的接收缓冲区中；
+/// SendTo先将数据报加入发送队列，在Reactor本轮处理结束后通过sendmmsg批量发出，
+/// 开启GSO时，发往同一地址的连续等长数据报会合并成一个消息由内核(或网卡)分段
+class UdpSocket : noncopyable {
+  static constexpr size_t kGroBufferSize = 65536;
+  static constexpr size_t kMaxGsoSegments = 64;
+  static constexpr size_t kMaxGsoBytes = 65000;
+  static constexpr size_t kRecvControlSize = 64;
+  static constexpr size_t kSendControlSize = CMSG_SPACE(sizeof(uint16_t));
+
+ public:
+  /// 第二个参数为数据报的内容，只在回调期间有效
+  using MessageCallback = std::function<void(UdpSocket *, std::string_view, const InetAddress &)>;
+
+  UdpSocket(Reactor *reactor, const InetAddress &bind_addr, const UdpOptions &options = {})
+      : reactor_(reactor),
+        channel_(NewNonBlockUdpSocketFd(bind_addr.GetFamily())),
+        local_addr_(bind_addr),
+        options_(options),
+        gro_enabled_(false),
+        gso_enabled_(false),
+        send_pos_(0),
+        dropped_num_(0) {
+    NET_ASSERT(options_.batch_size > 0);
+    int fd = channel_.GetFd();
+    if (options_.reuse_port) net::SetReusePort(fd, true);
+    if (options_.recv_buffer_size > 0) net::SetRecvBufferSize(fd, options_.recv_buffer_size);
+    if (options_.send_buffer_size > 0) net::SetSendBufferSize(fd, options_.send_buffer_size);
+    if (options_.gro) {
+      gro_enabled_ = net::SetUdpGro(fd, true);
+      if (!gro_enabled_) {
+        LOG_INFO("udp gro is not supported");
+      }
+    }
+#ifdef UDP_SEGMENT
+    gso_enabled_ = options_.gso;
+#endif
+    net::Bind(fd, bind_addr);
+    local_addr_ = GetLocalAddr(fd);  // 绑定0端口时获取实际的端口
+
+    // 接收缓冲区在socket的整个生命周期内复用
+    size_t batch = options_.batch_size;
+    recv_buffer_size_ = gro_enabled_ ? kGroBufferSize : options_.max_datagram_size;
+    recv_buffer_.resize(batch * recv_buffer_size_);
+    recv_addr_vec_.resize(batch);
+    recv_iov_vec_.resize(batch);
+    recv_msg_vec_.resize(batch);
+    recv_control_.resize(gro_enabled_ ? batch * kRecvControlSize : 0);
+    send_iov_vec_.resize(batch);
+    send_msg_vec_.resize(batch);
+    send_count_vec_.resize(batch);
+    send_control_.resize(batch * kSendControlSize);
+
+    channel_.SetReadCallback([this] { HandleRead(); });
+    channel_.SetWriteCallback([this] { HandleWrite(); });
+    channel_.SetErrorCallback([this] { HandleError(); });
+    channel_.SetFlushCallback([this] { HandleFlush(); });
+  }
+  ~UdpSocket() {
+    net::Close(channel_.GetFd());
+  }
+
+  void SetMessageCallback(MessageCallback &&cb) {
+    message_callback_ = std::move(cb);
+  }
+  void SetMessageCallback(const MessageCallback &cb) {
+    message_callback_ = cb;
+  }
+
+  /// 将socket注册到Reactor中，开始接收数据报
+  /// @note 请在Reactor线程中调用
+  void Start() {
+    channel_.EnableRead();
+    reactor_->UpdateChannel(&channel_);
+  }
+  /// 将socket从Reactor中移除，发送队列中尚未发出的数据报将被丢弃
+  /// @note 请在Reactor线程中调用，Stop之后才能销毁UdpSocket
+  void Stop() {
+    channel_.DisableAll();
+    reactor_->RemoveChannel(&channel_);
+    pending_vec_.clear();
+    send_data_.clear();
+    send_pos_ = 0;
+  }
+
+  /// 发送一个数据报，同一轮中的多个数据报会在Reactor本轮处理结束后通过sendmmsg批量发出
+  /// @note 线程安全
+  void SendTo(std::string_view data, const InetAddress &peer) {
+    if (reactor_->InCurrentReactorThread()) {
+      RealSendTo(data, peer);
+    } else {
+      reactor_->SubmitTask([this, str = std::string(data), peer] {
+        RealSendTo(str, peer);
+      });
+    }
+  }
+
+  [[nodiscard]] int GetFd() const { return channel_.GetFd(); }
+  [[nodiscard]] Reactor *GetReactor() const { return reactor_; }
+  [[nodiscard]] const InetAddress &GetLocalAddress() const { return local_addr_; }
+  [[nodiscard]] bool IsGroEnabled() const { return gro_enabled_; }
+  [[nodiscard]] bool IsGsoEnabled() const { return gso_enabled_; }
+  /// @return 因发送队列已满或者发送失败而丢弃的数据报数量
+  [[nodiscard]] size_t GetDroppedNum() const { return dropped_num_; }
+  /// @return 发送队列的缓冲区中的字节数，包括已经发出但尚未回收的部分
+  [[nodiscard]] size_t GetSendQueueBytes() const { return send_data_.size(); }
+
+ private:
+  /// 发送队列中的一个数据报，内容位于send_data_的[offset, offset + len)
+  struct PendingDatagram {
+    size_t offset;
+    size_t len;
+    InetAddress peer;
+  };
+
+  void HandleRead() {
+    // 每次可读只调用一次recvmmsg，剩余的数据报在下一轮中处理(水平触发)，避免一直占用Reactor
+    size_t batch = options_.batch_size;
+    for (size_t i = 0; i < batch; ++i) {
+      recv_iov_vec_[i].iov_base = recv_buffer_.data() + i * recv_buffer_size_;
+      recv_iov_vec_[i].iov_len = recv_buffer_size_;
+      auto &hdr = recv_msg_vec_[i].msg_hdr;
+      hdr.msg_name = &recv_addr_vec_[i];
+      hdr.msg_namelen = sizeof(recv_addr_vec_[i]);
+      hdr.msg_iov = &recv_iov_vec_[i];
+      hdr.msg_iovlen = 1;
+      hdr.msg_control = gro_enabled_ ? recv_control_.data() + i * kRecvControlSize : nullptr;
+      hdr.msg_controllen = gro_enabled_ ? kRecvControlSize : 0;
+      hdr.msg_flags = 0;
+    }
+    int n = ::recvmmsg(channel_.GetFd(), recv_msg_vec_.data(), batch, MSG_DONTWAIT, nullptr);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG_ERROR("recvmmsg() failed: {}", strerror(errno));
+      }
+      return;
+    }
+    for (int i = 0; i < n; ++i) {
+      auto &hdr = recv_msg_vec_[i].msg_hdr;
+      InetAddress peer(SACast(&recv_addr_vec_[i]), hdr.msg_namelen);
+      const char *data = static_cast<const char *>(recv_iov_vec_[i].iov_base);
+      size_t len = recv_msg_vec_[i].msg_len;
+      // 开启GRO时，一次收到的可能是多个合并在一起的数据报，按照分段大小拆开
+      size_t segment_size = gro_enabled_ ? GetGroSegmentSize(hdr) : 0;
+      if (segment_size == 0) segment_size = std::max<size_t>(len, 1);
+      for (size_t offset = 0; offset < len || (len == 0 && offset == 0); offset += segment_size) {
+        if (message_callback_) {
+          message_callback_(this, std::string_view(data + offset, std::min(segment_size, len - offset)), peer);
+        }
+      }
+    }
+  }
+  void HandleWrite() {
+    if (!channel_.WriteEnabled()) return;
+    FlushSendQueue();
+  }
+  void HandleFlush() {
+    if (channel_.WriteEnabled()) return;  // 等待可写事件时会继续写
+    FlushSendQueue();
+  }
+  void HandleError() {
+    // 读取并清除socket上的错误(例如ICMP端口不可达)，否则水平触发会一直报告EPOLLERR
+    int err = net::GetSocketError(channel_.GetFd());
+    if (err != 0) {
+      LOG_ERROR("udp socket error: {}", strerror(err));
+    }
+  }
+
+  void RealSendTo(std::string_view data, const InetAddress &peer) {
+    if (pending_vec_.size() - send_pos_ >= options_.max_send_queue_size) {
+      ++dropped_num_;
+      return;
+    }
+    pending_vec_.push_back({send_data_.size(), data.size(), peer});
+    send_data_.append(data);
+    if (!channel_.WriteEnabled()) {
+      reactor_->QueueFlush(&channel_);
+    }
+  }
+
+  /// 尽可能多地发出发送队列中的数据报，socket发送缓冲区已满时关注可写事件
+  void FlushSendQueue() {
+    while (send_pos_ < pending_vec_.size()) {
+      size_t msg_num = 0;
+      size_t pos = send_pos_;
+      while (msg_num < options_.batch_size && pos < pending_vec_.size()) {
+        size_t count = CollectGsoSegments(pos);
+        const PendingDatagram &first = pending_vec_[pos];
+        const PendingDatagram &last = pending_vec_[pos + count - 1];
+        // 同一个GSO消息中的数据报在send_data_中是连续的，只需要一个iovec
+        auto &iov = send_iov_vec_[msg_num];
+        iov.iov_base = send_data_.data() + first.offset;
+        iov.iov_len = last.offset + last.len - first.offset;
+        auto &hdr = send_msg_vec_[msg_num].msg_hdr;
+        bzero(&hdr, sizeof(hdr));
+        hdr.msg_name = const_cast<struct sockaddr *>(first.peer.GetSockAddr());
+        hdr.msg_namelen = first.peer.GetSockLen();
+        hdr.msg_iov = &iov;
+        hdr.msg_iovlen = 1;
+#ifdef UDP_SEGMENT
+        if (count > 1) {
+          hdr.msg_control = send_control_.data() + msg_num * kSendControlSize;
+          hdr.msg_controllen = kSendControlSize;
+          struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+          cmsg->cmsg_level = IPPROTO_UDP;
+          cmsg->cmsg_type = UDP_SEGMENT;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+          auto segment_size = static_cast<uint16_t>(first.len);
+          memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+        }
+#endif
+        send_count_vec_[msg_num] = count;
+        pos += count;
+        ++msg_num;
+      }
+      int n = ::sendmmsg(channel_.GetFd(), send_msg_vec_.data(), msg_num, 0);
+      if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          if (!channel_.WriteEnabled()) {
+            channel_.EnableWrite();
+            reactor_->UpdateChannel(&channel_);
+          }
+          CompactSendQueue();
+          return;
+        }
+        if (errno == EINTR) continue;
+        if (send_count_vec_[0] > 1 && (errno == EIO || errno == EINVAL)) {
+          // 网卡或内核不支持GSO，之后逐个发送
+          LOG_ERROR("udp gso failed: {}, disable gso", strerror(errno));
+          gso_enabled_ = false;
+          continue;
+        }
+        // 丢弃发送失败的消息中的数据报，继续发送后面的
+        LOG_ERROR("sendmmsg() failed: {}", strerror(errno));
+        dropped_num_ += send_count_vec_[0];
+        send_pos_ += send_count_vec_[0];
+        continue;
+      }
+      for (int i = 0; i < n; ++i) {
+        send_pos_ += send_count_vec_[i];
+      }
+    }
+    // 发送队列已清空，保留容量以便复用
+    pending_vec_.clear();
+    send_data_.clear();
+    send_pos_ = 0;
+    if (channel_.WriteEnabled()) {
+      channel_.DisableWrite();
+      reactor_->UpdateChannel(&channel_);
+    }
+  }
+
+  /// 回收已经发出的数据报占用的空间，剩余数据报的偏移量随之前移，避免持续阻塞时队列无限增长
+  /// @note 只在已发出的部分超过一半时回收，复制的总量与发出的数据量成正比
+  void CompactSendQueue() {
+    if (send_pos_ == 0 || send_pos_ * 2 < pending_vec_.size()) return;
+    size_t base = pending_vec_[send_pos_].offset;
+    send_data_.erase(0, base);
+    pending_vec_.erase(pending_vec_.begin(), pending_vec_.begin() + static_cast<ptrdiff_t>(send_pos_));
+    for (auto &datagram: pending_vec_) {
+      datagram.offset -= base;
+    }
+    send_pos_ = 0;
+  }
+
+  /// @return 从pos开始可以合并成一个GSO消息的数据报数量: 发往同一地址，除最后一个外长度都相同
+  size_t CollectGsoSegments(size_t pos) const {
+    if (!gso_enabled_) return 1;
+    const PendingDatagram &first = pending_vec_[pos];
+    if (first.len == 0) return 1;
+    size_t count = 1;
+    size_t total = first.len;
+    while (pos + count < pending_vec_.size() && count < kMaxGsoSegments) {
+      const PendingDatagram &next = pending_vec_[pos + count];
+      if (next.len == 0 || next.len > first.len || total + next.len > kMaxGsoBytes) break;
+      if (next.peer.GetSockLen() != first.peer.GetSockLen() ||
+          memcmp(next.peer.GetSockAddr(), first.peer.GetSockAddr(), first.peer.GetSockLen()) != 0) {
+        break;
+      }
+      total += next.len;
+      ++count;
+      if (next.len < first.len) break;  // 较短的数据报只能作为最后一个分段
+    }
+    return count;
+  }
+
+  static size_t GetGroSegmentSize(struct msghdr &hdr) {
+#ifdef UDP_GRO
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+      if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+        int segment_size = 0;
+        memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+        return segment_size;
+      }
+    }
+#endif
+    return 0;
+  }
+
+  Reactor *reactor_;
+  Channel channel_;
+  InetAddress local_addr_;
+  UdpOptions options_;
+  bool gro_enabled_;
+  bool gso_enabled_;
+  MessageCallback message_callback_;
+
+  // 接收相关的结构，在构造时按照batch_size分配
+  size_t recv_buffer_size_;
+  std::vector<char> recv_buffer_;
+  std::vector<struct sockaddr_storage> recv_addr_vec_;
+  std::vector<struct iovec> recv_iov_vec_;
+  std::vector<struct mmsghdr> recv_msg_vec_;
+  std::vector<char> recv_control_;
+
+  // 发送队列以及发送相关的结构
+  std::string send_data_;
+  std::vector<PendingDatagram> pending_vec_;
+  size_t send_pos_;                       ///< pending_vec_中第一个尚未发出的数据报
+  std::vector<struct iovec> send_iov_vec_;
+  std::vector<struct mmsghdr> send_msg_vec_;
+  std::vector<size_t> send_count_vec_;    ///< 每个消息包含的数据报数量
+  std::vector<char> send_control_;
+  size_t dropped_num_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_UDP_UDP_SOCKET_HPP_
@@ -0,0 +1,110 @@
+#ifndef NET_INCLUDE_NET_UTIL_ARENA_HPP_
+#define NET_INCLUDE_NET_UTIL_ARENA_HPP_
+
+#include "net/noncopyable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace net {
+
+/// 按块分配的线性内存池，只能整体释放
+///
+/// 用于生命周期相同的一批小对象(例如一个HTTP请求中需要规范化的数据)：分配只是移动指针，
+/// Reset时保留第一个块，因此在同一个Arena上反复处理请求时，稳定状态下不会再向系统申请内存
+class Arena : noncopyable {
+ public:
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize)
+      : block_size_(block_size),
+        ptr_(nullptr),
+        remaining_(0),
+        memory_usage_(0) {}
+
+  /// 分配n字节对齐到align的内存，在Reset或者Arena析构之前有效
+  char *Allocate(size_t n, size_t align = alignof(std::max_align_t)) {
+    size_t padding = (align - reinterpret_cast<uintptr_t>(ptr_) % align) % align;
+    if (n + padding > remaining_) {
+      return AllocateFallback(n, align);
+    }
+    char *result = ptr_ + padding;
+    ptr_ += n + padding;
+    remaining_ -= n + padding;
+    return result;
+  }
+
+  /// 将s复制到Arena中
+  std::string_view Copy(std::string_view s) {
+    if (s.empty()) return {};
+    char *dst = Allocate(s.size(), 1);
+    memcpy(dst, s.data(), s.size());
+    return {dst, s.size()};
+  }
+
+  /// 将多段字符串拼接后存放到Arena中
+  std::string_view Concat(std::initializer_list<std::string_view> pieces) {
+    size_t total = 0;
+    for (auto piece: pieces) {
+      total += piece.size();
+    }
+    if (total == 0) return {};
+    char *dst = Allocate(total, 1);
+    size_t offset = 0;
+    for (auto piece: pieces) {
+      memcpy(dst + offset, piece.data(), piece.size());
+      offset += piece.size();
+    }
+    return {dst, total};
+  }
+
+  /// 释放所有分配的内存，保留第一个块以便复用
+  void Reset() {
+    if (block_vec_.empty()) return;
+    block_vec_.resize(1);
+    ptr_ = block_vec_.front().get();
+    remaining_ = block_size_;
+    memory_usage_ = block_size_;
+  }
+
+  /// @return 向系统申请的内存总量
+  [[nodiscard]] size_t GetMemoryUsage() const { return memory_usage_; }
+
+ private:
+  char *AllocateFallback(size_t n, size_t align) {
+    if (block_vec_.empty()) {
+      // 第一个块总是标准大小，Reset时保留
+      ptr_ = NewBlock(block_size_);
+      remaining_ = block_size_;
+      if (n + align <= block_size_) return Allocate(n, align);
+    }
+    if (n + align > block_size_ / 4) {
+      // 较大的分配单独使用一个块，不浪费当前块的剩余空间
+      char *block = NewBlock(n + align);
+      return block + (align - reinterpret_cast<uintptr_t>(block) % align) % align;
+    }
+    ptr_ = NewBlock(block_size_);
+    remaining_ = block_size_;
+    return Allocate(n, align);
+  }
+
+  char *NewBlock(size_t size) {
+    block_vec_.emplace_back(new char[size]);  // 不需要make_unique的零初始化
+    memory_usage_ += size;
+    return block_vec_.back().get();
+  }
+
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> block_vec_;
+  char *ptr_;             ///< 当前块中下一个可分配的位置
+  size_t remaining_;      ///< 当前块中剩余的字节数
+  size_t memory_usage_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_UTIL_ARENA_HPP_
@@ -0,0 +1,135 @@
+#ifndef NET_INCLUDE_NET_UTIL_BIASED_PTR_HPP_
+#define NET_INCLUDE_NET_UTIL_BIASED_PTR_HPP_
+
+#include "net/noncopyable.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace net {
+
+/// 偏向引用计数(Biased Reference Counting)的侵入式基类
+///
+/// 在拥有者线程(例如TcpConnection所属的Reactor线程)上增减引用计数时只修改非原子的local_ref_，
+/// 其他线程上的引用则计入原子的shared_ref_；local_ref_不为0时，会在shared_ref_上额外占用一个引用。
+/// 因此只要拥有者线程上一直持有一个引用，拥有者线程上的拷贝和释放都不需要原子操作
+///
+/// Derived需要提供以下接口(可以为private，并将BiasedRefCounted<Derived>声明为友元):
+/// - bool IsOwnerThread() const: 当前线程是否是拥有者线程
+/// - void RunInOwnerThread(std::function<void()> &&task): 将任务提交到拥有者线程执行
+/// - void OnRefCountZero(): 引用计数归零时调用，负责释放对象
+template<typename Derived>
+class BiasedRefCounted : noncopyable {
+ public:
+  /// 增加一个引用
+  /// @return 该引用是否计在拥有者线程的非原子计数上，释放时需要原样传给Release
+  bool AddRef() {
+    if (GetDerived()->IsOwnerThread()) {
+      if (local_ref_++ == 0) {
+        shared_ref_.fetch_add(1, std::memory_order_relaxed);
+      }
+      return true;
+    }
+    shared_ref_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /// 释放一个引用，在其他线程释放计在拥有者线程上的引用时，会将释放操作提交到拥有者线程
+  void Release(bool local) {
+    if (!local) {
+      ReleaseShared();
+    } else if (GetDerived()->IsOwnerThread()) {
+      ReleaseLocal();
+    } else {
+      GetDerived()->RunInOwnerThread([this] { ReleaseLocal(); });
+    }
+  }
+
+  /// @return 近似的引用数量，仅用于调试
+  [[nodiscard]] int GetRefCount() const {
+    return local_ref_ + shared_ref_.load(std::memory_order_relaxed) - (local_ref_ > 0 ? 1 : 0);
+  }
+
+ private:
+  void ReleaseLocal() {
+    if (--local_ref_ == 0) {
+      ReleaseShared();
+    }
+  }
+  void ReleaseShared() {
+    if (shared_ref_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      GetDerived()->OnRefCountZero();
+    }
+  }
+
+  Derived *GetDerived() { return static_cast<Derived *>(this); }
+
+  int local_ref_ = 0;                 ///< 拥有者线程上的引用数，只在拥有者线程中访问
+  std::atomic<int> shared_ref_{0};    ///< 其他线程上的引用数，local_ref_不为0时额外加一
+};
+
+/// 指向BiasedRefCounted对象的智能指针，接口与std::shared_ptr类似
+template<typename T>
+class BiasedPtr {
+ public:
+  BiasedPtr() : ptr_(nullptr), local_(false) {}
+  BiasedPtr(std::nullptr_t) : BiasedPtr() {}  // NOLINT
+  explicit BiasedPtr(T *ptr) : ptr_(ptr), local_(ptr ? ptr->AddRef() : false) {}
+
+  BiasedPtr(const BiasedPtr &other) : BiasedPtr(other.ptr_) {}
+  BiasedPtr(BiasedPtr &&other) noexcept : ptr_(other.ptr_), local_(other.local_) {
+    other.ptr_ = nullptr;
+  }
+  BiasedPtr &operator=(const BiasedPtr &other) {
+    if (this != &other) {
+      BiasedPtr(other).Swap(*this);
+    }
+    return *this;
+  }
+  BiasedPtr &operator=(BiasedPtr &&other) noexcept {
+    if (this != &other) {
+      BiasedPtr(std::move(other)).Swap(*this);
+    }
+    return *this;
+  }
+  ~BiasedPtr() { reset(); }
+
+  void reset() {
+    // 先置空再释放，释放时对象可能被析构(包括持有该指针的对象本身)
+    T *ptr = ptr_;
+    ptr_ = nullptr;
+    if (ptr) {
+      ptr->Release(local_);
+    }
+  }
+  void Swap(BiasedPtr &other) noexcept {
+    std::swap(ptr_, other.ptr_);
+    std::swap(local_, other.local_);
+  }
+
+  [[nodiscard]] T *get() const { return ptr_; }
+  T *operator->() const { return ptr_; }
+  T &operator*() const { return *ptr_; }
+  explicit operator bool() const { return ptr_ != nullptr; }
+
+  friend bool operator==(const BiasedPtr &lhs, const BiasedPtr &rhs) { return lhs.ptr_ == rhs.ptr_; }
+  friend bool operator!=(const BiasedPtr &lhs, const BiasedPtr &rhs) { return lhs.ptr_ != rhs.ptr_; }
+  friend bool operator==(const BiasedPtr &lhs, std::nullptr_t) { return lhs.ptr_ == nullptr; }
+  friend bool operator!=(const BiasedPtr &lhs, std::nullptr_t) { return lhs.ptr_ != nullptr; }
+
+ private:
+  T *ptr_;
+  bool local_;  ///< 该引用是否计在拥有者线程的非原子计数上
+};
+
+} // namespace net
+
+template<typename T>
+struct std::hash<net::BiasedPtr<T>> {
+  size_t operator()(const net::BiasedPtr<T> &ptr) const noexcept {
+    return std::hash<T *>()(ptr.get());
+  }
+};
+
+#endif //NET_INCLUDE_NET_UTIL_BIASED_PTR_HPP_
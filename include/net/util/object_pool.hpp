@@ -1,53 +1,100 @@
 #ifndef NET_INCLUDE_NET_UTIL_OBJECT_POOL_HPP_
 #define NET_INCLUDE_NET_UTIL_OBJECT_POOL_HPP_
 
+#include "net/noncopyable.hpp"
+#include "net/containers/mpmc_queue.hpp"
+#include "net/util/thread_local_instance.hpp"
+
+#include <algorithm>
 #include <vector>
 #include <memory>
-#include <functional>
 
 namespace net {
 
-/// 非线程安全
+/// 线程安全的对象池
+///
+/// 每个线程拥有一个本地缓存(magazine)，Get/Add优先在本地缓存上进行，不需要任何同步；
+/// 本地缓存为空时从全局仓库(depot，无锁队列)中批量取回，本地缓存满时批量归还一半到全局仓库。
+/// 因此在一个线程获取、在另一个线程释放的对象(例如TcpServer中的TcpConnection)，
+/// 会经由全局仓库批量地流回获取对象的线程，而不需要逐个对象地跨线程同步
+/// @note 对象池析构之后，不能再向其中归还对象
 template<typename T>
-class ObjectPool {
-  static constexpr int kInitPoolSize = 1024;
-  static constexpr int kOnceExtendSize = 1024;
- public:
-  explicit ObjectPool(int size = kInitPoolSize) {
-    object_vec_.reserve(size);
-    for (int i = 0; i < size; ++i) {
-      object_vec_.push_back(new T);
+class ObjectPool : noncopyable {
+  static constexpr size_t kMagazineSize = 64;      ///< 每个线程本地缓存的容量
+  static constexpr size_t kNoIdleLimit = SIZE_MAX;
+
+  /// 全局仓库，由对象池以及各个线程的本地缓存共同持有
+  struct Depot {
+    containers::MPMCQueue<T *> queue;
+
+    ~Depot() {
+      T *object;
+      while (queue.try_dequeue(object)) {
+        delete object;
+      }
     }
-  }
-  ~ObjectPool() {
-    for (auto object: object_vec_) {
-      delete object;
+  };
+
+  /// 线程本地缓存，线程退出时会将缓存的对象归还到全局仓库
+  struct Magazine {
+    explicit Magazine(std::shared_ptr<Depot> depot) : depot(std::move(depot)) {
+      objects.reserve(kMagazineSize);
     }
+    ~Magazine() {
+      if (!objects.empty()) {
+        depot->queue.enqueue_bulk(objects.begin(), objects.size());
+      }
+    }
+
+    std::vector<T *> objects;
+    std::shared_ptr<Depot> depot;
+  };
+
+ public:
+  /// GetUnique返回的unique_ptr的删除器，只保存对象池指针，不需要额外的堆分配和间接调用
+  struct Deleter {
+    ObjectPool *pool;
+    void operator()(T *object) const { pool->Add(object); }
+  };
+  using UniquePtr = std::unique_ptr<T, Deleter>;
+
+  /// @param warm_up_size 预先创建的对象数量，为0表示按需创建
+  /// @param max_idle_size 全局仓库中最多保留的空闲对象数量，超出的对象在归还时直接释放
+  explicit ObjectPool(size_t warm_up_size = 0, size_t max_idle_size = kNoIdleLimit)
+      : depot_(std::make_shared<Depot>()),
+        max_idle_size_(max_idle_size) {
+    WarmUp(warm_up_size);
   }
 
   /// 从线程池中获取一个对象，在返回的shared_ptr生命周期结束后，会自动将对象放回到对象池中
+  /// @note 返回的shared_ptr可以在任意线程中释放
+  /// @note 每次调用都会额外分配一个shared_ptr的控制块，频繁获取的对象请使用GetUnique或侵入式引用计数
   std::shared_ptr<T> GetShared() {
     return std::shared_ptr<T>(Get(), [this](T *object) {
       Add(object);
     });
   }
 
-  std::unique_ptr<T, std::function<void(T *)>> GetUnique() {
-    return std::unique_ptr<T, std::function<void(T *)>>(Get(), [this](T *object) {
-      Add(object);
-    });
+  UniquePtr GetUnique() {
+    return UniquePtr(Get(), Deleter{this});
   }
 
   /// 从对象池中获取一个对象，返回原始指针
   /// @note 不建议直接使用该接口
   T *Get() {
-    if (object_vec_.empty()) {  // 容量不够了，扩充对象池
-      for (int i = 0; i < kOnceExtendSize; ++i) {
-        object_vec_.push_back(new T);
+    Magazine *magazine = GetLocalMagazine();
+    auto &objects = magazine->objects;
+    if (objects.empty()) {
+      // 本地缓存为空，从全局仓库中批量取回一半容量的对象
+      objects.resize(kMagazineSize / 2);
+      size_t n = depot_->queue.try_dequeue_bulk(objects.begin(), objects.size());
+      objects.resize(n);
+      if (n == 0) {
+        return new T;
       }
     }
-    T *object = object_vec_.back();
-    object_vec_.pop_back();
+    T *object = objects.back();
+    objects.pop_back();
     return object;
   }
 
@@ -55,39 +102,87 @@ class ObjectPool {
   /// 最好只将Get()的返回值使用Add添加到对象池中
   /// @note 不建议使用该接口
   void Add(T *object) {
-    object_vec_.push_back(object);
+    Magazine *magazine = GetLocalMagazine();
+    auto &objects = magazine->objects;
+    if (objects.size() == kMagazineSize) {
+      // 本地缓存已满，将一半的对象归还到全局仓库
+      auto half = objects.begin() + kMagazineSize / 2;
+      size_t idle = depot_->queue.size_approx();
+      size_t keep = idle >= max_idle_size_ ? 0 : std::min(max_idle_size_ - idle, kMagazineSize / 2);
+      depot_->queue.enqueue_bulk(half, keep);
+      std::for_each(half + keep, objects.end(), [](T *obj) { delete obj; });
+      objects.erase(half, objects.end());
+    }
+    objects.push_back(object);
+  }
+
+  /// 预先创建n个对象放入全局仓库
+  void WarmUp(size_t n) {
+    if (n == 0) return;
+    std::vector<T *> objects;
+    objects.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      objects.push_back(new T);
+    }
+    depot_->queue.enqueue_bulk(objects.begin(), objects.size());
+  }
+
+  /// 释放全局仓库中超出max_idle_size的空闲对象，可定期调用以回收内存
+  /// @return 释放的对象数量
+  size_t Trim(size_t max_idle_size = 0) {
+    size_t idle = depot_->queue.size_approx();
+    size_t trimmed = 0;
+    T *object;
+    while (idle > max_idle_size && depot_->queue.try_dequeue(object)) {
+      delete object;
+      --idle;
+      ++trimmed;
+    }
+    return trimmed;
+  }
+
+  /// @return 全局仓库中空闲对象的近似数量(不包括各个线程本地缓存中的对象)
+  [[nodiscard]] size_t GetIdleSize() const {
+    return depot_->queue.size_approx();
   }
 
  private:
-  std::vector<T *> object_vec_;
+  /// 获取当前线程在该对象池上的本地缓存，不存在则创建
+  Magazine *GetLocalMagazine() {
+    return &magazines_.Get(depot_);
+  }
+
+  std::shared_ptr<Depot> depot_;
+  ThreadLocalInstance<Magazine> magazines_;   ///< 各个线程的本地缓存，对象池析构后由各个线程自行清理
+  size_t max_idle_size_;
 };
 
 namespace object_pool {
 
 template<typename T>
-inline ObjectPool<T> *GetTLSObjectPool() {
-  thread_local static ObjectPool<T> object_pool_tls;
-  return &object_pool_tls;
+inline ObjectPool<T> *GetGlobalObjectPool() {
+  static ObjectPool<T> object_pool;
+  return &object_pool;
 }
 
 template<typename T>
 inline std::shared_ptr<T> NewShared() {
-  return GetTLSObjectPool<T>()->GetShared();
+  return GetGlobalObjectPool<T>()->GetShared();
 }
 
 template<typename T>
-inline std::unique_ptr<T, std::function<void(T *)>> NewUnique() {
-  return GetTLSObjectPool<T>()->GetUnique();
+inline typename ObjectPool<T>::UniquePtr NewUnique() {
+  return GetGlobalObjectPool<T>()->GetUnique();
 }
 
 template<typename T>
 inline T *New() {
-  return GetTLSObjectPool<T>()->Get();
+  return GetGlobalObjectPool<T>()->Get();
 }
 
 template<typename T>
 inline void Delete(T *object) {
-  GetTLSObjectPool<T>()->Add(object);
+  GetGlobalObjectPool<T>()->Add(object);
 }
 
 } // namespace net::object_pool
@@ -1,6 +1,7 @@
 #ifndef NET_INCLUDE_NET_UTIL_STRING_HPP_
 #define NET_INCLUDE_NET_UTIL_STRING_HPP_
 
+#include <string>
 #include <string_view>
 
 namespace net {
@@ -20,6 +21,25 @@ inline bool RemovePrefix(std::string &result, std::string_view s, std::string_vi
   return true;
 }
 
+/// @return 去除首尾空格与制表符之后的s
+inline std::string_view Trim(std::string_view s) {
+  size_t begin = s.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) return {};
+  return s.substr(begin, s.find_last_not_of(" \t") + 1 - begin);
+}
+
+/// 忽略ASCII大小写比较两个字符串是否相等，用于HTTP头部名称等大小写不敏感的场景
+inline bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+  if (lhs.size() != rhs.size()) return false;
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    char a = lhs[i], b = rhs[i];
+    if (a >= 'A' && a <= 'Z') a = static_cast<char>(a - 'A' + 'a');
+    if (b >= 'A' && b <= 'Z') b = static_cast<char>(b - 'A' + 'a');
+    if (a != b) return false;
+  }
+  return true;
+}
+
 }
 
 #endif //NET_INCLUDE_NET_UTIL_STRING_HPP_
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef NET_INCLUDE_NET_UTIL_THREAD_LOCAL_INSTANCE_HPP_
+#define NET_INCLUDE_NET_UTIL_THREAD_LOCAL_INSTANCE_HPP_
+
+#include "net/noncopyable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace net {
+
+/// 每个对象在每个线程中各有一份的数据，例如对象池的线程本地缓存、微缓存的分片
+///
+/// 各个线程的数据保存在该线程的thread_local表中，以对象的唯一标识查找，访问时不需要任何同步。
+/// 对象析构之后，其他线程中的数据不会立即析构，而是在该线程下一次创建数据时清理，或者在线程退出时析构，
+/// 因此Local需要持有(例如通过shared_ptr)它在析构时仍然要访问的状态
+/// @tparam Local 每个线程中的数据的类型，只在所在的线程中访问
+template<typename Local>
+class ThreadLocalInstance : noncopyable {
+ public:
+  ThreadLocalInstance() : id_(NextId()), closed_(std::make_shared<std::atomic<bool>>(false)) {}
+  ~ThreadLocalInstance() {
+    closed_->store(true, std::memory_order_release);
+  }
+
+  /// @return 当前线程的数据，不存在时以args构造
+  template<typename... Args>
+  Local &Get(Args &&...args) {
+    thread_local std::vector<Slot> slot_vec;
+    for (auto &slot: slot_vec) {
+      if (slot.id == id_) return *slot.local;
+    }
+    // 顺便清理已经析构的对象在该线程中的数据
+    slot_vec.erase(std::remove_if(slot_vec.begin(), slot_vec.end(), [](const Slot &slot) {
+      return slot.closed->load(std::memory_order_acquire);
+    }), slot_vec.end());
+    slot_vec.push_back({id_, closed_, std::make_unique<Local>(std::forward<Args>(args)...)});
+    return *slot_vec.back().local;
+  }
+
+ private:
+  struct Slot {
+    uint64_t id;
+    std::shared_ptr<const std::atomic<bool>> closed;  ///< 所属的对象是否已经析构
+    std::unique_ptr<Local> local;
+  };
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id{0};
+    return ++next_id;
+  }
+
+  uint64_t id_;                               ///< 对象的唯一标识，用于查找线程本地的数据
+  std::shared_ptr<std::atomic<bool>> closed_;
+};
+
+} // namespace net
+
+#endif //NET_INCLUDE_NET_UTIL_THREAD_LOCAL_INSTANCE_HPP_
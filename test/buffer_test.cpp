@@ -79,3 +79,13 @@ TEST_F(BufferTest, Search) {
   EXPECT_EQ(buffer.RetriveAll(), "\r\n");
   EXPECT_EQ(buffer.ReadableBytes(), 0);
 }
+
+TEST_F(BufferTest, ReuseReadSpace) {
+  net::Buffer buffer(16);
+  buffer.Append("0123456789abcdef");
+  buffer.HasRead(10);
+  // 前面已读取部分的空间足够，追加时不会扩容
+  buffer.Append("ghijklmn");
+  EXPECT_EQ(buffer.WritableBytes(), 2);
+  EXPECT_EQ(buffer.RetriveAll(), "abcdefghijklmn");
+}
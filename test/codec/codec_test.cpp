@@ -0,0 +1,143 @@
+#include <net/codec/length_field_codec.hpp>
+#include <net/codec/delimiter_codec.hpp>
+
+#include "net_test.hpp"
+
+#include <sys/socket.h>
+
+class CodecTest : public testing::Test {
+ public:
+  CodecTest() : reactor_(new net::Reactor) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+    conn_fd_ = fds[0];
+    peer_fd_ = fds[1];
+    conn_ = net::TcpConnection::New();
+    conn_->Init(reactor_, conn_fd_, net::InetAddress(0), net::InetAddress(0));
+    conn_->SetCloseCallback([this](const net::TcpConnectionPtr &conn) {
+      closed_ = true;
+      conn->Destroy();
+    });
+  }
+  ~CodecTest() override {
+    ::close(peer_fd_);  // conn_fd_由TcpConnection负责关闭
+    delete reactor_;
+  }
+
+  void WritePeer(std::string_view data) const {
+    ASSERT_EQ(::write(peer_fd_, data.data(), data.size()), data.size());
+  }
+  std::string ReadPeer() const {
+    std::string s;
+    char buf[1024];
+    ssize_t n;
+    while ((n = ::recv(peer_fd_, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+      s.append(buf, n);
+    }
+    return s;
+  }
+
+  net::Reactor *reactor_;
+  net::TcpConnectionPtr conn_;
+  int conn_fd_;
+  int peer_fd_;
+  bool closed_ = false;
+};
+
+TEST_F(CodecTest, LengthFieldDecode) {
+  using Codec = net::LengthFieldCodec<uint16_t>;
+  std::vector<std::string> frames;
+  Codec codec([&](const net::TcpConnectionPtr &, std::string_view frame) {
+    frames.emplace_back(frame);
+  });
+  conn_->SetMessageCallback([&](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+    codec.OnMessage(conn, buffer);
+  });
+  // 两个完整的帧和一个不完整的帧
+  WritePeer(std::string("\x00\x05hello\x00\x00\x00\x05wor", 14));
+  reactor_->SubmitTask([this] { conn_->Establish(); });
+  reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+    EXPECT_EQ(frames, (std::vector<std::string>{"hello", ""}));
+    WritePeer("ld");
+    reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+      EXPECT_EQ(frames, (std::vector<std::string>{"hello", "", "world"}));
+      reactor_->Stop();
+    });
+  });
+  reactor_->Run();
+}
+
+TEST_F(CodecTest, LengthFieldEncode) {
+  char header[4];
+  net::LengthFieldCodec<uint32_t>::EncodeLength(0x01020304, header);
+  EXPECT_EQ(std::string_view(header, 4), std::string_view("\x01\x02\x03\x04", 4));
+  EXPECT_EQ(net::LengthFieldCodec<uint32_t>::DecodeLength(header), 0x01020304);
+  net::LengthFieldCodec<uint32_t, net::Endian::Little>::EncodeLength(0x01020304, header);
+  EXPECT_EQ(std::string_view(header, 4), std::string_view("\x04\x03\x02\x01", 4));
+  EXPECT_EQ((net::LengthFieldCodec<uint32_t, net::Endian::Little>::DecodeLength(header)), 0x01020304);
+
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    net::LengthFieldCodec<uint16_t>::Send(conn_, "abc");
+    EXPECT_EQ(ReadPeer(), std::string("\x00\x03" "abc", 5));
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(CodecTest, LengthFieldMaxFrameSize) {
+  net::LengthFieldCodec<uint32_t> codec([](const net::TcpConnectionPtr &, std::string_view) {
+    FAIL();
+  }, 1024);
+  conn_->SetMessageCallback([&](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+    codec.OnMessage(conn, buffer);
+  });
+  WritePeer(std::string("\x00\x01\x00\x00", 4));
+  reactor_->SubmitTask([this] { conn_->Establish(); });
+  reactor_->AddTimerAfter(std::chrono::milliseconds(10), [this] {
+    EXPECT_TRUE(closed_);
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(CodecTest, Delimiter) {
+  std::vector<std::string> frames;
+  net::DelimiterCodec codec([&](const net::TcpConnectionPtr &, std::string_view frame) {
+    frames.emplace_back(frame);
+  });
+  conn_->SetMessageCallback([&](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+    codec.OnMessage(conn, buffer);
+  });
+  WritePeer("GET\r\n\r\nSET a 1\r\nDEL");
+  reactor_->SubmitTask([&] {
+    conn_->Establish();
+    codec.Send(conn_, "OK");
+    EXPECT_EQ(ReadPeer(), "OK\r\n");
+  });
+  reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+    EXPECT_EQ(frames, (std::vector<std::string>{"GET", "", "SET a 1"}));
+    WritePeer(" a\r\n");
+    reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+      EXPECT_EQ(frames, (std::vector<std::string>{"GET", "", "SET a 1", "DEL a"}));
+      reactor_->Stop();
+    });
+  });
+  reactor_->Run();
+}
+
+TEST_F(CodecTest, DelimiterMaxFrameSize) {
+  net::DelimiterCodec codec([](const net::TcpConnectionPtr &, std::string_view) {
+    FAIL();
+  }, "\n", 16);
+  conn_->SetMessageCallback([&](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+    codec.OnMessage(conn, buffer);
+  });
+  WritePeer(std::string(64, 'x'));
+  reactor_->SubmitTask([this] { conn_->Establish(); });
+  reactor_->AddTimerAfter(std::chrono::milliseconds(10), [this] {
+    EXPECT_TRUE(closed_);
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
@@ -0,0 +1,198 @@
+#include <net/coro/connection.hpp>
+#include <net/coro/sleep.hpp>
+
+#include "net_test.hpp"
+
+#include <sys/socket.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+net::coro::Task<int> Add(int a, int b) {
+  co_return a + b;
+}
+
+net::coro::Task<int> Sum(int n) {
+  int sum = 0;
+  for (int i = 1; i <= n; ++i) {
+    sum = co_await Add(sum, i);
+  }
+  co_return sum;
+}
+
+net::coro::Task<> Echo(net::coro::Connection conn) {
+  while (true) {
+    std::string_view data = co_await conn.Read();
+    if (data.empty()) break;
+    if (!co_await conn.Write(data)) break;
+    conn.Consume(data.size());
+  }
+}
+
+} // namespace
+
+TEST(CoroTest, TaskChain) {
+  bool done = false;
+  net::coro::Spawn([&]() -> net::coro::Task<> {
+    EXPECT_EQ(co_await Sum(100), 5050);
+    done = true;
+  }());
+  EXPECT_TRUE(done);
+}
+
+TEST(CoroTest, FrameAllocatorReuse) {
+  void *first = net::coro::FrameAllocator::Allocate(200);
+  net::coro::FrameAllocator::Deallocate(first, 200);
+  // 同一大小类中的帧会被复用
+  void *second = net::coro::FrameAllocator::Allocate(250);
+  EXPECT_EQ(first, second);
+  net::coro::FrameAllocator::Deallocate(second, 250);
+}
+
+TEST(CoroTest, SleepFor) {
+  net::Reactor reactor;
+  std::vector<int> order;
+  auto sleeper = [&](int id, net::Duration dur) -> net::coro::Task<> {
+    co_await net::coro::SleepFor(dur);
+    EXPECT_TRUE(reactor.InCurrentReactorThread());
+    order.push_back(id);
+    if (order.size() == 2) reactor.Stop();
+  };
+  reactor.SubmitTask([&] {
+    net::coro::Spawn(sleeper(1, 30ms));
+    net::coro::Spawn(sleeper(2, 10ms));
+  });
+  reactor.AddTimerAfter(5s, [&] { reactor.Stop(); });
+  reactor.Run();
+  EXPECT_EQ(order, (std::vector<int>{2, 1}));
+}
+
+/// 通过socketpair连接两个TcpConnection，服务端运行Echo协程
+class CoroConnectionTest : public testing::Test {
+ public:
+  CoroConnectionTest() : reactor_(new net::Reactor) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+    server_conn_ = NewConnection(fds[0]);
+    server_conn_->SetConnectionCallback(net::coro::MakeConnectionCallback([this](net::coro::Connection conn) {
+      return RunEcho(std::move(conn));
+    }));
+    client_conn_ = NewConnection(fds[1]);
+    client_conn_->SetConnectionCallback(net::coro::Connection::OnConnection);
+  }
+
+  net::TcpConnectionPtr NewConnection(int fd) {
+    auto conn = net::TcpConnection::New();
+    conn->Init(reactor_.get(), fd, net::InetAddress(0), net::InetAddress(0));
+    conn->SetCloseCallback([](const net::TcpConnectionPtr &conn) { conn->Destroy(); });
+    return conn;
+  }
+  net::coro::Task<> RunEcho(net::coro::Connection conn) {
+    co_await Echo(std::move(conn));
+    echo_finished_ = true;
+  }
+
+  // reactor_需要最后析构
+  std::unique_ptr<net::Reactor> reactor_;
+  net::TcpConnectionPtr server_conn_;
+  net::TcpConnectionPtr client_conn_;
+  bool echo_finished_ = false;
+};
+
+TEST_F(CoroConnectionTest, EchoAndClose) {
+  std::string received;
+  auto client = [&]() -> net::coro::Task<> {
+    net::coro::Connection conn(client_conn_);
+    client_conn_->Establish();
+    for (int i = 0; i < 100; ++i) {
+      std::string message = "message " + std::to_string(i);
+      EXPECT_TRUE(co_await conn.Write(message));
+      // 按照消息长度读取，数据可能分多次到达
+      while (true) {
+        std::string_view data = co_await conn.Read();
+        if (data.size() >= message.size()) break;
+        EXPECT_FALSE(data.empty());
+      }
+      received.append(conn.GetInputBuffer()->Retrive(message.size()));
+    }
+    // 析构时关闭写方向，服务端的Echo协程读到EOF后结束
+  };
+  reactor_->SubmitTask([&] {
+    server_conn_->Establish();
+    net::coro::Spawn(client());
+  });
+  reactor_->AddTimerEvery(1ms, [this] {
+    if (echo_finished_) reactor_->Stop();
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  EXPECT_TRUE(echo_finished_);
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    expected += "message " + std::to_string(i);
+  }
+  EXPECT_EQ(received, expected);
+}
+
+TEST_F(CoroConnectionTest, WriteBackpressure) {
+  // 服务端不读取，客户端的Write在积压超过write_limit后等待，连接关闭时返回false
+  size_t written = 0;
+  bool write_failed = false;
+  server_conn_->SetConnectionCallback(nullptr);
+  auto client = [&]() -> net::coro::Task<> {
+    net::coro::Connection conn(client_conn_);
+    client_conn_->Establish();
+    conn.SetWriteLimit(4096);
+    std::string chunk(64 * 1024, 'x');
+    while (co_await conn.Write(chunk)) {
+      written += chunk.size();
+    }
+    write_failed = true;
+    reactor_->Stop();
+  };
+  reactor_->SubmitTask([&] {
+    server_conn_->Establish();
+    server_conn_->PauseReading();
+    net::coro::Spawn(client());
+  });
+  reactor_->AddTimerAfter(50ms, [this] {
+    // 此时客户端应当阻塞在Write上
+    client_conn_->ForceClose();
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  EXPECT_TRUE(write_failed);
+  EXPECT_LT(written, 64 * 1024 * 1024);
+  server_conn_->ForceClose();
+}
+
+TEST(CoroConnectTest, ConnectRefusedAndSucceeded) {
+  auto reactor = std::make_unique<net::Reactor>();
+  // 监听但不accept，连接会在backlog中完成
+  int listen_fd = net::NewTcpSocketFd();
+  net::Bind(listen_fd, net::InetAddress("127.0.0.1", 0));
+  net::Listen(listen_fd);
+  net::InetAddress listen_addr = net::GetLocalAddr(listen_fd);
+  int closed_fd = net::NewTcpSocketFd();
+  net::Bind(closed_fd, net::InetAddress("127.0.0.1", 0));
+  net::InetAddress closed_addr = net::GetLocalAddr(closed_fd);  // 绑定但未监听的端口会拒绝连接
+
+  bool refused = false;
+  bool connected = false;
+  net::coro::Spawn([&]() -> net::coro::Task<> {
+    net::coro::Connection failed = co_await net::coro::Connect(reactor.get(), closed_addr);
+    refused = !failed;
+    net::coro::Connection conn = co_await net::coro::Connect(reactor.get(), listen_addr);
+    EXPECT_TRUE(reactor->InCurrentReactorThread());
+    connected = conn.Connected();
+    conn.GetConnection()->ForceClose();
+    reactor->Stop();
+  }());
+  reactor->AddTimerAfter(5s, [&] { reactor->Stop(); });
+  reactor->Run();
+  EXPECT_TRUE(refused);
+  EXPECT_TRUE(connected);
+  net::Close(listen_fd);
+  net::Close(closed_fd);
+}
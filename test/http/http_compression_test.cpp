@@ -0,0 +1,116 @@
+#include <net/http/http_compression.hpp>
+
+#include "net_test.hpp"
+
+/// 解压gzip或deflate(zlib格式)
+static std::string Decompress(std::string_view data) {
+  z_stream zs{};
+  inflateInit2(&zs, 15 + 32);  // 自动识别gzip与zlib格式
+  std::string out(1024 * 1024, '\0');
+  zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+  zs.avail_in = data.size();
+  zs.next_out = reinterpret_cast<Bytef *>(out.data());
+  zs.avail_out = out.size();
+  int ret = inflate(&zs, Z_FINISH);
+  out.resize(ret == Z_STREAM_END ? zs.total_out : 0);
+  inflateEnd(&zs);
+  return out;
+}
+
+static std::string MakeText(size_t size) {
+  std::string text;
+  for (int i = 0; text.size() < size; ++i) {
+    text += "line " + std::to_string(i % 100) + "\n";
+  }
+  text.resize(size);
+  return text;
+}
+
+TEST(HttpCompressionTest, EncodingWeight) {
+  EXPECT_EQ(net::GetEncodingWeight("gzip, deflate, br", "gzip"), 1000);
+  EXPECT_EQ(net::GetEncodingWeight("gzip, deflate, br", "br"), 1000);
+  EXPECT_EQ(net::GetEncodingWeight("deflate;q=0.5, GZIP ; q=0.25", "gzip"), 250);
+  EXPECT_EQ(net::GetEncodingWeight("deflate;q=0.5, gzip;q=0.25", "deflate"), 500);
+  EXPECT_EQ(net::GetEncodingWeight("gzip;q=0", "gzip"), 0);
+  EXPECT_EQ(net::GetEncodingWeight("gzip;q=1.0", "gzip"), 1000);
+  EXPECT_EQ(net::GetEncodingWeight("identity", "gzip"), 0);
+  EXPECT_EQ(net::GetEncodingWeight("", "gzip"), 0);
+  // 没有列出的编码使用"*"的权重
+  EXPECT_EQ(net::GetEncodingWeight("br, *;q=0.1", "gzip"), 100);
+  EXPECT_EQ(net::GetEncodingWeight("gzip;q=0, *", "gzip"), 0);
+}
+
+TEST(HttpCompressionTest, Compress) {
+  std::string text = MakeText(100 * 1024);
+  for (auto coding: {net::HttpContentCoding::Gzip, net::HttpContentCoding::Deflate}) {
+    std::string compressed;
+    ASSERT_TRUE(net::Compress(coding, text, 6, &compressed));
+    EXPECT_LT(compressed.size(), text.size() / 10);
+    EXPECT_EQ(Decompress(compressed), text);
+  }
+  std::string compressed;
+  ASSERT_TRUE(net::Compress(net::HttpContentCoding::Gzip, "", 6, &compressed));
+  EXPECT_EQ(compressed.substr(0, 2), "\x1f\x8b");
+  EXPECT_EQ(Decompress(compressed), "");
+}
+
+TEST(HttpCompressionTest, Cache) {
+  net::HttpCompressionCache cache(100);
+  auto value = [](size_t size) { return std::make_shared<const std::string>(size, 'x'); };
+  cache.Put(net::HttpContentCoding::Gzip, "a", value(40));
+  cache.Put(net::HttpContentCoding::Gzip, "b", value(40));
+  // 总字节数包括用于校验的原始内容
+  EXPECT_EQ(cache.Size(), 82);
+  EXPECT_TRUE(cache.Get(net::HttpContentCoding::Gzip, "a"));
+  EXPECT_FALSE(cache.Get(net::HttpContentCoding::Deflate, "a"));
+  EXPECT_FALSE(cache.Get(net::HttpContentCoding::Gzip, "e"));
+  // 超过总字节数时淘汰最久未使用的
+  cache.Put(net::HttpContentCoding::Gzip, "c", value(40));
+  EXPECT_EQ(cache.Size(), 82);
+  EXPECT_TRUE(cache.Get(net::HttpContentCoding::Gzip, "a"));
+  EXPECT_FALSE(cache.Get(net::HttpContentCoding::Gzip, "b"));
+  EXPECT_TRUE(cache.Get(net::HttpContentCoding::Gzip, "c"));
+  // 超过容量的结果不缓存
+  cache.Put(net::HttpContentCoding::Gzip, "d", value(100));
+  EXPECT_FALSE(cache.Get(net::HttpContentCoding::Gzip, "d"));
+}
+
+TEST(HttpCompressionTest, Negotiate) {
+  net::HttpCompressor compressor;
+  net::HttpRequest request;
+  request.GetMutableHeaders().Add("Accept-Encoding", "deflate;q=0.8, gzip");
+  auto make_reply = [](std::string_view content_type, size_t size) {
+    net::HttpReply reply;
+    reply.SetStatusCode(net::HttpStatusCode::k200Ok);
+    reply.SetContentType(content_type);
+    reply.SetContent(MakeText(size));
+    return reply;
+  };
+
+  net::HttpReply reply = make_reply("text/html; charset=utf-8", 1024);
+  reply.SetHeader(net::HttpHeaderId::ETag, "\"v1\"");
+  reply.SetHeader(net::HttpHeaderId::Vary, "Cookie");
+  EXPECT_EQ(compressor.Negotiate(request, reply), net::HttpContentCoding::Gzip);
+  EXPECT_EQ(reply.GetHeader(net::HttpHeaderId::Vary), "Cookie, Accept-Encoding");
+  ASSERT_TRUE(compressor.TryCompress(net::HttpContentCoding::Gzip, reply));
+  EXPECT_EQ(reply.GetHeader(net::HttpHeaderId::ContentEncoding), "gzip");
+  EXPECT_EQ(reply.GetHeader(net::HttpHeaderId::ETag), "\"v1-gzip\"");
+  EXPECT_EQ(Decompress(reply.GetContent()), MakeText(1024));
+  EXPECT_GT(compressor.GetCache().Size(), 0);
+
+  // 已经压缩的类型、过小的应答体、错误状态不压缩
+  net::HttpReply image = make_reply("image/png", 1024);
+  EXPECT_EQ(compressor.Negotiate(request, image), net::HttpContentCoding::Identity);
+  EXPECT_FALSE(image.HasHeader(net::HttpHeaderId::Vary));
+  net::HttpReply small = make_reply("text/plain", 100);
+  EXPECT_EQ(compressor.Negotiate(request, small), net::HttpContentCoding::Identity);
+  net::HttpReply error = make_reply("text/plain", 1024);
+  error.SetStatusCode(net::HttpStatusCode::k404NotFound);
+  EXPECT_EQ(compressor.Negotiate(request, error), net::HttpContentCoding::Identity);
+
+  // 客户端不接受压缩时仍然需要Vary
+  net::HttpRequest plain_request;
+  net::HttpReply plain = make_reply("application/json", 1024);
+  EXPECT_EQ(compressor.Negotiate(plain_request, plain), net::HttpContentCoding::Identity);
+  EXPECT_EQ(plain.GetHeader(net::HttpHeaderId::Vary), "Accept-Encoding");
+}
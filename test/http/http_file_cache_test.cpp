@@ -0,0 +1,123 @@
+#include <net/http/http_file_cache.hpp>
+
+#include "net_test.hpp"
+
+#include <fstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+class HttpFileCacheTest : public testing::Test {
+ public:
+  HttpFileCacheTest() {
+    char dir[] = "/tmp/net_file_cache_XXXXXX";
+    dir_ = ::mkdtemp(dir);
+  }
+  ~HttpFileCacheTest() override {
+    fs::remove_all(dir_);
+  }
+
+  void WriteFile(const std::string &name, std::string_view content) const {
+    std::ofstream ofs(dir_ + "/" + name, std::ios::binary | std::ios::trunc);
+    ofs << content;
+  }
+
+  /// 等待后台线程处理inotify事件，使path从缓存中移除
+  static bool WaitInvalidated(net::HttpFileCache &cache, size_t size) {
+    for (int i = 0; i < 1000 && cache.Size() != size; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return cache.Size() == size;
+  }
+
+  std::string dir_;
+};
+
+TEST_F(HttpFileCacheTest, Open) {
+  WriteFile("a.html", "hello");
+  fs::create_directory(dir_ + "/sub");
+  net::HttpFileCache cache;
+  auto file = cache.Open(dir_ + "/a.html");
+  ASSERT_TRUE(file);
+  EXPECT_GE(file->fd, 0);
+  EXPECT_EQ(file->size, 5);
+  EXPECT_EQ(file->content_type, net::ToMimeType(".html"));
+  // 再次打开时命中缓存，返回同一个文件
+  EXPECT_EQ(cache.Open(dir_ + "/a.html"), file);
+  EXPECT_EQ(cache.Size(), 1);
+  // 不存在的文件与目录不缓存
+  EXPECT_FALSE(cache.Open(dir_ + "/b.html"));
+  EXPECT_FALSE(cache.Open(dir_ + "/sub"));
+  EXPECT_EQ(cache.Size(), 1);
+}
+
+TEST_F(HttpFileCacheTest, Capacity) {
+  net::HttpFileCache cache(16);
+  for (int i = 0; i < 100; ++i) {
+    WriteFile(std::to_string(i), "x");
+    ASSERT_TRUE(cache.Open(dir_ + "/" + std::to_string(i)));
+  }
+  EXPECT_LE(cache.Size(), 16);
+}
+
+TEST_F(HttpFileCacheTest, Invalidate) {
+  WriteFile("a.txt", "hello");
+  WriteFile("b.txt", "b");
+  net::HttpFileCache cache;
+  auto old_file = cache.Open(dir_ + "/a.txt");
+  ASSERT_TRUE(old_file);
+  ASSERT_TRUE(cache.Open(dir_ + "/b.txt"));
+  // 修改文件之后从缓存中移除，重新打开时得到新的元数据
+  WriteFile("a.txt", "hello, world");
+  ASSERT_TRUE(WaitInvalidated(cache, 1));
+  auto new_file = cache.Open(dir_ + "/a.txt");
+  ASSERT_TRUE(new_file);
+  EXPECT_NE(new_file, old_file);
+  EXPECT_EQ(new_file->size, 12);
+  EXPECT_GE(old_file->fd, 0);  // 仍然持有的旧文件不受影响
+  // 删除文件
+  fs::remove(dir_ + "/b.txt");
+  ASSERT_TRUE(WaitInvalidated(cache, 1));
+  EXPECT_FALSE(cache.Open(dir_ + "/b.txt"));
+  // 通过rename原子地替换文件
+  WriteFile("c.tmp", "replaced");
+  fs::rename(dir_ + "/c.tmp", dir_ + "/a.txt");
+  ASSERT_TRUE(WaitInvalidated(cache, 0));
+  EXPECT_EQ(cache.Open(dir_ + "/a.txt")->size, 8);
+}
+
+TEST_F(HttpFileCacheTest, DirAlias) {
+  WriteFile("a.txt", "hello");
+  net::HttpFileCache cache;
+  auto file = cache.Open(dir_ + "/a.txt");
+  ASSERT_TRUE(file);
+  // 同一个目录的另一种写法不能替换已有的监视，两种写法下的缓存都会失效
+  auto alias = cache.Open(dir_ + "/./a.txt");
+  ASSERT_TRUE(alias);
+  EXPECT_EQ(cache.Size(), 2);
+  WriteFile("c.tmp", "replaced");
+  fs::rename(dir_ + "/c.tmp", dir_ + "/a.txt");
+  ASSERT_TRUE(WaitInvalidated(cache, 0));
+  auto new_file = cache.Open(dir_ + "/a.txt");
+  ASSERT_TRUE(new_file);
+  EXPECT_NE(new_file, file);
+  EXPECT_EQ(new_file->size, 8);
+  EXPECT_EQ(cache.Open(dir_ + "/./a.txt")->size, 8);
+}
+
+TEST_F(HttpFileCacheTest, Precompressed) {
+  WriteFile("app.js", "plain");
+  WriteFile("app.js.gz", "gzipped");
+  net::HttpFileCache cache;
+  auto file = cache.Open(dir_ + "/app.js");
+  ASSERT_TRUE(file);
+  ASSERT_TRUE(file->gzip);
+  EXPECT_EQ(file->gzip->size, 7);
+  EXPECT_FALSE(file->brotli);
+  // 预压缩文件的变化使原文件失效，重新打开时重新查找
+  fs::remove(dir_ + "/app.js.gz");
+  ASSERT_TRUE(WaitInvalidated(cache, 0));
+  file = cache.Open(dir_ + "/app.js");
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(file->gzip);
+}
@@ -0,0 +1,55 @@
+#include <net/http/http_header.hpp>
+
+#include "net_test.hpp"
+
+class HttpHeaderTest : public testing::Test {};
+
+TEST_F(HttpHeaderTest, ToHttpHeaderId) {
+  for (size_t i = 1; i < net::kHttpHeaderIdNum; ++i) {
+    auto id = static_cast<net::HttpHeaderId>(i);
+    std::string name(net::ToString(id));
+    EXPECT_EQ(net::ToHttpHeaderId(name), id) << name;
+    std::string lower = name;
+    std::string upper = name;
+    for (auto &c: lower) c = static_cast<char>(std::tolower(c));
+    for (auto &c: upper) c = static_cast<char>(std::toupper(c));
+    EXPECT_EQ(net::ToHttpHeaderId(lower), id) << lower;
+    EXPECT_EQ(net::ToHttpHeaderId(upper), id) << upper;
+  }
+  EXPECT_EQ(net::ToHttpHeaderId(""), net::HttpHeaderId::Unknown);
+  EXPECT_EQ(net::ToHttpHeaderId("X-Request-Id"), net::HttpHeaderId::Unknown);
+  EXPECT_EQ(net::ToHttpHeaderId("Hosts"), net::HttpHeaderId::Unknown);
+  EXPECT_EQ(net::ToHttpHeaderId("Hast"), net::HttpHeaderId::Unknown);
+}
+
+TEST_F(HttpHeaderTest, HeaderMap) {
+  net::HttpHeaderMap<std::string_view> headers;
+  headers.Add("host", "localhost");
+  headers.Add("X-Custom", "1");
+  headers.Add("Content-Length", "5");
+  EXPECT_EQ(headers.Get(net::HttpHeaderId::Host), "localhost");
+  EXPECT_EQ(headers.Get("HOST"), "localhost");
+  EXPECT_EQ(headers.Get("x-custom"), "1");
+  EXPECT_EQ(headers.Get(net::HttpHeaderId::ContentLength), "5");
+  EXPECT_TRUE(headers.Has(net::HttpHeaderId::ContentLength));
+  EXPECT_FALSE(headers.Has(net::HttpHeaderId::Connection));
+  EXPECT_FALSE(headers.Has("X-Other"));
+  EXPECT_EQ(headers.Get("X-Other", "default"), "default");
+
+  // 替换不改变顺序，重复的头部查找时返回第一个
+  headers.Set("Host", "example.com");
+  headers.Add("Host", "ignored");
+  headers.Set("x-CUSTOM", "2");
+  EXPECT_EQ(headers.Get(net::HttpHeaderId::Host), "example.com");
+  EXPECT_EQ(headers.Get("X-Custom"), "2");
+  ASSERT_EQ(headers.Size(), 4);
+  EXPECT_EQ(headers.GetAll()[0].first, "host");
+  EXPECT_EQ(headers.GetAll()[3].second, "ignored");
+
+  headers.Clear();
+  EXPECT_TRUE(headers.Empty());
+  EXPECT_FALSE(headers.Has(net::HttpHeaderId::Host));
+  headers.Add("Connection", "close");
+  EXPECT_EQ(headers.Get(net::HttpHeaderId::Connection), "close");
+  EXPECT_FALSE(headers.Has(net::HttpHeaderId::Host));
+}
@@ -0,0 +1,131 @@
+#include <net/http/http_micro_cache.hpp>
+
+#include "net_test.hpp"
+
+#include <thread>
+
+using namespace std::chrono_literals;
+
+static net::HttpReply MakeReply(const std::string &content) {
+  net::HttpReply reply;
+  reply.SetVersion(net::HttpVersion::Http11);
+  reply.SetStatusCode(net::HttpStatusCode::k200Ok);
+  reply.SetContent(content);
+  return reply;
+}
+
+TEST(HttpMicroCacheTest, MakeKey) {
+  net::HttpMicroCacheOptions options;
+  options.key_headers = {"Accept-Language"};
+  net::HttpMicroCache cache(options);
+  net::HttpRequest request;
+  request.SetMethod(net::HttpMethod::Get);
+  request.SetUrl("/a?x=1");
+  request.AddHeader("Accept-Language", "en");
+  request.AddHeader("Accept-Encoding", "gzip");
+  std::string key = cache.MakeKey(request, false);
+  EXPECT_EQ(key, "GET /a?x=1\nen");
+  EXPECT_EQ(cache.MakeKey(request, true), "GET /a?x=1\nen\ngzip");
+  request.SetUrl("/a?x=2");
+  EXPECT_NE(cache.MakeKey(request, false), key);
+  request.SetMethod(net::HttpMethod::Head);
+  EXPECT_TRUE(net::HttpMicroCache::IsCacheable(request));
+  request.SetMethod(net::HttpMethod::Post);
+  EXPECT_FALSE(net::HttpMicroCache::IsCacheable(request));
+}
+
+TEST(HttpMicroCacheTest, MakeEntry) {
+  net::HttpMicroCache cache;
+  auto entry = cache.MakeEntry(MakeReply("hello"));
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(entry->bytes.substr(entry->bytes.size() - 5), "hello");
+  ASSERT_NE(entry->date_offset, std::string::npos);
+  EXPECT_EQ(entry->bytes.substr(entry->date_offset - 6, 6), "Date: ");
+  // 命中时Date替换为当前时间，长度不变
+  std::string output;
+  net::HttpMicroCache::AppendEntry(*entry, output);
+  EXPECT_EQ(output.size(), entry->bytes.size());
+  EXPECT_EQ(output.substr(entry->date_offset, net::kHttpDateSize), net::GetHttpDateNow());
+
+  net::HttpReply reply = MakeReply("hello");
+  reply.SetHeader(net::HttpHeaderId::Date, "Sun, 06 Nov 1994 08:49:37 GMT");
+  entry = cache.MakeEntry(reply);
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(entry->date_offset, std::string::npos);
+
+  reply = MakeReply("hello");
+  reply.SetStatusCode(net::HttpStatusCode::k500InternalServerError);
+  EXPECT_FALSE(cache.MakeEntry(reply));
+  reply = MakeReply("hello");
+  reply.SetHeader(net::HttpHeaderId::SetCookie, "a=b");
+  EXPECT_FALSE(cache.MakeEntry(reply));
+  reply = MakeReply("hello");
+  reply.SetHeader(net::HttpHeaderId::CacheControl, "private, max-age=60");
+  EXPECT_FALSE(cache.MakeEntry(reply));
+  reply = MakeReply("hello");
+  reply.SetHeader(net::HttpHeaderId::Connection, "close");
+  EXPECT_FALSE(cache.MakeEntry(reply));
+}
+
+TEST(HttpMicroCacheTest, Shard) {
+  net::HttpMicroCacheOptions options;
+  options.ttl = 20ms;
+  options.max_entries = 2;
+  net::HttpMicroCache cache(options);
+  net::HttpMicroCache::Shard &shard = cache.GetLocalShard();
+  EXPECT_EQ(&shard, &cache.GetLocalShard());
+  EXPECT_FALSE(shard.Find("a"));
+
+  // 生成应答期间的相同请求等待其完成
+  shard.BeginFill("a");
+  EXPECT_TRUE(shard.IsFilling("a"));
+  int woken = 0;
+  shard.AddWaiter("a", [&] { ++woken; });
+  shard.AddWaiter("a", [&] { ++woken; });
+  auto waiters = shard.EndFill("a", cache.MakeEntry(MakeReply("A")));
+  EXPECT_FALSE(shard.IsFilling("a"));
+  for (auto &waiter: waiters) waiter();
+  EXPECT_EQ(woken, 2);
+  EXPECT_TRUE(shard.Find("a"));
+
+  // 不能缓存的应答不加入缓存，但仍然唤醒等待的请求
+  shard.BeginFill("b");
+  shard.AddWaiter("b", [&] { ++woken; });
+  EXPECT_EQ(shard.EndFill("b", nullptr).size(), 1);
+  EXPECT_FALSE(shard.Find("b"));
+
+  // 超过数量上限时淘汰最久未使用的
+  shard.EndFill("b", cache.MakeEntry(MakeReply("B")));
+  shard.Find("a");
+  shard.EndFill("c", cache.MakeEntry(MakeReply("C")));
+  EXPECT_EQ(shard.Size(), 2);
+  EXPECT_TRUE(shard.Find("a"));
+  EXPECT_FALSE(shard.Find("b"));
+  EXPECT_TRUE(shard.Find("c"));
+
+  // 过期之后不再命中
+  std::this_thread::sleep_for(30ms);
+  EXPECT_FALSE(shard.Find("a"));
+  EXPECT_FALSE(shard.Find("c"));
+  EXPECT_EQ(shard.Size(), 0);
+  EXPECT_EQ(shard.Bytes(), 0);
+
+  // 每个线程有独立的分片
+  net::HttpMicroCache::Shard *other = nullptr;
+  std::thread([&] { other = &cache.GetLocalShard(); }).join();
+  EXPECT_NE(other, &shard);
+}
+
+TEST(HttpMicroCacheTest, MaxBytes) {
+  net::HttpMicroCacheOptions options;
+  options.max_bytes = 1024;
+  options.max_entry_size = 600;
+  net::HttpMicroCache cache(options);
+  net::HttpMicroCache::Shard &shard = cache.GetLocalShard();
+  EXPECT_FALSE(cache.MakeEntry(MakeReply(std::string(1000, 'x'))));
+  shard.EndFill("a", cache.MakeEntry(MakeReply(std::string(500, 'a'))));
+  shard.EndFill("b", cache.MakeEntry(MakeReply(std::string(500, 'b'))));
+  EXPECT_EQ(shard.Size(), 1);
+  EXPECT_LE(shard.Bytes(), options.max_bytes);
+  EXPECT_TRUE(shard.Find("b"));
+}
@@ -11,20 +11,286 @@ TEST_F(HttpParserTest, Success) {
                         "\r\n"
                         "12345";
   auto buffer = std::make_shared<net::Buffer>(message);
-  net::HttpRequest request;
-  EXPECT_TRUE(net::Parse(buffer, request));
+  net::HttpRequestParser parser;
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  net::HttpRequest &request = parser.GetRequest();
   EXPECT_EQ(request.GetMethod(), net::HttpMethod::Get);
   EXPECT_EQ(request.GetUrl(), "/index.html");
   EXPECT_EQ(request.GetVersion(), net::HttpVersion::Http11);
   EXPECT_EQ(request.GetHeader("Content-Type"), "application/json");
   EXPECT_EQ(request.GetHeader("Content-Length"), "5");
+  EXPECT_EQ(parser.GetHeaderSize(), message.size() - 5);
+  EXPECT_EQ(parser.GetRequestSize(), message.size());
   EXPECT_EQ(request.GetContent(), "12345");
+  // 解析器不消费buffer，请求中的字段直接指向buffer
+  EXPECT_EQ(buffer->ReadableBytes(), message.size());
+  EXPECT_EQ(request.GetUrl().data(), buffer->GetReadPtr() + 4);
 }
 
 TEST_F(HttpParserTest, Failed) {
   std::string message = "GET /index.html HTTP/1.1\r\n"
                         "12345";
   auto buffer = std::make_shared<net::Buffer>(message);
-  net::HttpRequest request;
-  EXPECT_FALSE(net::Parse(buffer, request));
+  net::HttpRequestParser parser;
+  EXPECT_NE(parser.Parse(buffer), net::HttpParseResult::Complete);
+}
+
+TEST_F(HttpParserTest, Incremental) {
+  std::string message = "GET /index.html?a=1 HTTP/1.1\r\n"
+                        "Host: localhost\r\n"
+                        "Content-Type:  application/json \r\n"
+                        "\r\n";
+  // 每次只追加一个字节，buffer会多次扩容，已解析的部分通过偏移记录，不受影响
+  auto buffer = std::make_shared<net::Buffer>(1);
+  net::HttpRequestParser parser;
+  for (size_t i = 0; i + 1 < message.size(); ++i) {
+    buffer->Append(message.substr(i, 1));
+    ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::NeedMore);
+  }
+  buffer->Append(message.substr(message.size() - 1));
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetHeaderSize(), message.size());
+  net::HttpRequest &request = parser.GetRequest();
+  EXPECT_EQ(request.GetMethod(), net::HttpMethod::Get);
+  EXPECT_EQ(request.GetUrl(), "/index.html?a=1");
+  EXPECT_EQ(request.GetRouteUrl(), "/index.html");
+  EXPECT_EQ(request.GetRawParams(), "a=1");
+  EXPECT_EQ(request.GetVersion(), net::HttpVersion::Http11);
+  EXPECT_EQ(request.GetHeader("Host"), "localhost");
+  EXPECT_EQ(request.GetHeader("Content-Type"), "application/json");
+
+  // 消费掉请求并Reset之后可以继续解析下一个请求，并且容忍只有LF的行尾
+  buffer->HasRead(parser.GetHeaderSize());
+  parser.Reset();
+  buffer->Append("POST /upload HTTP/1.0\nHost: a\n\n");
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetRequest().GetMethod(), net::HttpMethod::Post);
+  EXPECT_EQ(parser.GetRequest().GetVersion(), net::HttpVersion::Http10);
+  EXPECT_EQ(parser.GetRequest().GetHeader("Host"), "a");
+}
+
+TEST_F(HttpParserTest, PartialLine) {
+  auto buffer = std::make_shared<net::Buffer>(std::string("GET / HTTP/1.1\r\nHost: loc"));
+  net::HttpRequestParser parser;
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::NeedMore);
+  buffer->Append("alhost\r\n\r\nrest");
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetRequest().GetHeader("Host"), "localhost");
+  buffer->HasRead(parser.GetHeaderSize());
+  EXPECT_EQ(std::string(buffer->GetReadPtr(), buffer->ReadableBytes()), "rest");
+}
+
+TEST_F(HttpParserTest, DuplicateHeaders) {
+  auto buffer = std::make_shared<net::Buffer>(std::string("GET / HTTP/1.1\r\n"
+                                                          "Accept: text/html\r\n"
+                                                          "Empty:\r\n"
+                                                          "Accept: application/json\r\n"
+                                                          "\r\n"));
+  net::HttpRequestParser parser;
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  net::HttpRequest &request = parser.GetRequest();
+  EXPECT_EQ(request.GetHeader("Accept"), "text/html, application/json");
+  EXPECT_TRUE(request.HasHeader("Empty"));
+  EXPECT_EQ(request.GetHeader("Empty", "default"), "");
+  EXPECT_EQ(request.GetHeaders().size(), 2);
+  EXPECT_EQ(request.GetArena()->GetMemoryUsage(), net::Arena::kDefaultBlockSize);
+}
+
+TEST_F(HttpParserTest, HeaderCaseInsensitive) {
+  auto buffer = std::make_shared<net::Buffer>(std::string("POST / HTTP/1.1\r\n"
+                                                          "HOST: localhost\r\n"
+                                                          "content-length: 2\r\n"
+                                                          "x-trace-id: abc\r\n"
+                                                          "X-TRACE-ID: def\r\n"
+                                                          "\r\nok"));
+  net::HttpRequestParser parser;
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  net::HttpRequest &request = parser.GetRequest();
+  EXPECT_EQ(request.GetHeader(net::HttpHeaderId::Host), "localhost");
+  EXPECT_EQ(request.GetHeader("Host"), "localhost");
+  EXPECT_EQ(request.GetHeader(net::HttpHeaderId::ContentLength), "2");
+  EXPECT_EQ(request.GetContent(), "ok");
+  // 名称只有大小写不同的头部也会被合并，保留第一次出现时的写法
+  EXPECT_EQ(request.GetHeader("X-Trace-Id"), "abc, def");
+  ASSERT_EQ(request.GetHeaders().size(), 3);
+  EXPECT_EQ(request.GetHeaders()[2].first, "x-trace-id");
+}
+
+TEST_F(HttpParserTest, Pipelined) {
+  auto buffer = std::make_shared<net::Buffer>(std::string("GET /a HTTP/1.1\r\n\r\n"
+                                                          "POST /b HTTP/1.1\r\ncontent-length: 3\r\n\r\nabc"
+                                                          "GET /c HTTP/1.1\r\n\r\n"
+                                                          "POST /d HTTP/1.1\r\nContent-Length: 4\r\n\r\nxy"));
+  net::HttpRequestParser parser;
+  std::vector<std::pair<std::string, std::string>> parsed;
+  while (parser.Parse(buffer) == net::HttpParseResult::Complete) {
+    auto &request = parser.GetRequest();
+    parsed.emplace_back(request.GetUrl(), request.GetContent());
+    buffer->HasRead(parser.GetRequestSize());
+    parser.Reset();
+  }
+  ASSERT_EQ(parsed.size(), 3);
+  EXPECT_EQ(parsed[0], std::make_pair(std::string("/a"), std::string()));
+  EXPECT_EQ(parsed[1], std::make_pair(std::string("/b"), std::string("abc")));
+  EXPECT_EQ(parsed[2], std::make_pair(std::string("/c"), std::string()));
+
+  // 请求体不完整时等待更多数据，已经解析的头部不会重复解析
+  buffer->Append("zw");
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetRequest().GetUrl(), "/d");
+  EXPECT_EQ(parser.GetRequest().GetContent(), "xyzw");
+  EXPECT_EQ(parser.GetRequestSize(), buffer->ReadableBytes());
+}
+
+TEST_F(HttpParserTest, ChunkedBody) {
+  std::string message = "POST /upload HTTP/1.1\r\n"
+                        "Transfer-Encoding: chunked\r\n"
+                        "\r\n"
+                        "5;ext=1\r\nhello\r\n"
+                        "7\r\n, world\r\n"
+                        "0\r\n"
+                        "Trailer: value\r\n"
+                        "\r\n";
+  // 逐字节到达，请求体在buffer中原地解码为连续的数据
+  auto buffer = std::make_shared<net::Buffer>(1);
+  net::HttpRequestParser parser;
+  for (size_t i = 0; i + 1 < message.size(); ++i) {
+    buffer->Append(message.substr(i, 1));
+    ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::NeedMore) << i;
+  }
+  buffer->Append(message.substr(message.size() - 1) + "GET /next HTTP/1.1\r\n\r\n");
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetRequest().GetUrl(), "/upload");
+  EXPECT_EQ(parser.GetRequest().GetContent(), "hello, world");
+  EXPECT_EQ(parser.GetRequestSize(), message.size());
+
+  buffer->HasRead(parser.GetRequestSize());
+  parser.Reset();
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetRequest().GetUrl(), "/next");
+  EXPECT_EQ(parser.GetRequest().GetContent(), "");
+}
+
+TEST_F(HttpParserTest, MaxBodySize) {
+  for (std::string message: {"POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n",
+                             "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nhello \r\n5\r\n"}) {
+    auto buffer = std::make_shared<net::Buffer>(message);
+    net::HttpRequestParser parser(net::HttpRequestParser::kDefaultMaxHeaderSize, 10);
+    EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Error) << message;
+    EXPECT_EQ(parser.GetErrorStatus(), net::HttpStatusCode::k413PayloadTooLarge);
+  }
+  // 恰好等于上限的请求体是允许的
+  auto buffer = std::make_shared<net::Buffer>(std::string("POST / HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123456789"));
+  net::HttpRequestParser parser(net::HttpRequestParser::kDefaultMaxHeaderSize, 10);
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+}
+
+TEST_F(HttpParserTest, ChunkedOverhead) {
+  // 尾部头部与请求头共同受max_header_size的限制
+  net::HttpRequestParser parser(256);
+  auto buffer = std::make_shared<net::Buffer>(
+      std::string("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n"));
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::NeedMore);
+  net::HttpParseResult result = net::HttpParseResult::NeedMore;
+  for (int i = 0; i < 100 && result == net::HttpParseResult::NeedMore; ++i) {
+    buffer->Append("X-Pad: " + std::string(40, 'x') + "\r\n");
+    result = parser.Parse(buffer);
+  }
+  EXPECT_EQ(result, net::HttpParseResult::Error);
+  EXPECT_EQ(parser.GetErrorStatus(), net::HttpStatusCode::k431RequestHeaderFieldsTooLarge);
+  EXPECT_LT(buffer->ReadableBytes(), 512);
+
+  // 不超过限制的尾部头部被忽略
+  parser.Reset();
+  buffer = std::make_shared<net::Buffer>(
+      std::string("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\nX-Pad: x\r\n\r\n"));
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(parser.GetRequest().GetContent(), "hello");
+
+  // 数据块的分隔(例如很长的chunk-ext)不能超过max_body_size
+  net::HttpRequestParser small_body(net::HttpRequestParser::kDefaultMaxHeaderSize, 100);
+  buffer = std::make_shared<net::Buffer>(std::string("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"));
+  result = small_body.Parse(buffer);
+  for (int i = 0; i < 100 && result == net::HttpParseResult::NeedMore; ++i) {
+    buffer->Append("1;ext=" + std::string(40, 'x') + "\r\na\r\n");
+    result = small_body.Parse(buffer);
+  }
+  EXPECT_EQ(result, net::HttpParseResult::Error);
+  EXPECT_EQ(small_body.GetErrorStatus(), net::HttpStatusCode::k413PayloadTooLarge);
+}
+
+TEST_F(HttpParserTest, StreamingBody) {
+  net::HttpRequestParser parser;
+  std::string received;
+  std::string_view content_type;
+  parser.SetHeaderCallback([&](const net::HttpRequest &request) -> net::HttpRequestParser::BodyCallback {
+    if (request.GetRouteUrl() != "/stream") return nullptr;
+    content_type = request.GetHeader("Content-Type");
+    return [&](std::string_view data) { received.append(data); };
+  });
+
+  auto buffer = std::make_shared<net::Buffer>(std::string("POST /stream HTTP/1.1\r\n"
+                                                          "Content-Type: text/plain\r\n"
+                                                          "Transfer-Encoding: chunked\r\n"
+                                                          "\r\n"
+                                                          "4\r\nabcd\r\n3\r\nef"));
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::NeedMore);
+  EXPECT_TRUE(parser.IsStreaming());
+  EXPECT_EQ(received, "abcdef");
+  // 已经交付的数据从buffer中消费，请求头被复制到Arena中，之后仍然有效
+  EXPECT_EQ(buffer->ReadableBytes(), 0);
+  buffer->Append(std::string(100, 'x'));
+  EXPECT_EQ(content_type, "text/plain");
+  EXPECT_EQ(parser.GetRequest().GetHeader("Content-Type"), "text/plain");
+
+  buffer->Reset();
+  buffer->Append("g\r\n0\r\n\r\nGET / HTTP/1.1\r\n\r\n");
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_EQ(received, "abcdefg");
+  EXPECT_EQ(parser.GetRequest().GetUrl(), "/stream");
+  EXPECT_EQ(parser.GetRequest().GetContent(), "");
+  EXPECT_EQ(parser.GetRequestSize(), 0);
+
+  // 没有返回BodyCallback的请求仍然缓存请求体
+  parser.Reset();
+  ASSERT_EQ(parser.Parse(buffer), net::HttpParseResult::Complete);
+  EXPECT_FALSE(parser.IsStreaming());
+  EXPECT_EQ(parser.GetRequestSize(), buffer->ReadableBytes());
+}
+
+TEST_F(HttpParserTest, Error) {
+  for (std::string message: {"GET /index.html\r\n",
+                             "FOO / HTTP/1.1\r\n",
+                             "GET / HTTP/2.5\r\n",
+                             "GET  HTTP/1.1\r\n",
+                             "GET / HTTP/1.1\r\nNoColon\r\n",
+                             "GET / HTTP/1.1\r\nKey : value\r\n",
+                             "POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+                             "POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n"}) {
+    auto buffer = std::make_shared<net::Buffer>(message);
+    net::HttpRequestParser parser;
+    EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Error) << message;
+    EXPECT_EQ(parser.GetErrorStatus(), net::HttpStatusCode::k400BadRequest);
+  }
+  for (std::string message: {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n",
+                             "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n",
+                             "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n"}) {
+    auto buffer = std::make_shared<net::Buffer>(message);
+    net::HttpRequestParser parser;
+    EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Error) << message;
+    EXPECT_EQ(parser.GetErrorStatus(), net::HttpStatusCode::k400BadRequest);
+  }
+  auto buffer = std::make_shared<net::Buffer>(std::string("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n"));
+  net::HttpRequestParser parser;
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Error);
+  EXPECT_EQ(parser.GetErrorStatus(), net::HttpStatusCode::k501NotImplemented);
+}
+
+TEST_F(HttpParserTest, HeaderTooLarge) {
+  net::HttpRequestParser parser(64);
+  auto buffer = std::make_shared<net::Buffer>(std::string("GET / HTTP/1.1\r\n"));
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::NeedMore);
+  buffer->Append(std::string(100, 'x'));  // 没有行尾的超长头部
+  EXPECT_EQ(parser.Parse(buffer), net::HttpParseResult::Error);
+  EXPECT_EQ(parser.GetErrorStatus(), net::HttpStatusCode::k431RequestHeaderFieldsTooLarge);
 }
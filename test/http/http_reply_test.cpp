@@ -0,0 +1,95 @@
+#include <net/http/http_reply.hpp>
+
+#include "net_test.hpp"
+
+class HttpReplyTest : public testing::Test {};
+
+TEST_F(HttpReplyTest, FormatHttpDate) {
+  char buf[net::kHttpDateSize];
+  EXPECT_EQ(net::FormatHttpDate(784111777, buf), "Sun, 06 Nov 1994 08:49:37 GMT");
+  EXPECT_EQ(net::FormatHttpDate(0, buf), "Thu, 01 Jan 1970 00:00:00 GMT");
+  EXPECT_EQ(net::GetHttpDateNow().size(), net::kHttpDateSize);
+  EXPECT_EQ(net::GetHttpDateNow().substr(25), " GMT");
+}
+
+TEST_F(HttpReplyTest, ParseHttpDate) {
+  time_t t = 0;
+  EXPECT_TRUE(net::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", &t));
+  EXPECT_EQ(t, 784111777);
+  char buf[net::kHttpDateSize];
+  EXPECT_TRUE(net::ParseHttpDate(net::FormatHttpDate(1700000000, buf), &t));
+  EXPECT_EQ(t, 1700000000);
+  EXPECT_FALSE(net::ParseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT", &t));
+  EXPECT_FALSE(net::ParseHttpDate("Sun Nov  6 08:49:37 1994", &t));
+  EXPECT_FALSE(net::ParseHttpDate("Sun, 06 Xyz 1994 08:49:37 GMT", &t));
+  EXPECT_FALSE(net::ParseHttpDate("Sun, 06 Nov 1994 08:4a:37 GMT", &t));
+}
+
+TEST_F(HttpReplyTest, StatusLine) {
+  EXPECT_EQ(net::GetStatusLine(net::HttpVersion::Http11, net::HttpStatusCode::k200Ok), "HTTP/1.1 200 OK\r\n");
+  EXPECT_EQ(net::GetStatusLine(net::HttpVersion::Http10, net::HttpStatusCode::k404NotFound),
+            "HTTP/1.0 404 Not Found\r\n");
+  // 相同的状态行返回同一个预先生成的字符串
+  EXPECT_EQ(net::GetStatusLine(net::HttpVersion::Http11, net::HttpStatusCode::k500InternalServerError).data(),
+            net::GetStatusLine(net::HttpVersion::Http11, net::HttpStatusCode::k500InternalServerError).data());
+  EXPECT_EQ(net::GetStatusLine(net::HttpVersion::Http11, static_cast<net::HttpStatusCode>(418)), "HTTP/1.1 418 \r\n");
+}
+
+TEST_F(HttpReplyTest, Serialize) {
+  net::HttpReply reply;
+  reply.SetVersion(net::HttpVersion::Http11);
+  reply.SetStatusCode(net::HttpStatusCode::k200Ok);
+  reply.SetContentType("text/plain");
+  reply.SetHeader(net::kContentLengthField, "100");  // 被实际的长度替换
+  reply.SetContent("hello");
+  std::string str = reply.SerializedToString();
+  // 自动添加当前时间的Date头部
+  size_t date_pos = str.find("Date: ");
+  ASSERT_NE(date_pos, std::string::npos);
+  std::string date = str.substr(date_pos + 6, net::kHttpDateSize);
+  EXPECT_EQ(str, "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/plain\r\n"
+                 "Date: " + date + "\r\n"
+                 "Content-Length: 5\r\n"
+                 "\r\n"
+                 "hello");
+
+  // 追加到已有的数据之后，与序列化到Buffer的结果一致
+  std::string output = "prev";
+  reply.SerializeTo(output);
+  EXPECT_EQ(output, "prev" + str);
+  auto buffer = std::make_shared<net::Buffer>();
+  reply.SerializedToString(buffer);
+  EXPECT_EQ(std::string(buffer->GetReadPtr(), buffer->ReadableBytes()), str);
+
+  // 设置了Date时不再添加
+  reply.SetHeader("date", "Sun, 06 Nov 1994 08:49:37 GMT");
+  str = reply.SerializedToString();
+  EXPECT_EQ(str.find("Date: "), std::string::npos);
+  EXPECT_NE(str.find("date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"), std::string::npos);
+}
+
+TEST_F(HttpReplyTest, SerializeChunked) {
+  net::HttpReply reply;
+  reply.SetVersion(net::HttpVersion::Http11);
+  reply.SetStatusCode(net::HttpStatusCode::k200Ok);
+  reply.SetContent("ignored");
+  reply.BeginChunked();
+  std::string str = reply.SerializedToString();
+  EXPECT_EQ(str.find(net::kContentLengthField), std::string::npos);
+  EXPECT_EQ(str.substr(str.size() - 4), "\r\n\r\n");
+}
+
+TEST_F(HttpReplyTest, SerializeNotModified) {
+  net::HttpReply reply;
+  reply.SetVersion(net::HttpVersion::Http11);
+  reply.SetStatusCode(net::HttpStatusCode::k304NotModified);
+  reply.SetHeader(net::HttpHeaderId::ETag, "\"1\"");
+  reply.SetContent("ignored");
+  std::string str = reply.SerializedToString();
+  // 304没有应答体，也不发送Content-Length
+  EXPECT_EQ(str.substr(0, 29), "HTTP/1.1 304 Not Modified\r\nET");
+  EXPECT_EQ(str.find(net::kContentLengthField), std::string::npos);
+  EXPECT_EQ(str.substr(str.size() - 4), "\r\n\r\n");
+  EXPECT_FALSE(reply.HasContent());
+}
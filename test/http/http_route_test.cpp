@@ -0,0 +1,164 @@
+#include <net/http/http_route.hpp>
+
+#include "net_test.hpp"
+
+class HttpRouteTest : public testing::Test {
+ public:
+  /// 为每个路由注册一个返回路由本身的处理函数
+  void Register(const std::string &path) {
+    route_.RegisterHandler(path, [path](const net::HttpRequest &, net::HttpReply &reply) {
+      reply.SetContent(path);
+    });
+  }
+  void Register(net::HttpMethod method, const std::string &path) {
+    route_.RegisterHandler(method, path, [path, method](const net::HttpRequest &, net::HttpReply &reply) {
+      reply.SetContent(std::string(net::ToString(method)) + " " + path);
+    });
+  }
+
+  /// @return 匹配到的路由，没有匹配时返回空字符串
+  std::string Lookup(std::string_view path, net::HttpMethod method = net::HttpMethod::Get) {
+    params_.clear();
+    net::HttpHandler *handler = route_.GetHandler(method, path, &params_);
+    if (!handler) return "";
+    net::HttpRequest request;
+    net::HttpReply reply;
+    handler->handle(request, reply);
+    return reply.GetContent();
+  }
+
+  std::string_view Param(std::string_view name) {
+    for (auto &[k, v]: params_) {
+      if (k == name) return v;
+    }
+    return "<none>";
+  }
+
+  net::HttpRoute route_;
+  net::HttpRoute::PathParams params_;
+};
+
+TEST_F(HttpRouteTest, Static) {
+  Register("/a");
+  Register("/ab");
+  Register("/abc/d");
+  Register("/b");
+  EXPECT_EQ(Lookup("/a"), "/a");
+  EXPECT_EQ(Lookup("/ab"), "/ab");
+  EXPECT_EQ(Lookup("/abc/d"), "/abc/d");
+  EXPECT_EQ(Lookup("/b"), "/b");
+  EXPECT_EQ(Lookup("/abc"), "");
+  EXPECT_EQ(Lookup("/a/"), "");
+  EXPECT_EQ(Lookup("/c"), "");
+  EXPECT_EQ(Lookup(""), "");
+  // 后注册的处理函数替换之前的
+  route_.RegisterHandler("/a", [](const net::HttpRequest &, net::HttpReply &reply) { reply.SetContent("new"); });
+  EXPECT_EQ(Lookup("/a"), "new");
+  EXPECT_EQ(Lookup("/ab"), "/ab");
+}
+
+TEST_F(HttpRouteTest, Param) {
+  Register("/users/:id");
+  Register("/users/:id/posts/:post_id");
+  Register("/users/new");
+  EXPECT_EQ(Lookup("/users/42"), "/users/:id");
+  EXPECT_EQ(Param("id"), "42");
+  EXPECT_EQ(Lookup("/users/42/posts/7"), "/users/:id/posts/:post_id");
+  EXPECT_EQ(Param("id"), "42");
+  EXPECT_EQ(Param("post_id"), "7");
+  // 静态文本优先于参数
+  EXPECT_EQ(Lookup("/users/new"), "/users/new");
+  EXPECT_TRUE(params_.empty());
+  // 参数不能为空，也不能跨越'/'
+  EXPECT_EQ(Lookup("/users/"), "");
+  EXPECT_EQ(Lookup("/users/42/"), "");
+  EXPECT_EQ(Lookup("/users/42/posts"), "");
+  EXPECT_TRUE(params_.empty());
+}
+
+TEST_F(HttpRouteTest, Backtracking) {
+  Register("/files/new/edit");
+  Register("/files/:name");
+  // "new"先匹配静态文本，后续不匹配时回溯到参数
+  EXPECT_EQ(Lookup("/files/new"), "/files/:name");
+  EXPECT_EQ(Param("name"), "new");
+  EXPECT_EQ(Lookup("/files/new/edit"), "/files/new/edit");
+  EXPECT_EQ(Lookup("/files/newer"), "/files/:name");
+  EXPECT_EQ(Param("name"), "newer");
+}
+
+TEST_F(HttpRouteTest, CatchAll) {
+  Register("/static/*path");
+  Register("/static/index.html");
+  EXPECT_EQ(Lookup("/static/css/main.css"), "/static/*path");
+  EXPECT_EQ(Param("path"), "css/main.css");
+  EXPECT_EQ(Lookup("/static/"), "/static/*path");
+  EXPECT_EQ(Param("path"), "");
+  EXPECT_EQ(Lookup("/static/index.html"), "/static/index.html");
+  EXPECT_EQ(Lookup("/static"), "");
+}
+
+TEST_F(HttpRouteTest, Subtree) {
+  Register("/");
+  Register("/api/");
+  Register("/api/users");
+  EXPECT_EQ(Lookup("/"), "/");
+  EXPECT_EQ(Lookup("/index.html"), "/");
+  EXPECT_EQ(Lookup("/api"), "/");
+  EXPECT_EQ(Lookup("/api/"), "/api/");
+  EXPECT_EQ(Lookup("/api/items/1"), "/api/");
+  EXPECT_EQ(Lookup("/api/users"), "/api/users");
+  EXPECT_EQ(Lookup("/api/users/1"), "/api/");
+  // 以'/'结尾的路由的参数没有名字
+  EXPECT_TRUE(params_.empty());
+}
+
+TEST_F(HttpRouteTest, Method) {
+  Register(net::HttpMethod::Get, "/items/:id");
+  Register(net::HttpMethod::Delete, "/items/:id");
+  Register("/any");
+  Register(net::HttpMethod::Post, "/any");
+  EXPECT_EQ(Lookup("/items/1", net::HttpMethod::Get), "GET /items/:id");
+  EXPECT_EQ(Lookup("/items/1", net::HttpMethod::Delete), "DELETE /items/:id");
+  EXPECT_EQ(Param("id"), "1");
+  EXPECT_EQ(Lookup("/items/1", net::HttpMethod::Put), "");
+  EXPECT_TRUE(params_.empty());
+  EXPECT_EQ(route_.GetAllowedMethods("/items/1"), "GET, DELETE");
+  EXPECT_EQ(route_.GetAllowedMethods("/items"), "");
+  // 指定方法的处理函数优先，其他方法由不指定方法的处理函数处理
+  EXPECT_EQ(Lookup("/any", net::HttpMethod::Post), "POST /any");
+  EXPECT_EQ(Lookup("/any", net::HttpMethod::Put), "/any");
+}
+
+TEST_F(HttpRouteTest, MethodBacktracking) {
+  Register(net::HttpMethod::Get, "/users/new");
+  Register(net::HttpMethod::Delete, "/users/:id");
+  Register(net::HttpMethod::Post, "/files/*path");
+  Register(net::HttpMethod::Get, "/files/:name");
+  EXPECT_EQ(Lookup("/users/new", net::HttpMethod::Get), "GET /users/new");
+  EXPECT_TRUE(params_.empty());
+  // 静态路由没有该方法的处理函数时，回溯到参数
+  EXPECT_EQ(Lookup("/users/new", net::HttpMethod::Delete), "DELETE /users/:id");
+  EXPECT_EQ(Param("id"), "new");
+  EXPECT_EQ(Lookup("/users/new", net::HttpMethod::Put), "");
+  EXPECT_TRUE(params_.empty());
+  EXPECT_EQ(route_.GetAllowedMethods("/users/new"), "GET, DELETE");
+  EXPECT_EQ(route_.GetAllowedMethods("/users/42"), "DELETE");
+  // 参数没有该方法的处理函数时，回溯到"*name"
+  EXPECT_EQ(Lookup("/files/a.txt", net::HttpMethod::Post), "POST /files/*path");
+  EXPECT_EQ(Param("path"), "a.txt");
+  EXPECT_EQ(Param("name"), "<none>");
+  EXPECT_EQ(route_.GetAllowedMethods("/files/a.txt"), "GET, POST");
+}
+
+TEST_F(HttpRouteTest, ManyRoutes) {
+  for (int i = 0; i < 1000; ++i) {
+    Register("/api/v" + std::to_string(i % 10) + "/resource" + std::to_string(i) + "/:id");
+  }
+  for (int i = 0; i < 1000; ++i) {
+    std::string prefix = "/api/v" + std::to_string(i % 10) + "/resource" + std::to_string(i);
+    ASSERT_EQ(Lookup(prefix + "/" + std::to_string(i * 7)), prefix + "/:id");
+    ASSERT_EQ(Param("id"), std::to_string(i * 7));
+  }
+  EXPECT_EQ(Lookup("/api/v1/resource1000/1"), "");
+}
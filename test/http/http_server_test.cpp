@@ -0,0 +1,829 @@
+#include <net/http/http_file_server.hpp>
+#include <net/http/http_server.hpp>
+
+#include "net_test.hpp"
+
+#include <sys/socket.h>
+
+#include <fstream>
+#include <future>
+
+using namespace std::chrono_literals;
+
+/// 通过socketpair将服务端连接交给HttpServer处理，测试线程直接读写客户端的fd
+class HttpServerTest : public testing::Test {
+ public:
+  HttpServerTest()
+      : reactor_(new net::Reactor),
+        server_(std::make_unique<net::HttpServer>(reactor_.get(), net::InetAddress("127.0.0.1", 0))) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+    client_fd_ = fds[0];
+    conn_ = net::TcpConnection::New();
+    conn_->Init(reactor_.get(), fds[1], net::InetAddress(0), net::InetAddress(0));
+    conn_->SetConnectionCallback([this](const net::TcpConnectionPtr &conn) { server_->OnConnection(conn); });
+    conn_->SetMessageCallback([this](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+      server_->OnMessage(conn, buffer);
+    });
+    conn_->SetCloseCallback([](const net::TcpConnectionPtr &conn) { conn->Destroy(); });
+
+    server_->Handle("/a", [](const net::HttpRequest &, net::HttpReply &reply) { reply.SetContent("A"); });
+    server_->Handle("/b", [](const net::HttpRequest &, net::HttpReply &reply) { reply.SetContent("B"); });
+  }
+  ~HttpServerTest() override {
+    ::close(client_fd_);
+  }
+
+  void Send(std::string_view data) const {
+    ASSERT_EQ(::send(client_fd_, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+  }
+
+  /// 以非阻塞的方式读取客户端收到的所有数据
+  std::string ReadClient() {
+    std::string s;
+    char buf[16 * 1024];
+    ssize_t n;
+    while ((n = ::recv(client_fd_, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+      s.append(buf, n);
+    }
+    peer_closed_ = peer_closed_ || n == 0;
+    return s;
+  }
+
+  static int CountReplies(std::string_view replies) {
+    int count = 0;
+    for (size_t pos = replies.find("HTTP/1.1"); pos != std::string_view::npos; pos = replies.find("HTTP/1.1", pos + 1)) {
+      ++count;
+    }
+    return count;
+  }
+
+  /// 按状态行拆分连续的多个应答，应答体中不能包含"HTTP/1.1"
+  static std::vector<std::string> SplitReplies(std::string_view replies) {
+    std::vector<std::string> parts;
+    for (size_t pos = 0; pos < replies.size();) {
+      size_t next = replies.find("HTTP/1.1", pos + 1);
+      parts.emplace_back(replies.substr(pos, next - pos));
+      pos = next;
+    }
+    return parts;
+  }
+
+  /// @return 应答中key头部的值，不存在时返回空字符串
+  static std::string GetHeader(std::string_view reply, std::string_view key) {
+    size_t pos = reply.find(std::string("\r\n") + std::string(key) + ": ");
+    if (pos == std::string_view::npos) return "";
+    pos += key.size() + 4;
+    return std::string(reply.substr(pos, reply.find("\r\n", pos) - pos));
+  }
+
+  /// @return 应答中的应答体
+  static std::string GetBody(std::string_view reply) {
+    return std::string(reply.substr(reply.find("\r\n\r\n") + 4));
+  }
+
+  /// 从chunked编码的应答中取出应答体
+  static std::string DecodeChunked(std::string_view reply) {
+    std::string body;
+    size_t pos = reply.find("\r\n\r\n") + 4;
+    while (true) {
+      size_t eol = reply.find("\r\n", pos);
+      size_t size = std::stoul(std::string(reply.substr(pos, eol - pos)), nullptr, 16);
+      if (size == 0) return body;
+      body.append(reply.substr(eol + 2, size));
+      pos = eol + 2 + size + 2;
+    }
+  }
+
+  // reactor_需要最后析构，其他成员持有的连接引用需要在Reactor线程(即当前线程)中释放
+  std::unique_ptr<net::Reactor> reactor_;
+  std::unique_ptr<net::HttpServer> server_;
+  net::TcpConnectionPtr conn_;
+  int client_fd_;
+  bool peer_closed_ = false;
+};
+
+TEST_F(HttpServerTest, Pipelining) {
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /a HTTP/1.1\r\n\r\n"
+         "POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+         "GET /a HTTP/1.1\r\n\r\n"
+         "GET /b HT");
+  });
+  reactor_->AddTimerAfter(10ms, [this] {
+    std::string replies = ReadClient();
+    // 三个完整的请求按顺序应答，不完整的请求等待后续数据
+    EXPECT_EQ(CountReplies(replies), 3) << replies;
+    size_t a1 = replies.find("\r\n\r\nA");
+    size_t b = replies.find("\r\n\r\nB");
+    size_t a2 = replies.rfind("\r\n\r\nA");
+    EXPECT_TRUE(a1 < b && b < a2) << replies;
+    Send("TP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(20ms, [this] {
+    std::string replies = ReadClient();
+    EXPECT_EQ(replies.substr(replies.size() - 5), "\r\n\r\nB");
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, ChunkedReply) {
+  server_->Handle("/stream", [this](const net::HttpRequest &, net::HttpReply &reply) {
+    auto writer = reply.BeginChunked();
+    writer->WriteChunk("hello");
+    // 处理函数返回之后继续写入
+    reactor_->AddTimerAfter(10ms, [writer] {
+      writer->WriteChunk(", world");
+      writer->End();
+    });
+  });
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /stream HTTP/1.1\r\n\r\nGET /a HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(5ms, [this] {
+    // 头部和处理函数中写入的数据已经发送，后续请求的应答等待流式应答结束
+    std::string reply = ReadClient();
+    EXPECT_NE(reply.find("Transfer-Encoding: chunked\r\n"), std::string::npos) << reply;
+    EXPECT_EQ(reply.find(net::kContentLengthField), std::string::npos) << reply;
+    EXPECT_EQ(reply.substr(reply.find("\r\n\r\n") + 4), "5\r\nhello\r\n");
+  });
+  reactor_->AddTimerAfter(30ms, [this] {
+    std::string reply = ReadClient();
+    EXPECT_EQ(reply.substr(0, 18), "7\r\n, world\r\n0\r\n\r\n" "H") << reply;
+    EXPECT_EQ(reply.substr(reply.size() - 5), "\r\n\r\nA");
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, ChunkedReplyBackpressure) {
+  constexpr size_t kChunkSize = 4096;
+  constexpr size_t kTotalSize = 4 * 1024 * 1024;
+  size_t max_pending = 0;
+  int paused = 0;
+  server_->Handle("/report", [&](const net::HttpRequest &, net::HttpReply &reply) {
+    auto writer = reply.BeginChunked();
+    auto produced = std::make_shared<size_t>(0);
+    auto pump = std::make_shared<std::function<void()>>();
+    *pump = [&, writer, produced, pump_ref = std::weak_ptr(pump)] {
+      std::string chunk(kChunkSize, 'x');
+      while (*produced < kTotalSize) {
+        *produced += kChunkSize;
+        bool writable = writer->WriteChunk(chunk);
+        max_pending = std::max(max_pending, conn_->GetPendingOutputBytes());
+        if (!writable) {
+          ++paused;
+          writer->SetWritableCallback([pump = pump_ref.lock()] { (*pump)(); });
+          return;
+        }
+      }
+      writer->End();
+    };
+    (*pump)();
+  });
+  std::string received;
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /report HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerEvery(1ms, [&] {
+    received += ReadClient();
+    if (received.size() >= 5 && received.substr(received.size() - 5) == "0\r\n\r\n") {
+      EXPECT_EQ(DecodeChunked(received).size(), kTotalSize);
+      conn_->ForceClose();
+      reactor_->Stop();
+    }
+  });
+  reactor_->Run();
+  EXPECT_GT(paused, 0);
+  // 待发送的数据不会超过高水位线太多
+  EXPECT_LT(max_pending, net::HttpChunkedWriter::kHighWaterMark + 2 * kChunkSize);
+}
+
+TEST_F(HttpServerTest, ChunkedReplyHttp10) {
+  server_->Handle("/stream", [](const net::HttpRequest &, net::HttpReply &reply) {
+    auto writer = reply.BeginChunked();
+    writer->WriteChunk("hello");
+    writer->WriteChunk(", world");
+    writer->End();
+  });
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /stream HTTP/1.0\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [this] {
+    // HTTP/1.0不使用chunked编码，以关闭连接表示应答体结束
+    std::string reply = ReadClient();
+    EXPECT_EQ(reply.find("Transfer-Encoding"), std::string::npos) << reply;
+    EXPECT_EQ(reply.substr(reply.find("\r\n\r\n") + 4), "hello, world");
+    EXPECT_TRUE(peer_closed_);
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, PathParams) {
+  server_->Handle(net::HttpMethod::Get, "/users/:id/files/*path", [](const net::HttpRequest &request, net::HttpReply &reply) {
+    reply.SetContent(std::string(request.GetPathParam("id")) + ":" + std::string(request.GetPathParam("path")));
+  });
+  server_->HandleStream(net::HttpMethod::Put, "/users/:id/files/*path", [](const net::HttpRequest &) {
+    auto size = std::make_shared<size_t>(0);
+    return net::HttpBodyReader{
+        [size](std::string_view data) { *size += data.size(); },
+        [size](const net::HttpRequest &request, net::HttpReply &reply) {
+          // 流式模式下url被复制到Arena中，路径参数仍然有效
+          reply.SetContent(std::string(request.GetPathParam("path")) + "=" + std::to_string(*size));
+        }};
+  });
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /users/42/files/a/b.txt?x=1 HTTP/1.1\r\n\r\n"
+         "DELETE /users/42/files/a HTTP/1.1\r\n\r\n"
+         "PUT /users/42/files/c.txt HTTP/1.1\r\nContent-Length: 5\r\n\r\nhel");
+  });
+  reactor_->AddTimerAfter(5ms, [this] { Send("lo"); });
+  reactor_->AddTimerAfter(15ms, [this] {
+    std::string replies = ReadClient();
+    EXPECT_EQ(CountReplies(replies), 3) << replies;
+    EXPECT_NE(replies.find("\r\n\r\n42:a/b.txt"), std::string::npos) << replies;
+    EXPECT_NE(replies.find("HTTP/1.1 405"), std::string::npos) << replies;
+    EXPECT_NE(replies.find("Allow: GET, PUT\r\n"), std::string::npos) << replies;
+    EXPECT_EQ(replies.substr(replies.size() - 7), "c.txt=5") << replies;
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, ExpectContinue) {
+  server_->SetMaxBodySize(16);
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("POST /a HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(5ms, [this] {
+    // 处理函数存在并且请求体的长度可以接受时，才让客户端继续发送请求体
+    EXPECT_EQ(ReadClient(), "HTTP/1.1 100 Continue\r\n\r\n");
+    Send("hello");
+    // 没有处理函数以及HTTP/1.0的请求直接回复最终的应答
+    Send("POST /c HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\nhello"
+         "POST /a HTTP/1.0\r\nConnection: Keep-Alive\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\nhello");
+  });
+  reactor_->AddTimerAfter(10ms, [this] {
+    std::string replies = ReadClient();
+    EXPECT_EQ(replies.find("100 Continue"), std::string::npos) << replies;
+    auto parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 3) << replies;
+    EXPECT_EQ(GetBody(parts[0]), "A");
+    EXPECT_EQ(parts[1].substr(0, 12), "HTTP/1.1 404") << replies;
+    EXPECT_EQ(GetBody(parts[2]), "A");
+    // 请求体过大时直接回复413
+    Send("POST /a HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 100\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(15ms, [this] {
+    std::string replies = ReadClient();
+    EXPECT_EQ(replies.find("100 Continue"), std::string::npos) << replies;
+    EXPECT_EQ(replies.substr(0, 12), "HTTP/1.1 413") << replies;
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, ConnectionHeader) {
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /a HTTP/1.1\r\n\r\n"
+         "GET /a HTTP/1.0\r\nconnection: keep-alive\r\n\r\n"
+         "GET /b HTTP/1.1\r\nConnection: close\r\n\r\n"
+         "GET /a HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [this] {
+    std::string replies = ReadClient();
+    // 请求要求关闭连接时，之后的请求不再处理
+    EXPECT_EQ(CountReplies(replies), 3) << replies;
+    size_t second = replies.find("HTTP/1.1", 1);
+    size_t third = replies.find("HTTP/1.1", second + 1);
+    EXPECT_EQ(replies.substr(0, second).find("Connection"), std::string::npos) << replies;
+    EXPECT_NE(replies.substr(second, third - second).find("Connection: Keep-Alive\r\n"), std::string::npos) << replies;
+    EXPECT_NE(replies.substr(third).find("Connection: Close\r\n"), std::string::npos) << replies;
+    EXPECT_EQ(replies.substr(replies.size() - 5), "\r\n\r\nB");
+    EXPECT_TRUE(peer_closed_);
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, FileServer) {
+  char dir[] = "/tmp/net_file_server_XXXXXX";
+  std::string base_dir = ::mkdtemp(dir);
+  std::string large(64 * 1024, 'x');
+  std::ofstream(base_dir + "/a.txt") << "hello";
+  std::ofstream(base_dir + "/large.bin") << large;
+  net::fs::create_directory(base_dir + "/sub");
+  std::ofstream(base_dir + "/sub/index.html") << "<html></html>";
+  server_->Handle("/static/", net::HttpFileServer(base_dir, "/static"));
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /static/a.txt HTTP/1.1\r\n\r\n"
+         "GET /static/large.bin HTTP/1.1\r\n\r\n"
+         "GET /static/a.txt HTTP/1.1\r\n\r\n"
+         "GET /static/sub HTTP/1.1\r\n\r\n"
+         "GET /static/sub/ HTTP/1.1\r\n\r\n"
+         "GET /static/missing.txt HTTP/1.1\r\n\r\n"
+         "GET /static/../etc/passwd HTTP/1.1\r\n\r\n");
+  });
+  std::string replies;
+  reactor_->AddTimerEvery(1ms, [&] { replies += ReadClient(); });
+  reactor_->AddTimerAfter(50ms, [&] {
+    EXPECT_EQ(CountReplies(replies), 7) << replies.size();
+    // 文件内容与其他应答按请求的顺序发送
+    size_t a1 = replies.find("Content-Type: text/plain");
+    size_t large_body = replies.find("\r\n\r\n" + large + "HTTP/1.1 200 OK");
+    size_t a2 = replies.find("\r\n\r\nhelloHTTP/1.1 301", a1 + 1);
+    EXPECT_NE(a1, std::string::npos);
+    EXPECT_NE(replies.find("Content-Length: 5\r\n"), std::string::npos);
+    EXPECT_TRUE(a1 < large_body && large_body < a2 && a2 != std::string::npos);
+    EXPECT_NE(replies.find("Location: /static/sub/\r\n"), std::string::npos);
+    EXPECT_NE(replies.find("\r\n\r\n<html></html>HTTP/1.1 404"), std::string::npos);
+    EXPECT_NE(replies.find("HTTP/1.1 403"), std::string::npos);
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  net::fs::remove_all(base_dir);
+}
+
+TEST_F(HttpServerTest, FileServerPathAlias) {
+  char dir[] = "/tmp/net_file_server_XXXXXX";
+  std::string base_dir = ::mkdtemp(dir);
+  std::ofstream(base_dir + "/a.txt") << "hello";
+  server_->Handle("/static/", net::HttpFileServer(base_dir, "/static"));
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    // 路径中的"."与空路径段被去掉，与规范的路径使用同一个缓存项
+    Send("GET /static/a.txt HTTP/1.1\r\n\r\n"
+         "GET /static/./a.txt HTTP/1.1\r\n\r\n"
+         "GET /static//a.txt HTTP/1.1\r\n\r\n");
+  });
+  std::string replies;
+  reactor_->AddTimerEvery(1ms, [&] { replies += ReadClient(); });
+  reactor_->AddTimerAfter(20ms, [&] {
+    auto parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 3) << replies;
+    for (auto &part: parts) {
+      EXPECT_EQ(GetBody(part), "hello") << replies;
+    }
+    replies.clear();
+    // 原子地替换文件之后，规范的路径得到新的内容
+    std::ofstream(base_dir + "/c.tmp") << "replaced";
+    net::fs::rename(base_dir + "/c.tmp", base_dir + "/a.txt");
+  });
+  reactor_->AddTimerAfter(60ms, [&] {
+    Send("GET /static/a.txt HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(80ms, [&] {
+    EXPECT_EQ(GetBody(replies), "replaced") << replies;
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  net::fs::remove_all(base_dir);
+}
+
+TEST_F(HttpServerTest, HeadRequest) {
+  char dir[] = "/tmp/net_file_server_XXXXXX";
+  std::string base_dir = ::mkdtemp(dir);
+  std::ofstream(base_dir + "/f.txt") << std::string(5000, 'f');
+  server_->Handle("/static/", net::HttpFileServer(base_dir, "/static"));
+  server_->Handle("/dyn", [](const net::HttpRequest &, net::HttpReply &reply) { reply.SetContent("dynamic"); });
+  server_->Handle("/stream", [](const net::HttpRequest &, net::HttpReply &reply) {
+    auto writer = reply.BeginChunked();
+    writer->WriteChunk("chunk");
+    writer->End();
+  });
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("HEAD /static/f.txt HTTP/1.1\r\n\r\n"
+         "HEAD /dyn HTTP/1.1\r\n\r\n"
+         "HEAD /stream HTTP/1.1\r\n\r\n"
+         "GET /dyn HTTP/1.1\r\n\r\n");
+  });
+  std::string replies;
+  reactor_->AddTimerEvery(1ms, [&] { replies += ReadClient(); });
+  reactor_->AddTimerAfter(20ms, [&] {
+    // HEAD请求的应答只有头部，Content-Length与GET相同，之后的应答紧随其后
+    auto parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 4) << replies;
+    EXPECT_EQ(GetHeader(parts[0], "Content-Length"), "5000");
+    EXPECT_EQ(GetBody(parts[0]), "");
+    EXPECT_EQ(GetHeader(parts[1], "Content-Length"), "7");
+    EXPECT_EQ(GetBody(parts[1]), "");
+    EXPECT_EQ(GetBody(parts[2]), "");
+    EXPECT_EQ(GetBody(parts[3]), "dynamic");
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  net::fs::remove_all(base_dir);
+}
+
+TEST_F(HttpServerTest, FileServerConditional) {
+  char dir[] = "/tmp/net_file_server_XXXXXX";
+  std::string base_dir = ::mkdtemp(dir);
+  net::fs::create_directory(base_dir + "/assets");
+  std::ofstream(base_dir + "/index.html") << "index";
+  std::ofstream(base_dir + "/assets/app.js") << "app";
+  net::HttpFileServer file_server(base_dir, "/static");
+  file_server.SetCacheControl("/static/", "no-cache");
+  file_server.SetCacheControl("/static/assets/", "public, max-age=31536000, immutable");
+  server_->Handle("/static/", file_server);
+
+  std::string etag, last_modified;
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /static/assets/app.js HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    std::string reply = ReadClient();
+    etag = GetHeader(reply, "ETag");
+    last_modified = GetHeader(reply, "Last-Modified");
+    EXPECT_EQ(etag.front(), '"') << reply;
+    EXPECT_EQ(etag.back(), '"') << reply;
+    EXPECT_EQ(last_modified.size(), net::kHttpDateSize) << reply;
+    EXPECT_EQ(GetHeader(reply, "Cache-Control"), "public, max-age=31536000, immutable");
+    EXPECT_EQ(reply.substr(reply.size() - 3), "app");
+    Send("GET /static/assets/app.js HTTP/1.1\r\nIf-None-Match: \"x\", W/" + etag + "\r\n\r\n"
+         "GET /static/assets/app.js HTTP/1.1\r\nIf-Modified-Since: " + last_modified + "\r\n\r\n"
+         "GET /static/assets/app.js HTTP/1.1\r\nIf-None-Match: \"x\"\r\nIf-Modified-Since: " + last_modified +
+         "\r\n\r\n"
+         "GET /static/assets/app.js HTTP/1.1\r\nIf-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT\r\n\r\n"
+         "GET /static/ HTTP/1.1\r\nIf-None-Match: *\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(20ms, [&] {
+    std::string replies = ReadClient();
+    std::vector<std::string> parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 5) << replies;
+    // 校验值匹配时返回没有应答体的304，并带上校验值与Cache-Control
+    EXPECT_EQ(parts[0].substr(0, 12), "HTTP/1.1 304");
+    EXPECT_EQ(parts[0].find("Content-Length"), std::string::npos);
+    EXPECT_EQ(parts[0].substr(parts[0].size() - 4), "\r\n\r\n");
+    EXPECT_EQ(GetHeader(parts[0], "ETag"), etag);
+    EXPECT_EQ(GetHeader(parts[0], "Cache-Control"), "public, max-age=31536000, immutable");
+    EXPECT_EQ(parts[1].substr(0, 12), "HTTP/1.1 304");
+    // If-None-Match存在时忽略If-Modified-Since
+    EXPECT_EQ(parts[2].substr(0, 12), "HTTP/1.1 200");
+    EXPECT_EQ(parts[3].substr(0, 12), "HTTP/1.1 200");
+    EXPECT_EQ(parts[4].substr(0, 12), "HTTP/1.1 304");
+    EXPECT_EQ(GetHeader(parts[4], "Cache-Control"), "no-cache");
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  net::fs::remove_all(base_dir);
+}
+
+TEST_F(HttpServerTest, FileServerRange) {
+  char dir[] = "/tmp/net_file_server_XXXXXX";
+  std::string base_dir = ::mkdtemp(dir);
+  std::ofstream(base_dir + "/a.txt") << "0123456789abcdefghij";
+  server_->Handle("/", net::HttpFileServer(base_dir));
+  std::string etag;
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /a.txt HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    std::string reply = ReadClient();
+    EXPECT_EQ(GetHeader(reply, "Accept-Ranges"), "bytes");
+    etag = GetHeader(reply, "ETag");
+    Send("GET /a.txt HTTP/1.1\r\nRange: bytes=2-5\r\n\r\n"
+         "GET /a.txt HTTP/1.1\r\nRange: bytes=-3\r\n\r\n"
+         "GET /a.txt HTTP/1.1\r\nRange: bytes=15-100\r\nIf-Range: " + etag + "\r\n\r\n"
+         "GET /a.txt HTTP/1.1\r\nRange: bytes=0-1, 30-40, 18-\r\n\r\n"
+         "GET /a.txt HTTP/1.1\r\nRange: bytes=30-40\r\n\r\n"
+         "GET /a.txt HTTP/1.1\r\nRange: bytes=5-2\r\n\r\n"
+         "GET /a.txt HTTP/1.1\r\nRange: bytes=2-5\r\nIf-Range: \"old\"\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(20ms, [&] {
+    std::string replies = ReadClient();
+    std::vector<std::string> parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 7) << replies;
+    EXPECT_EQ(parts[0].substr(0, 12), "HTTP/1.1 206");
+    EXPECT_EQ(GetHeader(parts[0], "Content-Range"), "bytes 2-5/20");
+    EXPECT_EQ(GetHeader(parts[0], "Content-Length"), "4");
+    EXPECT_EQ(GetBody(parts[0]), "2345");
+    EXPECT_EQ(GetHeader(parts[1], "Content-Range"), "bytes 17-19/20");
+    EXPECT_EQ(GetBody(parts[1]), "hij");
+    EXPECT_EQ(GetHeader(parts[2], "Content-Range"), "bytes 15-19/20");
+    EXPECT_EQ(GetBody(parts[2]), "fghij");
+    // 多个范围以multipart/byteranges发送，不可满足的范围被丢弃
+    std::string content_type = GetHeader(parts[3], "Content-Type");
+    std::string boundary = content_type.substr(content_type.find("boundary=") + 9);
+    EXPECT_EQ(content_type, "multipart/byteranges; boundary=" + boundary);
+    std::string body = GetBody(parts[3]);
+    EXPECT_EQ(GetHeader(parts[3], "Content-Length"), std::to_string(body.size()));
+    EXPECT_EQ(body, "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-1/20\r\n\r\n01"
+                    "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 18-19/20\r\n\r\nij"
+                    "\r\n--" + boundary + "--\r\n");
+    EXPECT_EQ(parts[4].substr(0, 12), "HTTP/1.1 416");
+    EXPECT_EQ(GetHeader(parts[4], "Content-Range"), "bytes */20");
+    EXPECT_EQ(GetBody(parts[4]), "");
+    // 格式错误或者If-Range不匹配时忽略Range
+    EXPECT_EQ(parts[5].substr(0, 12), "HTTP/1.1 200");
+    EXPECT_EQ(GetBody(parts[5]), "0123456789abcdefghij");
+    EXPECT_EQ(parts[6].substr(0, 12), "HTTP/1.1 200");
+    EXPECT_EQ(GetBody(parts[6]), "0123456789abcdefghij");
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  net::fs::remove_all(base_dir);
+}
+
+TEST_F(HttpServerTest, Compression) {
+  net::ThreadPool thread_pool(1);
+  thread_pool.Start();
+  net::HttpCompressionOptions options;
+  options.offload_size = 4096;
+  server_->EnableCompression(options, &thread_pool);
+  std::string small(1024, 's');
+  std::string large(64 * 1024, 'l');
+  server_->Handle("/small", [&](const net::HttpRequest &, net::HttpReply &reply) {
+    reply.SetContentType("text/plain");
+    reply.SetContent(small);
+  });
+  server_->Handle("/large", [&](const net::HttpRequest &, net::HttpReply &reply) {
+    reply.SetContentType("text/plain");
+    reply.SetContent(large);
+  });
+  auto inflate = [](std::string_view data) {
+    std::string out(1024 * 1024, '\0');
+    uLongf size = out.size();
+    EXPECT_EQ(::uncompress(reinterpret_cast<Bytef *>(out.data()), &size,
+                           reinterpret_cast<const Bytef *>(data.data()), data.size()), Z_OK);
+    out.resize(size);
+    return out;
+  };
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    // 较大的应答体在线程池中压缩，之后的请求在其完成后按顺序应答
+    Send("GET /small HTTP/1.1\r\nAccept-Encoding: deflate\r\n\r\n"
+         "GET /large HTTP/1.1\r\nAccept-Encoding: deflate\r\n\r\n"
+         "GET /a HTTP/1.1\r\n\r\n"
+         "GET /large HTTP/1.1\r\nAccept-Encoding: deflate\r\n\r\n"
+         "GET /small HTTP/1.1\r\n\r\n");
+  });
+  std::string replies;
+  reactor_->AddTimerEvery(1ms, [&] { replies += ReadClient(); });
+  reactor_->AddTimerAfter(100ms, [&] {
+    std::vector<std::string> parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 5) << replies;
+    EXPECT_EQ(GetHeader(parts[0], "Content-Encoding"), "deflate");
+    EXPECT_EQ(inflate(GetBody(parts[0])), small);
+    EXPECT_EQ(GetHeader(parts[1], "Content-Encoding"), "deflate");
+    EXPECT_EQ(GetHeader(parts[1], "Vary"), "Accept-Encoding");
+    EXPECT_EQ(inflate(GetBody(parts[1])), large);
+    EXPECT_EQ(GetBody(parts[2]), "A");
+    // 第二次命中缓存
+    EXPECT_EQ(GetBody(parts[3]), GetBody(parts[1]));
+    EXPECT_EQ(GetHeader(parts[4], "Content-Encoding"), "");
+    EXPECT_EQ(GetHeader(parts[4], "Vary"), "Accept-Encoding");
+    EXPECT_EQ(GetBody(parts[4]), small);
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  thread_pool.Stop();
+}
+
+TEST_F(HttpServerTest, FileServerPrecompressed) {
+  char dir[] = "/tmp/net_file_server_XXXXXX";
+  std::string base_dir = ::mkdtemp(dir);
+  std::ofstream(base_dir + "/app.js") << "plain";
+  std::ofstream(base_dir + "/app.js.gz") << "gzipped";
+  std::ofstream(base_dir + "/app.js.br") << "brotli";
+  server_->Handle("/", net::HttpFileServer(base_dir));
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip, deflate, br\r\n\r\n"
+         "GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n"
+         "GET /app.js HTTP/1.1\r\nAccept-Encoding: br;q=0.5, gzip\r\n\r\n"
+         "GET /app.js HTTP/1.1\r\n\r\n"
+         "GET /app.js.gz HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    std::string replies = ReadClient();
+    std::vector<std::string> parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 5) << replies;
+    EXPECT_EQ(GetBody(parts[0]), "brotli");
+    EXPECT_EQ(GetHeader(parts[0], "Content-Encoding"), "br");
+    EXPECT_EQ(GetHeader(parts[0], "Content-Type"), net::ToMimeType(".js"));
+    EXPECT_EQ(GetHeader(parts[0], "Vary"), "Accept-Encoding");
+    EXPECT_EQ(GetBody(parts[1]), "gzipped");
+    EXPECT_EQ(GetHeader(parts[1], "Content-Encoding"), "gzip");
+    EXPECT_EQ(GetBody(parts[2]), "gzipped");
+    // 不同编码的校验值不同
+    EXPECT_NE(GetHeader(parts[0], "ETag"), GetHeader(parts[1], "ETag"));
+    EXPECT_EQ(GetBody(parts[3]), "plain");
+    EXPECT_EQ(GetHeader(parts[3], "Content-Encoding"), "");
+    EXPECT_EQ(GetHeader(parts[3], "Vary"), "Accept-Encoding");
+    // 直接请求预压缩文件时按普通文件发送
+    EXPECT_EQ(GetBody(parts[4]), "gzipped");
+    EXPECT_EQ(GetHeader(parts[4], "Vary"), "");
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  net::fs::remove_all(base_dir);
+}
+
+TEST_F(HttpServerTest, MicroCache) {
+  int calls = 0;
+  server_->HandleCached(net::HttpMethod::Invalid, "/cached", [&](const net::HttpRequest &, net::HttpReply &reply) {
+    reply.SetContent(std::to_string(++calls));
+  });
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /cached?x=1 HTTP/1.1\r\n\r\n"
+         "GET /cached?x=1 HTTP/1.1\r\n\r\n"
+         "GET /cached?x=2 HTTP/1.1\r\n\r\n"
+         "POST /cached?x=1 HTTP/1.1\r\nContent-Length: 0\r\n\r\n"
+         "HEAD /cached?x=1 HTTP/1.1\r\n\r\n"
+         "HEAD /cached?x=1 HTTP/1.1\r\n\r\n"
+         "GET /cached?x=1 HTTP/1.0\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    std::string replies = ReadClient();
+    std::vector<std::string> parts = SplitReplies(replies);
+    ASSERT_EQ(parts.size(), 7) << replies;
+    EXPECT_EQ(GetBody(parts[0]), "1");
+    // 命中时不调用处理函数，除了Date之外与缓存的应答完全相同
+    auto without_date = [](std::string reply) {
+      return reply.erase(reply.find("Date: "), 6 + net::kHttpDateSize);
+    };
+    EXPECT_EQ(without_date(parts[1]), without_date(parts[0]));
+    EXPECT_EQ(GetBody(parts[2]), "2");
+    // 只有GET/HEAD请求使用缓存，HEAD与GET的键不同
+    EXPECT_EQ(GetBody(parts[3]), "3");
+    EXPECT_EQ(GetHeader(parts[4], "Content-Length"), "1");
+    // HEAD请求的应答(包括命中缓存时)不包含应答体
+    EXPECT_EQ(GetBody(parts[4]), "");
+    EXPECT_EQ(without_date(parts[5]), without_date(parts[4]));
+    // HTTP/1.0的请求命中时修改Connection头部
+    EXPECT_EQ(GetBody(parts[6]), "1");
+    EXPECT_EQ(GetHeader(parts[6], "Connection"), "Close");
+    EXPECT_EQ(calls, 4);
+    EXPECT_TRUE(peer_closed_);
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(HttpServerTest, MicroCacheCollapse) {
+  net::ThreadPool thread_pool(1);
+  thread_pool.Start();
+  std::promise<void> release;
+  thread_pool.SubmitTask([future = release.get_future().share()] { future.wait(); });
+  net::HttpCompressionOptions options;
+  options.offload_size = 1024;
+  server_->EnableCompression(options, &thread_pool);
+  int calls = 0;
+  std::string text(8 * 1024, 't');
+  server_->HandleCached(net::HttpMethod::Get, "/cached", [&](const net::HttpRequest &, net::HttpReply &reply) {
+    ++calls;
+    reply.SetContentType("text/plain");
+    reply.SetContent(text);
+  });
+
+  int fds[2];
+  ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+  auto conn2 = net::TcpConnection::New();
+  conn2->Init(reactor_.get(), fds[1], net::InetAddress(0), net::InetAddress(0));
+  conn2->SetConnectionCallback([this](const net::TcpConnectionPtr &conn) { server_->OnConnection(conn); });
+  conn2->SetMessageCallback([this](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+    server_->OnMessage(conn, buffer);
+  });
+  conn2->SetCloseCallback([](const net::TcpConnectionPtr &conn) { conn->Destroy(); });
+  std::string request = "GET /cached HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n";
+
+  reactor_->SubmitTask([&] {
+    conn_->Establish();
+    conn2->Establish();
+    // 线程池被阻塞，第一个请求的应答在压缩完成之前，相同的请求都等待它
+    Send(request + "GET /a HTTP/1.1\r\n\r\n");
+    ASSERT_EQ(::send(fds[0], request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    EXPECT_EQ(ReadClient(), "");
+    release.set_value();
+  });
+  reactor_->AddTimerAfter(50ms, [&] {
+    std::vector<std::string> parts = SplitReplies(ReadClient());
+    ASSERT_EQ(parts.size(), 2);
+    EXPECT_EQ(GetHeader(parts[0], "Content-Encoding"), "gzip");
+    EXPECT_EQ(GetBody(parts[1]), "A");
+    char buf[16 * 1024];
+    ssize_t n = ::recv(fds[0], buf, sizeof(buf), MSG_DONTWAIT);
+    ASSERT_GT(n, 0);
+    std::string reply(buf, n);
+    EXPECT_EQ(GetHeader(reply, "Content-Encoding"), "gzip");
+    EXPECT_EQ(GetBody(reply), GetBody(parts[0]));
+    EXPECT_EQ(calls, 1);
+    conn_->ForceClose();
+    conn2->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  thread_pool.Stop();
+  conn2.reset();
+  ::close(fds[0]);
+}
+
+TEST_F(HttpServerTest, ThreadPoolHandler) {
+  net::ThreadPool thread_pool(2);
+  thread_pool.Start();
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::atomic<bool> in_reactor_thread{true};
+  server_->Handle(net::HttpMethod::Get, "/slow", [&](const net::HttpRequest &request, net::HttpReply &reply) {
+    in_reactor_thread = reactor_->InCurrentReactorThread();
+    released.wait();
+    reply.SetContent(std::string("slow ") + std::string(request.GetUrl()));
+  }, &thread_pool);
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /a HTTP/1.1\r\n\r\n"
+         "GET /slow?x=1 HTTP/1.1\r\n\r\n"
+         "GET /b HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    // 处理函数阻塞时Reactor仍然运行，之前的应答已经发送，之后的请求等待
+    std::vector<std::string> parts = SplitReplies(ReadClient());
+    ASSERT_EQ(parts.size(), 1);
+    EXPECT_EQ(GetBody(parts[0]), "A");
+    release.set_value();
+  });
+  reactor_->AddTimerAfter(30ms, [&] {
+    std::vector<std::string> parts = SplitReplies(ReadClient());
+    ASSERT_EQ(parts.size(), 2);
+    EXPECT_EQ(GetBody(parts[0]), "slow /slow?x=1");
+    EXPECT_EQ(GetBody(parts[1]), "B");
+    EXPECT_FALSE(in_reactor_thread);
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  thread_pool.Stop();
+}
+
+TEST_F(HttpServerTest, DeferredReply) {
+  std::vector<net::HttpDeferredReply> tokens;
+  server_->HandleDeferred(net::HttpMethod::Get, "/deferred", [&](const net::HttpRequest &request,
+                                                                 net::HttpDeferredReply token) {
+    if (request.GetUrl() == "/deferred?drop") return;
+    tokens.push_back(std::move(token));
+  });
+  std::thread completer;
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    Send("GET /deferred HTTP/1.1\r\n\r\n"
+         "GET /a HTTP/1.1\r\n\r\n"
+         "GET /deferred?drop HTTP/1.1\r\n\r\n"
+         "GET /b HTTP/1.1\r\n\r\n");
+  });
+  reactor_->AddTimerAfter(10ms, [&] {
+    EXPECT_EQ(ReadClient(), "");
+    ASSERT_EQ(tokens.size(), 1);
+    EXPECT_FALSE(tokens[0].IsDone());
+    // 在其他线程中完成应答
+    completer = std::thread([token = tokens[0]] {
+      net::HttpReply reply;
+      reply.SetStatusCode(net::HttpStatusCode::k201Created);
+      reply.SetContent("done");
+      EXPECT_TRUE(token.Reply(std::move(reply)));
+      EXPECT_FALSE(token.Reply(net::HttpReply()));
+    });
+  });
+  reactor_->AddTimerAfter(30ms, [&] {
+    std::vector<std::string> parts = SplitReplies(ReadClient());
+    ASSERT_EQ(parts.size(), 4);
+    EXPECT_EQ(parts[0].substr(0, parts[0].find("\r\n")), "HTTP/1.1 201 Created");
+    EXPECT_EQ(GetBody(parts[0]), "done");
+    EXPECT_EQ(GetBody(parts[1]), "A");
+    // 没有完成就被丢弃的令牌回复500
+    EXPECT_EQ(parts[2].substr(0, parts[2].find("\r\n")), "HTTP/1.1 500 Internal Server Error");
+    EXPECT_EQ(GetBody(parts[3]), "B");
+    EXPECT_TRUE(tokens[0].IsDone());
+    tokens.clear();
+    conn_->ForceClose();
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  completer.join();
+}
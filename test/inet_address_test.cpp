@@ -0,0 +1,61 @@
+#include <net/inet_address.hpp>
+
+#include "net_test.hpp"
+
+class InetAddressTest : public testing::Test {};
+
+TEST_F(InetAddressTest, Ipv4) {
+  net::InetAddress addr("127.0.0.1", 9987);
+  EXPECT_EQ(addr.GetFamily(), AF_INET);
+  EXPECT_EQ(addr.GetPort(), 9987);
+  EXPECT_EQ(addr.GetSockLen(), sizeof(struct sockaddr_in));
+  EXPECT_EQ(addr.ToString(), "127.0.0.1:9987");
+  EXPECT_EQ(net::InetAddress(80).ToString(), "0.0.0.0:80");
+}
+
+TEST_F(InetAddressTest, Ipv6) {
+  net::InetAddress addr("::1", 9987);
+  EXPECT_EQ(addr.GetFamily(), AF_INET6);
+  EXPECT_EQ(addr.GetPort(), 9987);
+  EXPECT_EQ(addr.GetSockLen(), sizeof(struct sockaddr_in6));
+  EXPECT_EQ(addr.ToString(), "[::1]:9987");
+  EXPECT_EQ(net::InetAddress(80, true).ToString(), "[::]:80");
+}
+
+TEST_F(InetAddressTest, Unix) {
+  auto addr = net::InetAddress::UnixPath("/tmp/net.sock");
+  EXPECT_TRUE(addr.IsUnix());
+  EXPECT_EQ(addr.GetPort(), 0);
+  EXPECT_EQ(addr.GetUnixPath(), "/tmp/net.sock");
+  EXPECT_EQ(addr.ToString(), "unix:/tmp/net.sock");
+
+  auto abstract_addr = net::InetAddress::AbstractUnix("net");
+  EXPECT_TRUE(abstract_addr.IsUnix());
+  EXPECT_EQ(abstract_addr.GetUnixPath(), "");
+  EXPECT_EQ(abstract_addr.GetSockLen(), offsetof(struct sockaddr_un, sun_path) + 4);
+  EXPECT_EQ(abstract_addr.ToString(), "unix:@net");
+}
+
+TEST_F(InetAddressTest, UnixPathTooLong) {
+  constexpr size_t kSunPathSize = sizeof(sockaddr_un::sun_path);
+  // 文件路径需要保留结尾的'\0'，抽象地址的名字可以占满'\0'之后的所有字节
+  auto addr = net::InetAddress::UnixPath("/" + std::string(kSunPathSize - 2, 'p'));
+  EXPECT_EQ(addr.GetUnixPath().size(), kSunPathSize - 1);
+  auto abstract_addr = net::InetAddress::AbstractUnix(std::string(kSunPathSize - 1, 'a'));
+  EXPECT_EQ(abstract_addr.GetSockLen(), sizeof(struct sockaddr_un));
+  EXPECT_EQ(abstract_addr.ToString(), "unix:@" + std::string(kSunPathSize - 1, 'a'));
+
+  // 过长的地址不截断，而是无效，bind()/connect()失败
+  auto long_addr = net::InetAddress::UnixPath("/" + std::string(kSunPathSize - 1, 'p'));
+  EXPECT_TRUE(long_addr.IsUnix());
+  EXPECT_EQ(long_addr.GetSockLen(), 0);
+  EXPECT_EQ(long_addr.GetUnixPath(), "");
+  EXPECT_EQ(long_addr.ToString(), "INVALID");
+  auto long_abstract_addr = net::InetAddress::AbstractUnix(std::string(kSunPathSize, 'a'));
+  EXPECT_EQ(long_abstract_addr.GetSockLen(), 0);
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_GE(fd, 0);
+  EXPECT_LT(::bind(fd, long_addr.GetSockAddr(), long_addr.GetSockLen()), 0);
+  EXPECT_LT(::connect(fd, long_abstract_addr.GetSockAddr(), long_abstract_addr.GetSockLen()), 0);
+  ::close(fd);
+}
@@ -0,0 +1,102 @@
+#include <net/reactor/acceptor.hpp>
+#include <net/reactor/connector.hpp>
+#include <net/util/string.hpp>
+
+#include "net_test.hpp"
+
+#include <sys/stat.h>
+
+#include <fstream>
+
+class AcceptorTest : public testing::Test {
+ public:
+  AcceptorTest() : reactor_(new net::Reactor) {}
+  ~AcceptorTest() override { delete reactor_; }
+
+  /// 使用Connector连接Acceptor，返回Acceptor收到的对端地址
+  std::string AcceptOnce(const net::InetAddress &listen_addr, const net::InetAddress &server_addr) {
+    std::string peer;
+    net::Acceptor acceptor(reactor_, listen_addr);
+    acceptor.SetNewConnectionCallback([&](int conn_fd, const net::InetAddress &peer_addr) {
+      peer = peer_addr.ToString();
+      EXPECT_EQ(net::GetSocketDomain(conn_fd), listen_addr.GetFamily());
+      net::Close(conn_fd);
+      reactor_->Stop();
+    });
+    acceptor.Listen();
+    net::Connector connector(reactor_, server_addr);
+    connector.SetNewConnectionCallback([](int fd) { net::Close(fd); });
+    connector.Start();
+    reactor_->Run();
+    return peer;
+  }
+
+  net::Reactor *reactor_;
+};
+
+TEST_F(AcceptorTest, Ipv4) {
+  auto peer = AcceptOnce(net::InetAddress("127.0.0.1", 19987), net::InetAddress("127.0.0.1", 19987));
+  EXPECT_TRUE(net::HasPrefix(peer, "127.0.0.1:"));
+}
+
+TEST_F(AcceptorTest, Ipv6) {
+  auto peer = AcceptOnce(net::InetAddress("::1", 19988), net::InetAddress("::1", 19988));
+  EXPECT_TRUE(net::HasPrefix(peer, "[::1]:"));
+}
+
+TEST_F(AcceptorTest, Unix) {
+  std::string path = "/tmp/net_acceptor_test.sock";
+  auto peer = AcceptOnce(net::InetAddress::UnixPath(path), net::InetAddress::UnixPath(path));
+  EXPECT_EQ(peer, "unix:");  // 客户端没有bind，对端地址为匿名地址
+  ::unlink(path.c_str());
+}
+
+TEST_F(AcceptorTest, UnixStaleSocket) {
+  std::string path = "/tmp/net_acceptor_stale_test.sock";
+  ::unlink(path.c_str());
+  // 上次运行残留的socket文件，没有进程监听
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  auto addr = net::InetAddress::UnixPath(path);
+  ASSERT_EQ(::bind(fd, addr.GetSockAddr(), addr.GetSockLen()), 0);
+  ::close(fd);
+  EXPECT_EQ(AcceptOnce(addr, addr), "unix:");
+  // Acceptor析构时删除自己绑定的socket文件
+  struct stat st{};
+  EXPECT_NE(::lstat(path.c_str(), &st), 0);
+}
+
+TEST_F(AcceptorTest, UnixPathInUse) {
+  // 普通文件不会被删除
+  std::string file_path = "/tmp/net_acceptor_file_test.sock";
+  { std::ofstream(file_path) << "data"; }
+  {
+    net::Acceptor acceptor(reactor_, net::InetAddress::UnixPath(file_path));
+  }
+  struct stat st{};
+  ASSERT_EQ(::lstat(file_path.c_str(), &st), 0);
+  EXPECT_TRUE(S_ISREG(st.st_mode));
+  ::unlink(file_path.c_str());
+
+  // 正在监听的socket不会被第二个Acceptor抢占，也不会被其删除
+  std::string path = "/tmp/net_acceptor_live_test.sock";
+  ::unlink(path.c_str());
+  auto addr = net::InetAddress::UnixPath(path);
+  net::Acceptor live(reactor_, addr);
+  live.Listen();
+  ASSERT_EQ(::lstat(path.c_str(), &st), 0);
+  ino_t inode = st.st_ino;
+  {
+    net::Acceptor second(reactor_, addr);
+  }
+  ASSERT_EQ(::lstat(path.c_str(), &st), 0);
+  EXPECT_EQ(st.st_ino, inode);
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  EXPECT_EQ(::connect(fd, addr.GetSockAddr(), addr.GetSockLen()), 0);
+  ::close(fd);
+}
+
+TEST_F(AcceptorTest, AbstractUnix) {
+  auto addr = net::InetAddress::AbstractUnix("net_acceptor_test");
+  auto peer = AcceptOnce(addr, addr);
+  EXPECT_EQ(peer, "unix:");
+}
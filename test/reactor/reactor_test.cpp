@@ -63,3 +63,109 @@ TEST_F(ReactorTest, Timer) {
   EXPECT_EQ(num, 15);
   t.join();
 }
+
+TEST_F(ReactorTest, CancleTimer) {
+  int num = 0;
+  auto once = reactor_->AddTimerAfter(50ms, [&num] { num += 1; });
+  auto every = reactor_->AddTimerEvery(20ms, [&num] { num += 2; });
+  net::Reactor::TimerId later = 0;
+  reactor_->AddTimerAfter(30ms, [&] {
+    reactor_->CancleTimer(once);
+    reactor_->CancleTimer(every);
+    reactor_->CancleTimer(later);
+    reactor_->CancleTimer(later);  // 重复取消不会出错
+  });
+  later = reactor_->AddTimerAfter(30ms, [&num] { num += 4; });  // 与取消它的Timer同一轮过期
+  reactor_->AddTimerAfter(100ms, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  EXPECT_EQ(num, 2);
+}
+
+TEST_F(ReactorTest, CancleTimerInItsOwnTask) {
+  // 重复的Timer在自己的Task中取消自己，Task及其捕获的状态在运行结束之前不能被销毁
+  auto counter = std::make_shared<int>(0);
+  std::weak_ptr<int> weak_counter = counter;
+  net::Reactor::TimerId every = 0;
+  every = reactor_->AddTimerEvery(5ms, [this, &every, counter = std::move(counter)] {
+    if (++*counter == 3) {
+      reactor_->CancleTimer(every);
+      EXPECT_EQ(*counter, 3);  // 捕获的状态仍然有效
+    }
+  });
+  reactor_->AddTimerAfter(50ms, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  // 取消之后不再运行，Task随Timer一起释放
+  EXPECT_TRUE(weak_counter.expired());
+}
+
+TEST_F(ReactorTest, TimerAtPassedTime) {
+  // 已经过去的时间点仍会过期，而不是使timerfd停止计时
+  bool fired = false;
+  reactor_->AddTimerAt(net::GetNow() - 10ms, [&fired] { fired = true; });
+  // timerfd停止计时后其他Timer也不会运行，因此从另一个线程结束Reactor
+  std::thread t([this] {
+    std::this_thread::sleep_for(50ms);
+    reactor_->SubmitTask([this] { reactor_->Stop(); });
+  });
+  reactor_->Run();
+  t.join();
+  EXPECT_TRUE(fired);
+}
+
+TEST_F(ReactorTest, TimerAddedInTask) {
+  // Task中添加的Timer即使已经过期，也在下一轮才运行，本轮结束之后会先处理任务队列
+  bool round_ended = false;
+  std::vector<int> order;
+  reactor_->AddTimerAfter(5ms, [&] {
+    order.push_back(1);
+    reactor_->SubmitTask([&round_ended] { round_ended = true; });
+    reactor_->AddTimerAt(net::GetNow() - 10ms, [&] {
+      EXPECT_TRUE(round_ended);
+      order.push_back(3);
+    });
+    reactor_->AddTimerAfter(0ms, [&] {
+      EXPECT_TRUE(round_ended);
+      order.push_back(4);
+    });
+  });
+  reactor_->AddTimerAfter(5ms, [&order] { order.push_back(2); });
+  std::thread t([this] {
+    std::this_thread::sleep_for(50ms);
+    reactor_->SubmitTask([this] { reactor_->Stop(); });
+  });
+  reactor_->Run();
+  t.join();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3, 4}));
+}
+
+TEST_F(ReactorTest, QueueFlush) {
+  int num = 0;
+  net::Channel channel(-1);
+  channel.SetFlushCallback([&num] { ++num; });
+  reactor_->SubmitTask([this, &channel, &num] {
+    reactor_->QueueFlush(&channel);
+    reactor_->QueueFlush(&channel);
+    EXPECT_EQ(num, 0);  // 在本轮任务处理完成之后才会刷新
+  });
+  reactor_->SubmitTask([this, &channel, &num] {
+    EXPECT_EQ(num, 0);
+    reactor_->QueueFlush(&channel);
+  });
+  reactor_->SubmitTask([this] { reactor_->Stop(); });
+  reactor_->Run();
+  EXPECT_EQ(num, 1);
+  EXPECT_FALSE(channel.IsFlushPending());
+}
+
+TEST_F(ReactorTest, RemoveChannelCancelFlush) {
+  int num = 0;
+  net::Channel channel(-1);
+  channel.SetFlushCallback([&num] { ++num; });
+  reactor_->SubmitTask([this, &channel] {
+    reactor_->QueueFlush(&channel);
+    reactor_->RemoveChannel(&channel);
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  EXPECT_EQ(num, 0);
+}
@@ -0,0 +1,138 @@
+#include <net/rpc/rpc_channel.hpp>
+#include <net/rpc/rpc_server.hpp>
+
+#include "net_test.hpp"
+
+#include <sys/socket.h>
+
+using namespace std::chrono_literals;
+
+/// 通过socketpair连接客户端的RpcChannel和服务端的RpcDispatcher，两端运行在同一个Reactor上
+class RpcTest : public testing::Test {
+ public:
+  enum Method : uint32_t {
+    kEcho = 1,
+    kDelayedEcho = 2,   // 50ms后再应答
+    kNoReply = 3,       // 保存应答句柄，不应答
+  };
+
+  RpcTest() : reactor_(new net::Reactor) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+    client_fd_ = fds[0];
+    server_fd_ = fds[1];
+    client_conn_ = NewConnection(client_fd_);
+    client_conn_->SetConnectionCallback([this](const net::TcpConnectionPtr &conn) {
+      channel_.OnConnection(conn);
+    });
+    client_conn_->SetMessageCallback([this](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+      channel_.OnMessage(conn, buffer);
+    });
+    server_conn_ = NewConnection(server_fd_);
+    server_conn_->SetMessageCallback([this](const net::TcpConnectionPtr &conn, const net::BufferPtr &buffer) {
+      dispatcher_.OnMessage(conn, buffer);
+    });
+
+    dispatcher_.RegisterMethod(kEcho, [](std::string_view request, net::RpcResponder responder) {
+      responder.Reply(request);
+    });
+    dispatcher_.RegisterMethod(kDelayedEcho, [this](std::string_view request, net::RpcResponder responder) {
+      auto shared = std::make_shared<net::RpcResponder>(std::move(responder));
+      reactor_->AddTimerAfter(50ms, [shared, str = std::string(request)] {
+        shared->Reply(str);
+      });
+    });
+    dispatcher_.RegisterMethod(kNoReply, [this](std::string_view, net::RpcResponder responder) {
+      held_responders_.push_back(std::move(responder));
+    });
+  }
+  ~RpcTest() override {
+    held_responders_.clear();  // 两端的fd都由TcpConnection负责关闭
+  }
+
+  net::TcpConnectionPtr NewConnection(int fd) {
+    auto conn = net::TcpConnection::New();
+    conn->Init(reactor_.get(), fd, net::InetAddress(0), net::InetAddress(0));
+    conn->SetCloseCallback([](const net::TcpConnectionPtr &conn) { conn->Destroy(); });
+    return conn;
+  }
+  void Establish() {
+    client_conn_->Establish();
+    server_conn_->Establish();
+  }
+
+  // reactor_需要最后析构，其他成员持有的连接引用需要在Reactor线程(即当前线程)中释放
+  std::unique_ptr<net::Reactor> reactor_;
+  int client_fd_;
+  int server_fd_;
+  net::TcpConnectionPtr client_conn_;
+  net::TcpConnectionPtr server_conn_;
+  net::RpcChannel channel_;
+  net::RpcDispatcher dispatcher_;
+  std::vector<net::RpcResponder> held_responders_;
+};
+
+TEST_F(RpcTest, NotConnected) {
+  net::RpcStatus status = net::RpcStatus::Ok;
+  channel_.Call(kEcho, "hello", [&](net::RpcStatus s, std::string_view) { status = s; });
+  EXPECT_EQ(status, net::RpcStatus::NotConnected);
+}
+
+TEST_F(RpcTest, OutOfOrder) {
+  std::vector<std::string> responses;
+  reactor_->SubmitTask([&] {
+    Establish();
+    channel_.Call(kDelayedEcho, "first", [&](net::RpcStatus status, std::string_view response) {
+      EXPECT_EQ(status, net::RpcStatus::Ok);
+      responses.emplace_back(response);
+      reactor_->Stop();
+    });
+    channel_.Call(kEcho, "second", [&](net::RpcStatus status, std::string_view response) {
+      EXPECT_EQ(status, net::RpcStatus::Ok);
+      responses.emplace_back(response);
+    });
+    EXPECT_EQ(channel_.GetPendingCallNum(), 2);
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });  // 防止测试卡死
+  reactor_->Run();
+  EXPECT_EQ(responses, (std::vector<std::string>{"second", "first"}));
+  EXPECT_EQ(channel_.GetPendingCallNum(), 0);
+}
+
+TEST_F(RpcTest, MethodNotFoundAndTimeout) {
+  std::vector<net::RpcStatus> statuses;
+  reactor_->SubmitTask([&] {
+    Establish();
+    channel_.Call(100, "", [&](net::RpcStatus status, std::string_view) {
+      statuses.push_back(status);
+    });
+    channel_.Call(kNoReply, "", [&](net::RpcStatus status, std::string_view) {
+      statuses.push_back(status);
+      reactor_->Stop();
+    }, 30ms);
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  EXPECT_EQ(statuses, (std::vector<net::RpcStatus>{net::RpcStatus::MethodNotFound, net::RpcStatus::Timeout}));
+  EXPECT_EQ(held_responders_.size(), 1);
+}
+
+TEST_F(RpcTest, ConnectionClosed) {
+  std::vector<net::RpcStatus> statuses;
+  reactor_->SubmitTask([&] {
+    Establish();
+    for (int i = 0; i < 3; ++i) {
+      channel_.Call(kNoReply, "", [&](net::RpcStatus status, std::string_view) {
+        statuses.push_back(status);
+      });
+    }
+  });
+  reactor_->AddTimerAfter(20ms, [&] {
+    EXPECT_EQ(held_responders_.size(), 3);
+    server_conn_->ForceClose();
+  });
+  reactor_->AddTimerAfter(50ms, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  EXPECT_EQ(statuses, std::vector<net::RpcStatus>(3, net::RpcStatus::ConnectionClosed));
+  EXPECT_EQ(channel_.GetPendingCallNum(), 0);
+}
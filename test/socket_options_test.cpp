@@ -0,0 +1,41 @@
+#include <net/socket_options.hpp>
+
+#include "net_test.hpp"
+
+class SocketOptionsTest : public testing::Test {
+ public:
+  SocketOptionsTest() : fd_(net::NewTcpSocketFd()) {}
+  ~SocketOptionsTest() override { net::Close(fd_); }
+
+  int GetIntOption(int level, int optname) const {
+    int optval = 0;
+    socklen_t optlen = sizeof(optval);
+    ::getsockopt(fd_, level, optname, &optval, &optlen);
+    return optval;
+  }
+
+  int fd_;
+};
+
+TEST_F(SocketOptionsTest, Default) {
+  net::ApplySocketOptions(fd_, net::SocketOptions{});
+  EXPECT_EQ(GetIntOption(IPPROTO_TCP, TCP_NODELAY), 0);
+  EXPECT_EQ(GetIntOption(SOL_SOCKET, SO_KEEPALIVE), 0);
+}
+
+TEST_F(SocketOptionsTest, Apply) {
+  net::SocketOptions options;
+  options.tcp_no_delay = true;
+  options.keep_alive = true;
+  options.keep_alive_idle = 30;
+  options.keep_alive_interval = 5;
+  options.keep_alive_count = 3;
+  options.tcp_not_sent_lowat = 16384;
+  net::ApplySocketOptions(fd_, options);
+  EXPECT_NE(GetIntOption(IPPROTO_TCP, TCP_NODELAY), 0);
+  EXPECT_NE(GetIntOption(SOL_SOCKET, SO_KEEPALIVE), 0);
+  EXPECT_EQ(GetIntOption(IPPROTO_TCP, TCP_KEEPIDLE), 30);
+  EXPECT_EQ(GetIntOption(IPPROTO_TCP, TCP_KEEPINTVL), 5);
+  EXPECT_EQ(GetIntOption(IPPROTO_TCP, TCP_KEEPCNT), 3);
+  EXPECT_EQ(GetIntOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT), 16384);
+}
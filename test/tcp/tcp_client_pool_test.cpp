@@ -0,0 +1,61 @@
+#include <net/reactor/acceptor.hpp>
+#include <net/tcp/tcp_client_pool.hpp>
+
+#include "net_test.hpp"
+
+#include <set>
+
+using namespace std::chrono_literals;
+
+class TcpClientPoolTest : public testing::Test {
+ public:
+  TcpClientPoolTest() : reactor_(new net::Reactor) {}
+  ~TcpClientPoolTest() override { delete reactor_; }
+  net::Reactor *reactor_;
+};
+
+TEST_F(TcpClientPoolTest, Acquire) {
+  auto server_addr = net::InetAddress::AbstractUnix("net_tcp_client_pool_test");
+  std::vector<int> conn_fd_vec;
+  net::Acceptor acceptor(reactor_, server_addr);
+  acceptor.SetNewConnectionCallback([&](int conn_fd, const net::InetAddress &) {
+    conn_fd_vec.push_back(conn_fd);
+  });
+  acceptor.Listen();
+
+  net::ReactorPool reactor_pool(2);
+  reactor_pool.Start();
+  net::TcpClientPool client_pool(&reactor_pool, server_addr, 4);
+  EXPECT_FALSE(client_pool.Acquire());  // 启动前没有可用连接
+  client_pool.Start();
+
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });  // 防止测试卡死
+  reactor_->AddTimerEvery(10ms, [&] {
+    if (client_pool.GetConnectedNum() != client_pool.GetConnectionNum()) return;
+    {
+      // 前4次租用的连接各不相同
+      std::vector<net::TcpClientPool::Lease> lease_vec;
+      std::set<net::TcpConnection *> connection_set;
+      for (int i = 0; i < 4; ++i) {
+        lease_vec.push_back(client_pool.Acquire());
+        ASSERT_TRUE(lease_vec.back());
+        connection_set.insert(lease_vec.back().GetConnection().get());
+      }
+      EXPECT_EQ(connection_set.size(), 4);
+      // 归还一个连接后，下一次租用会选中它
+      auto released = lease_vec[2].GetConnection().get();
+      lease_vec[2].Release();
+      auto lease = client_pool.Acquire();
+      EXPECT_EQ(lease.GetConnection().get(), released);
+    }
+    reactor_->Stop();
+  });
+  reactor_->Run();
+  EXPECT_EQ(conn_fd_vec.size(), 4);
+
+  client_pool.Stop();
+  reactor_pool.Stop();
+  for (int fd: conn_fd_vec) {
+    net::Close(fd);
+  }
+}
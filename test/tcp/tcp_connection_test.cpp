@@ -0,0 +1,168 @@
+#include <net/tcp/tcp_connection.hpp>
+
+#include "net_test.hpp"
+
+#include <sys/socket.h>
+
+#include <cstdio>
+
+class TcpConnectionTest : public testing::Test {
+ public:
+  TcpConnectionTest() : reactor_(new net::Reactor) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+    conn_fd_ = fds[0];
+    peer_fd_ = fds[1];
+    conn_ = net::TcpConnection::New();
+    conn_->Init(reactor_, conn_fd_, net::InetAddress(0), net::InetAddress(0));
+  }
+  ~TcpConnectionTest() override {
+    ::close(peer_fd_);  // conn_fd_由TcpConnection负责关闭
+    delete reactor_;
+  }
+
+  /// 以非阻塞的方式读取对端收到的所有数据
+  std::string ReadPeer() const {
+    std::string s;
+    char buf[1024];
+    ssize_t n;
+    while ((n = ::recv(peer_fd_, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+      s.append(buf, n);
+    }
+    return s;
+  }
+
+  net::Reactor *reactor_;
+  net::TcpConnectionPtr conn_;
+  int conn_fd_;
+  int peer_fd_;
+};
+
+TEST_F(TcpConnectionTest, Send) {
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    conn_->Send("hello");
+    EXPECT_EQ(ReadPeer(), "hello");  // 未开启cork时直接写入
+    conn_->Send(", world");
+    EXPECT_EQ(ReadPeer(), ", world");
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(TcpConnectionTest, Cork) {
+  conn_->SetCork(true);
+  reactor_->SubmitTask([this] {
+    conn_->Establish();
+    conn_->Send("a");
+    conn_->Send("b");
+    conn_->Send("c");
+    EXPECT_EQ(ReadPeer(), "");  // 在本轮结束前不会写入
+    reactor_->AddTimerAfter(std::chrono::milliseconds(10), [this] {
+      EXPECT_EQ(ReadPeer(), "abc");
+      reactor_->Stop();
+    });
+  });
+  reactor_->Run();
+}
+
+TEST_F(TcpConnectionTest, WaterMark) {
+  std::string data(1024 * 1024, 'x');  // 远大于socket发送缓冲区，使数据堆积在输出缓冲区中
+  size_t high_pending = 0;
+  bool low_called = false;
+  std::string received;
+  conn_->SetHighWaterMarkCallback([&](const net::TcpConnectionPtr &, size_t pending) {
+    high_pending = pending;
+    // 对端开始读取数据
+    reactor_->AddTimerEvery(std::chrono::milliseconds(1), [&] { received += ReadPeer(); });
+  }, 64 * 1024);
+  conn_->SetLowWaterMarkCallback([&](const net::TcpConnectionPtr &, size_t pending) {
+    EXPECT_EQ(pending, 0);
+    low_called = true;
+  }, 0);
+  conn_->SetWriteCompleteCallback([&](const net::TcpConnectionPtr &) {
+    reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+      received += ReadPeer();
+      reactor_->Stop();
+    });
+  });
+  reactor_->SubmitTask([&] {
+    conn_->Establish();
+    conn_->Send(data);
+    EXPECT_GT(conn_->GetPendingOutputBytes(), 0);
+  });
+  reactor_->Run();
+  EXPECT_GE(high_pending, 64 * 1024);
+  EXPECT_TRUE(low_called);
+  EXPECT_EQ(received.size(), data.size());
+}
+
+TEST_F(TcpConnectionTest, SendFile) {
+  std::string content;
+  for (int i = 0; content.size() < 1024 * 1024; ++i) {  // 远大于socket发送缓冲区，文件需要排队分多次发送
+    content += std::to_string(i);
+  }
+  FILE *file = std::tmpfile();
+  ASSERT_EQ(std::fwrite(content.data(), 1, content.size(), file), content.size());
+  std::fflush(file);
+  int fd = ::fileno(file);
+  std::string expected = "head" + content.substr(1, content.size() - 2) + "middle" + content.substr(0, 3) + "tail";
+  std::string received;
+  reactor_->SubmitTask([&] {
+    conn_->Establish();
+    // 文件与Send的数据按调用的顺序发送
+    conn_->Send("head");
+    conn_->SendFile(fd, 1, content.size() - 2, nullptr);
+    conn_->Send("middle");
+    conn_->SendFile(fd, 0, 3, nullptr);
+    conn_->Send("tail");
+    reactor_->AddTimerEvery(std::chrono::milliseconds(1), [&] {
+      received += ReadPeer();
+      if (received.size() >= expected.size()) reactor_->Stop();
+    });
+    reactor_->AddTimerAfter(std::chrono::seconds(5), [&] { reactor_->Stop(); });
+  });
+  reactor_->Run();
+  EXPECT_TRUE(received == expected);
+  std::fclose(file);
+}
+
+TEST_F(TcpConnectionTest, MaxOutputBufferSize) {
+  bool closed = false;
+  conn_->SetMaxOutputBufferSize(64 * 1024);
+  conn_->SetCloseCallback([&](const net::TcpConnectionPtr &conn) {
+    closed = true;
+    conn->Destroy();
+  });
+  reactor_->SubmitTask([&] {
+    conn_->Establish();
+    conn_->Send(std::string(1024 * 1024, 'x'));
+    EXPECT_TRUE(closed);
+    EXPECT_FALSE(conn_->Connected());
+    reactor_->Stop();
+  });
+  reactor_->Run();
+}
+
+TEST_F(TcpConnectionTest, PauseReading) {
+  std::string received;
+  conn_->SetMessageCallback([&](const net::TcpConnectionPtr &, const net::BufferPtr &buffer) {
+    received += buffer->RetriveAll();
+  });
+  reactor_->SubmitTask([&] {
+    conn_->Establish();
+    conn_->PauseReading();
+    EXPECT_FALSE(conn_->IsReading());
+    ::send(peer_fd_, "hello", 5, 0);
+    reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+      EXPECT_EQ(received, "");  // 暂停期间不会读取数据
+      conn_->ResumeReading();
+      EXPECT_TRUE(conn_->IsReading());
+      reactor_->AddTimerAfter(std::chrono::milliseconds(10), [&] {
+        EXPECT_EQ(received, "hello");
+        reactor_->Stop();
+      });
+    });
+  });
+  reactor_->Run();
+}
@@ -0,0 +1,155 @@
+#include <net/udp/udp_server.hpp>
+
+#include "net_test.hpp"
+
+#include <atomic>
+
+using namespace std::chrono_literals;
+
+class UdpSocketTest : public testing::Test {
+ public:
+  UdpSocketTest() : reactor_(new net::Reactor) {}
+
+  // reactor_需要最后析构
+  std::unique_ptr<net::Reactor> reactor_;
+  net::InetAddress loopback_{"127.0.0.1", 0};
+};
+
+TEST_F(UdpSocketTest, BatchEcho) {
+  constexpr int kDatagramNum = 200;
+  net::UdpSocket server(reactor_.get(), loopback_);
+  net::UdpSocket client(reactor_.get(), loopback_);
+  server.SetMessageCallback([](net::UdpSocket *socket, std::string_view data, const net::InetAddress &peer) {
+    socket->SendTo(data, peer);
+  });
+  std::vector<std::string> received;
+  client.SetMessageCallback([&](net::UdpSocket *, std::string_view data, const net::InetAddress &peer) {
+    EXPECT_EQ(peer.GetPort(), server.GetLocalAddress().GetPort());
+    received.emplace_back(data);
+    if (received.size() == kDatagramNum) reactor_->Stop();
+  });
+  reactor_->SubmitTask([&] {
+    server.Start();
+    client.Start();
+    for (int i = 0; i < kDatagramNum; ++i) {
+      client.SendTo(std::to_string(i), server.GetLocalAddress());
+    }
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  server.Stop();
+  client.Stop();
+  ASSERT_EQ(received.size(), kDatagramNum);
+  // 回环地址上不会乱序
+  for (int i = 0; i < kDatagramNum; ++i) {
+    EXPECT_EQ(received[i], std::to_string(i));
+  }
+  EXPECT_EQ(client.GetDroppedNum(), 0);
+}
+
+TEST_F(UdpSocketTest, GsoGro) {
+  constexpr int kDatagramNum = 100;
+  net::UdpOptions server_options;
+  server_options.gro = true;
+  net::UdpOptions client_options;
+  client_options.gso = true;
+  net::UdpSocket server(reactor_.get(), loopback_, server_options);
+  net::UdpSocket client(reactor_.get(), loopback_, client_options);
+  // 无论内核是否支持GSO/GRO，接收端看到的都应该是原始的数据报
+  std::vector<size_t> sizes;
+  server.SetMessageCallback([&](net::UdpSocket *, std::string_view data, const net::InetAddress &) {
+    sizes.push_back(data.size());
+    EXPECT_EQ(data.find_first_not_of(static_cast<char>('a' + (sizes.size() - 1) % 26)), std::string_view::npos);
+    if (sizes.size() == kDatagramNum) reactor_->Stop();
+  });
+  reactor_->SubmitTask([&] {
+    server.Start();
+    client.Start();
+    for (int i = 0; i < kDatagramNum; ++i) {
+      // 每10个数据报中最后一个较短，作为GSO的最后一个分段
+      size_t size = i % 10 == 9 ? 300 : 1000;
+      client.SendTo(std::string(size, static_cast<char>('a' + i % 26)), server.GetLocalAddress());
+    }
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  server.Stop();
+  client.Stop();
+  ASSERT_EQ(sizes.size(), kDatagramNum);
+  for (int i = 0; i < kDatagramNum; ++i) {
+    EXPECT_EQ(sizes[i], i % 10 == 9 ? 300 : 1000);
+  }
+}
+
+TEST_F(UdpSocketTest, ReusePortServer) {
+  constexpr int kClientNum = 16;
+  constexpr int kDatagramNum = 20;
+  net::UdpServer server(reactor_.get(), loopback_);
+  server.SetThreadNum(4);
+  server.SetMessageCallback([](net::UdpSocket *socket, std::string_view data, const net::InetAddress &peer) {
+    EXPECT_TRUE(socket->GetReactor()->InCurrentReactorThread());
+    socket->SendTo(data, peer);
+  });
+  server.Start();
+  ASSERT_EQ(server.GetSocketNum(), 4);
+  for (size_t i = 1; i < server.GetSocketNum(); ++i) {
+    EXPECT_EQ(server.GetSocket(i)->GetLocalAddress().GetPort(), server.GetLocalAddress().GetPort());
+  }
+
+  std::vector<std::unique_ptr<net::UdpSocket>> clients;
+  int received = 0;
+  for (int i = 0; i < kClientNum; ++i) {
+    clients.push_back(std::make_unique<net::UdpSocket>(reactor_.get(), loopback_));
+    clients.back()->SetMessageCallback([&](net::UdpSocket *, std::string_view, const net::InetAddress &) {
+      if (++received == kClientNum * kDatagramNum) reactor_->Stop();
+    });
+  }
+  reactor_->SubmitTask([&] {
+    for (auto &client: clients) {
+      client->Start();
+      for (int i = 0; i < kDatagramNum; ++i) {
+        client->SendTo("ping", server.GetLocalAddress());
+      }
+    }
+  });
+  reactor_->AddTimerAfter(5s, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  for (auto &client: clients) {
+    client->Stop();
+  }
+  server.Stop();
+  EXPECT_EQ(received, kClientNum * kDatagramNum);
+}
+
+TEST_F(UdpSocketTest, SendQueueUnderBackpressure) {
+  // 回环地址上的UDP发送不会阻塞，使用Unix域数据报socket: 对端的接收队列满时发送返回EAGAIN
+  constexpr size_t kQueueSize = 64;
+  constexpr size_t kDatagramSize = 1000;
+  std::string suffix = std::to_string(::getpid());
+  net::UdpSocket receiver(reactor_.get(), net::InetAddress::AbstractUnix("net_udp_receiver_" + suffix));
+  net::UdpOptions options;
+  options.max_send_queue_size = kQueueSize;
+  net::UdpSocket sender(reactor_.get(), net::InetAddress::AbstractUnix("net_udp_sender_" + suffix), options);
+  // 每一轮发送的数据报多于对端读取的，发送队列一直处于阻塞状态
+  size_t received = 0;
+  size_t max_bytes = 0;
+  std::string data(kDatagramSize, 'x');
+  char buffer[kDatagramSize];
+  reactor_->SubmitTask([&] { sender.Start(); });
+  reactor_->AddTimerEvery(1ms, [&] {
+    for (int i = 0; i < 32; ++i) {
+      sender.SendTo(data, receiver.GetLocalAddress());
+    }
+    max_bytes = std::max(max_bytes, sender.GetSendQueueBytes());
+    for (int i = 0; i < 16 && ::recv(receiver.GetFd(), buffer, sizeof(buffer), MSG_DONTWAIT) > 0; ++i) {
+      ++received;
+    }
+  });
+  reactor_->AddTimerAfter(300ms, [this] { reactor_->Stop(); });
+  reactor_->Run();
+  sender.Stop();
+  EXPECT_GT(received, kQueueSize * 4);
+  EXPECT_GT(sender.GetDroppedNum(), 0);
+  // 已经发出的数据报被回收，缓冲区不会随发出的总量增长
+  EXPECT_LE(max_bytes, 2 * kQueueSize * kDatagramSize);
+}
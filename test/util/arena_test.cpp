@@ -0,0 +1,39 @@
+#include <net/util/arena.hpp>
+
+#include "net_test.hpp"
+
+TEST(ArenaTest, AllocateAndReset) {
+  net::Arena arena(1024);
+  EXPECT_EQ(arena.GetMemoryUsage(), 0);
+  auto s = arena.Copy("hello");
+  EXPECT_EQ(s, "hello");
+  EXPECT_EQ(arena.Concat({s, ", ", "world"}), "hello, world");
+  auto *aligned = arena.Allocate(16, 8);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 8, 0);
+  EXPECT_EQ(arena.GetMemoryUsage(), 1024);
+
+  // 较大的分配单独使用一个块，之后的小分配仍然使用当前块
+  char *large = arena.Allocate(4096);
+  memset(large, 'x', 4096);
+  EXPECT_EQ(arena.GetMemoryUsage(), 1024 + 4096 + alignof(std::max_align_t));
+  EXPECT_EQ(arena.Copy("abc"), "abc");
+
+  // 用满当前块之后分配新块
+  for (int i = 0; i < 10; ++i) {
+    arena.Allocate(200);
+  }
+  EXPECT_GT(arena.GetMemoryUsage(), 1024 + 4096 + alignof(std::max_align_t));
+
+  // Reset之后只保留第一个块
+  arena.Reset();
+  EXPECT_EQ(arena.GetMemoryUsage(), 1024);
+  EXPECT_EQ(arena.Copy("again"), "again");
+}
+
+TEST(ArenaTest, LargeFirstAllocation) {
+  net::Arena arena(256);
+  char *p = arena.Allocate(1000);
+  memset(p, 0, 1000);
+  arena.Reset();
+  EXPECT_EQ(arena.GetMemoryUsage(), 256);
+}
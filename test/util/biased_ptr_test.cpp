@@ -0,0 +1,74 @@
+#include <net/util/biased_ptr.hpp>
+
+#include "net_test.hpp"
+
+#include <thread>
+#include <vector>
+
+class BiasedPtrTest : public testing::Test {};
+
+/// 拥有者线程为创建对象的线程，提交到拥有者线程的任务保存在task_vec中，由测试手动执行
+struct Object : net::BiasedRefCounted<Object> {
+  explicit Object(bool *destroyed) : owner(std::this_thread::get_id()), destroyed(destroyed) {}
+
+  bool IsOwnerThread() const { return std::this_thread::get_id() == owner; }
+  void RunInOwnerThread(std::function<void()> &&task) { task_vec.push_back(std::move(task)); }
+  void OnRefCountZero() {
+    *destroyed = true;
+    delete this;
+  }
+
+  std::thread::id owner;
+  bool *destroyed;
+  std::vector<std::function<void()>> task_vec;
+};
+
+TEST_F(BiasedPtrTest, OwnerThread) {
+  bool destroyed = false;
+  net::BiasedPtr<Object> ptr(new Object(&destroyed));
+  {
+    auto copy = ptr;
+    auto moved = std::move(copy);
+    EXPECT_EQ(moved, ptr);
+    EXPECT_EQ(ptr->GetRefCount(), 2);
+  }
+  EXPECT_EQ(ptr->GetRefCount(), 1);
+  ptr.reset();
+  EXPECT_TRUE(destroyed);
+}
+
+TEST_F(BiasedPtrTest, CrossThread) {
+  bool destroyed = false;
+  auto *object = new Object(&destroyed);
+  net::BiasedPtr<Object> ptr(object);
+  net::BiasedPtr<Object> local_copy = ptr;
+  std::thread([&ptr, &local_copy] {
+    // 在其他线程拷贝的引用计入原子计数，可以直接释放
+    auto shared_copy = ptr;
+    EXPECT_TRUE(shared_copy);
+    // 在其他线程释放计在拥有者线程上的引用，会提交到拥有者线程执行
+    local_copy.reset();
+  }).join();
+  EXPECT_FALSE(destroyed);
+  ASSERT_EQ(object->task_vec.size(), 1);
+  auto task = std::move(object->task_vec.front());
+  object->task_vec.clear();
+  task();
+  EXPECT_FALSE(destroyed);
+  ptr.reset();
+  EXPECT_TRUE(destroyed);
+}
+
+TEST_F(BiasedPtrTest, SharedRefReleasedInOwnerThread) {
+  bool destroyed = false;
+  net::BiasedPtr<Object> ptr(new Object(&destroyed));
+  net::BiasedPtr<Object> shared_copy;
+  std::thread([&ptr, &shared_copy] {
+    shared_copy = ptr;
+  }).join();
+  ptr.reset();
+  EXPECT_FALSE(destroyed);
+  // 计入原子计数的引用在任何线程都可以直接释放
+  shared_copy.reset();
+  EXPECT_TRUE(destroyed);
+}
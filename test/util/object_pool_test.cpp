@@ -2,6 +2,7 @@
 
 #include "net_test.hpp"
 
+#include <set>
 #include <thread>
 
 class ObjectPoolTest : public testing::Test {};
@@ -78,3 +79,43 @@ TEST_F(ObjectPoolTest, TLS) {
   t1.join();
   t2.join();
 }
+
+TEST_F(ObjectPoolTest, WarmUpAndTrim) {
+  net::ObjectPool<A> pool(100);
+  EXPECT_EQ(pool.GetIdleSize(), 100);
+  auto object = pool.Get();
+  EXPECT_LT(pool.GetIdleSize(), 100);  // 本地缓存从全局仓库中批量取回了对象
+  pool.Add(object);
+  EXPECT_GT(pool.Trim(10), 0);
+  EXPECT_EQ(pool.GetIdleSize(), 10);
+  EXPECT_EQ(pool.Trim(), 10);
+  EXPECT_EQ(pool.GetIdleSize(), 0);
+}
+
+TEST_F(ObjectPoolTest, CrossThread) {
+  // 在一个线程中获取对象，在另一个线程中释放，对象会经由全局仓库回到获取对象的线程
+  net::ObjectPool<A> pool;
+  net::containers::MPMCQueue<A *> queue;
+  constexpr int kTotal = 100000;
+  std::atomic<bool> done = false;
+  std::thread consumer([&] {
+    int freed = 0;
+    A *object;
+    while (freed < kTotal) {
+      if (queue.try_dequeue(object)) {
+        pool.Add(object);
+        ++freed;
+      }
+    }
+    done = true;
+  });
+  std::set<A *> object_set;
+  for (int i = 0; i < kTotal; ++i) {
+    auto object = pool.Get();
+    object_set.insert(object);
+    queue.enqueue(object);
+  }
+  consumer.join();
+  EXPECT_TRUE(done);
+  EXPECT_LT(object_set.size(), kTotal);  // 对象得到了复用
+}
@@ -0,0 +1,58 @@
+#include <net/util/thread_local_instance.hpp>
+
+#include "net_test.hpp"
+
+#include <thread>
+
+namespace {
+
+/// 析构时递减计数，用于观察线程本地数据的生命周期
+struct Counted {
+  explicit Counted(std::shared_ptr<int> alive, int value = 0) : alive(std::move(alive)), value(value) {
+    ++*this->alive;
+  }
+  ~Counted() { --*alive; }
+
+  std::shared_ptr<int> alive;
+  int value;
+};
+
+} // namespace
+
+TEST(ThreadLocalInstanceTest, PerThread) {
+  auto alive = std::make_shared<int>(0);
+  net::ThreadLocalInstance<Counted> instance;
+  Counted &local = instance.Get(alive, 1);
+  // 只在第一次获取时构造
+  EXPECT_EQ(&instance.Get(alive, 2), &local);
+  EXPECT_EQ(local.value, 1);
+  EXPECT_EQ(*alive, 1);
+
+  // 每个线程有独立的数据，线程退出时析构
+  Counted *other = nullptr;
+  std::thread([&] {
+    other = &instance.Get(alive, 3);
+    EXPECT_EQ(other->value, 3);
+    EXPECT_EQ(*alive, 2);
+  }).join();
+  EXPECT_NE(other, &local);
+  EXPECT_EQ(*alive, 1);
+
+  // 不同的对象在同一个线程中的数据互不影响
+  net::ThreadLocalInstance<Counted> another;
+  EXPECT_NE(&another.Get(alive, 4), &local);
+  EXPECT_EQ(*alive, 2);
+}
+
+TEST(ThreadLocalInstanceTest, SweepClosed) {
+  auto alive = std::make_shared<int>(0);
+  {
+    net::ThreadLocalInstance<Counted> instance;
+    instance.Get(alive);
+  }
+  // 对象析构后，其数据在当前线程下一次创建数据时清理
+  EXPECT_EQ(*alive, 1);
+  net::ThreadLocalInstance<Counted> instance;
+  instance.Get(alive);
+  EXPECT_EQ(*alive, 1);
+}